@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "mem_accounting.h"
+
+#define ARENA_MIN_CHUNK_SIZE (64 * 1024)
+#define ARENA_MAX_CHUNK_SIZE (4 * 1024 * 1024)
+#define ARENA_ALIGNMENT sizeof(void *)
+
+// Empties the arena's bookkeeping, leaving its tag alone
+static void arena_reset(Arena *arena) {
+    arena->head = NULL;
+    arena->reserved = 0;
+    arena->used = 0;
+    arena->count = 0;
+}
+
+// Initializes an empty arena
+void arena_init(Arena *arena) {
+    arena_reset(arena);
+    arena->tag = MEM_LOAD_SCRATCH;
+}
+
+// Adds a chunk able to hold at least 'min_size' bytes.
+// Chunks double in size up to ARENA_MAX_CHUNK_SIZE so small inputs stay small.
+static ArenaChunk* arena_add_chunk(Arena *arena, size_t min_size) {
+    size_t size = arena->head ? arena->head->size * 2 : ARENA_MIN_CHUNK_SIZE;
+    if (size > ARENA_MAX_CHUNK_SIZE) size = ARENA_MAX_CHUNK_SIZE;
+    if (size < min_size) size = min_size;
+
+    ArenaChunk *chunk = (ArenaChunk *)mem_alloc((MemTag)arena->tag, sizeof(ArenaChunk) + size);
+    if (!chunk) {
+        perror("Failed to allocate arena chunk");
+        return NULL;
+    }
+    chunk->next = arena->head;
+    chunk->size = size;
+    chunk->used = 0;
+    arena->head = chunk;
+    arena->reserved += sizeof(ArenaChunk) + size;
+    return chunk;
+}
+
+// Bump-allocates 'size' bytes from the current chunk at a multiple of 'align'
+static void* arena_bump(Arena *arena, size_t size, size_t align) {
+    ArenaChunk *chunk = arena->head;
+    size_t offset = chunk ? (chunk->used + align - 1) & ~(align - 1) : 0;
+    if (!chunk || offset > chunk->size || chunk->size - offset < size) {
+        chunk = arena_add_chunk(arena, size);
+        if (!chunk) return NULL;
+        offset = 0;
+    }
+
+    void *ptr = chunk->data + offset;
+    arena->used += offset - chunk->used + size;
+    chunk->used = offset + size;
+    arena->count++;
+    return ptr;
+}
+
+// Bump-allocates 'size' bytes aligned for pointer-sized fields
+void* arena_alloc(Arena *arena, size_t size) {
+    return arena_bump(arena, size, ARENA_ALIGNMENT);
+}
+
+void* arena_alloc_bytes(Arena *arena, size_t size) {
+    return arena_bump(arena, size, 1);
+}
+
+char* arena_strdup(Arena *arena, const char *str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+// Strings need no alignment, so they are packed back to back
+char* arena_strndup(Arena *arena, const char *str, size_t len) {
+    char *copy = (char *)arena_bump(arena, len + 1, 1);
+    if (!copy) return NULL;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// Frees every chunk at once; objects inside are never freed individually
+void arena_release(Arena *arena) {
+    ArenaChunk *chunk = arena->head;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        mem_free(chunk);
+        chunk = next;
+    }
+    arena_reset(arena);
+}
+
+// The adopted chunks go behind dst's current chunk, which keeps being filled
+void arena_adopt(Arena *dst, Arena *src) {
+    if (!src->head) return;
+
+    ArenaChunk *src_tail = src->head;
+    while (src_tail->next) {
+        src_tail = src_tail->next;
+    }
+    if (dst->head) {
+        src_tail->next = dst->head->next;
+        dst->head->next = src->head;
+    } else {
+        dst->head = src->head;
+    }
+    dst->reserved += src->reserved;
+    dst->used += src->used;
+    dst->count += src->count;
+    arena_reset(src);
+}
+
+void index_arena_init(IndexArena *index_arena) {
+    for (int i = 0; i < SLAB_COUNT; i++) {
+        arena_init(&index_arena->slabs[i]);
+        index_arena->slabs[i].tag = MEM_SLAB_WORDS + i;
+    }
+}
+
+void index_arena_release(IndexArena *index_arena) {
+    for (int i = 0; i < SLAB_COUNT; i++) {
+        arena_release(&index_arena->slabs[i]);
+    }
+}
+
+void index_arena_adopt(IndexArena *dst, IndexArena *src) {
+    for (int i = 0; i < SLAB_COUNT; i++) {
+        arena_adopt(&dst->slabs[i], &src->slabs[i]);
+    }
+}
+
+const char* slab_name(SlabKind kind) {
+    static const char *names[SLAB_COUNT] = {
+        "WordInfo", "Postings", "Strings", "BST", "AVL", "Freq AVL", "Radix", "Positions"
+    };
+    return (kind >= 0 && kind < SLAB_COUNT) ? names[kind] : "?";
+}
+
+// Prints bytes reserved vs. used for each slab
+void print_index_arena_report(const IndexArena *index_arena) {
+    size_t total_reserved = 0, total_used = 0;
+
+    printf("\n--- Memória da arena do índice ---\n");
+    printf("%-14s %14s %14s %12s\n", "Slab", "Reservado (B)", "Usado (B)", "Alocações");
+    for (int i = 0; i < SLAB_COUNT; i++) {
+        const Arena *arena = &index_arena->slabs[i];
+        printf("%-14s %14zu %14zu %12zu\n", slab_name((SlabKind)i), arena->reserved, arena->used, arena->count);
+        total_reserved += arena->reserved;
+        total_used += arena->used;
+    }
+    printf("%-14s %14zu %14zu\n", "Total", total_reserved, total_used);
+
+    const Arena *positions = &index_arena->slabs[SLAB_POSITIONS];
+    if (positions->used > 0) {
+        // The label has two accented letters, which take two bytes each
+        printf("%-16s %14zu %14zu (posições: %.1f%% do usado)\n", "Sem posições", total_reserved - positions->reserved,
+               total_used - positions->used, 100.0 * positions->used / total_used);
+    }
+}
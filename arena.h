@@ -0,0 +1,82 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// --- Bump allocator ---
+
+// A chunk of memory handed out front to back by arena_alloc
+typedef struct ArenaChunk {
+  struct ArenaChunk *next; // Previously filled chunk
+  size_t size;             // Usable bytes in data
+  size_t used;             // Bytes already handed out
+  unsigned char data[];
+} ArenaChunk;
+
+// Allocates objects that all live until the arena is released
+typedef struct Arena {
+  ArenaChunk *head;  // Chunk currently being filled
+  size_t reserved;   // Bytes obtained from malloc, including chunk headers
+  size_t used;       // Bytes handed out to callers, including alignment padding
+  size_t count;      // Number of allocations served
+  int tag;           // MemTag its chunks are counted under
+} Arena;
+
+// The index keeps one slab per kind of object so nodes of a type stay together
+typedef enum SlabKind {
+  SLAB_WORDS,
+  SLAB_POSTINGS,
+  SLAB_STRINGS,
+  SLAB_BST,
+  SLAB_AVL,
+  SLAB_FREQ_AVL,
+  SLAB_RADIX,
+  SLAB_POSITIONS,
+  SLAB_COUNT
+} SlabKind;
+
+// Every object with the lifetime of the loaded index comes from here
+typedef struct IndexArena {
+  Arena slabs[SLAB_COUNT];
+} IndexArena;
+
+// Initializes an empty arena; no memory is reserved until the first allocation.
+// Its chunks count as loader buffers until a tag is set (index_arena_init sets one per slab).
+void arena_init(Arena *arena);
+
+// Returns 'size' bytes aligned for any pointer-sized field, or NULL on failure.
+void* arena_alloc(Arena *arena, size_t size);
+
+// Returns 'size' bytes with no alignment, for byte arrays packed back to back.
+void* arena_alloc_bytes(Arena *arena, size_t size);
+
+// Copies a NUL-terminated string into the arena.
+char* arena_strdup(Arena *arena, const char *str);
+
+// Copies 'len' bytes into the arena and terminates them with NUL.
+char* arena_strndup(Arena *arena, const char *str, size_t len);
+
+// Frees every chunk of the arena at once and resets it, keeping its tag.
+void arena_release(Arena *arena);
+
+// Moves every chunk of 'src' into 'dst' without copying and resets 'src'.
+// Used to hand objects built on worker threads over to the index.
+void arena_adopt(Arena *dst, Arena *src);
+
+// Initializes all slabs of an IndexArena, each counted under the MemTag of its slab.
+void index_arena_init(IndexArena *index_arena);
+
+// Frees every slab of an IndexArena.
+void index_arena_release(IndexArena *index_arena);
+
+// Moves every slab of 'src' into the matching slab of 'dst'.
+void index_arena_adopt(IndexArena *dst, IndexArena *src);
+
+// Returns the display name of a slab.
+const char* slab_name(SlabKind kind);
+
+// Prints bytes reserved vs. used for each slab, and the totals without the positions slab
+// when the index recorded positions.
+void print_index_arena_report(const IndexArena *index_arena);
+
+#endif // ARENA_H
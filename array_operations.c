@@ -2,126 +2,413 @@
 #include <stdlib.h>
 #include <string.h>
 #include "array_operations.h"
-#include "word_processing.h" // For create_word_info, add_citation_to_word, free_word_info
+#include "word_processing.h" // For create_word_info
+#include "posting_operations.h"
+#include "mem_accounting.h"
 
-// Initializes a WordVector
-void init_vector(WordVector *vec, int initial_capacity) {
-    vec->words = (WordInfo **)malloc(initial_capacity * sizeof(WordInfo *));
-    if (!vec->words) {
-        perror("Failed to allocate vector");
-        exit(EXIT_FAILURE);
+// --- Bulk Build ---
+
+#define RADIX_INSERTION_CUTOFF 32
+
+int append_occurrence(OccurrenceList *list, const char *word, int length, int quote_id, int position) {
+    if (list->count >= list->capacity) {
+        size_t new_capacity = list->capacity ? list->capacity * 2 : 4096;
+        WordOccurrence *new_items = (WordOccurrence *)mem_realloc(MEM_LOAD_SCRATCH, list->items,
+                                                                  new_capacity * sizeof(WordOccurrence));
+        if (!new_items) {
+            perror("Failed to resize occurrence list");
+            return 0;
+        }
+        list->items = new_items;
+        list->capacity = new_capacity;
     }
-    vec->size = 0;
-    vec->capacity = initial_capacity;
+    WordOccurrence *occ = &list->items[list->count];
+    occ->word = word;
+    occ->length = length;
+    occ->quote_id = quote_id;
+    occ->position = position;
+    occ->seq = list->count;
+    list->count++;
+    return 1;
 }
 
-// Helper function to resize the vector
-static int resize_vector(WordVector *vec) {
-    int new_capacity = vec->capacity * 2;
-    WordInfo **new_words = (WordInfo **)realloc(vec->words, new_capacity * sizeof(WordInfo *));
-    if (!new_words) {
-        perror("Failed to resize vector");
-        return 0; // Failure
+// Compares two word views from 'depth' on, with strcmp ordering
+static int compare_occurrences(const WordOccurrence *a, const WordOccurrence *b, size_t depth) {
+    size_t len_a = (size_t)a->length - depth;
+    size_t len_b = (size_t)b->length - depth;
+    int cmp = memcmp(a->word + depth, b->word + depth, len_a < len_b ? len_a : len_b);
+    if (cmp != 0) return cmp;
+    return (len_a > len_b) - (len_a < len_b);
+}
+
+// Byte of the word at 'depth', or 0 once the word has ended
+static inline unsigned char occurrence_byte(const WordOccurrence *occ, size_t depth) {
+    return depth < (size_t)occ->length ? (unsigned char)occ->word[depth] : 0;
+}
+
+// Stable insertion sort on the suffixes starting at 'depth' (all prefixes are equal)
+static void insertion_sort_occurrences(WordOccurrence *items, size_t count, size_t depth) {
+    for (size_t i = 1; i < count; i++) {
+        WordOccurrence key = items[i];
+        size_t j = i;
+        while (j > 0 && compare_occurrences(&items[j - 1], &key, depth) > 0) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = key;
     }
-    vec->words = new_words;
-    vec->capacity = new_capacity;
-    return 1; // Success
 }
 
-// Inserts WordInfo into the sorted vector. Handles duplicates.
-// Returns pointer to WordInfo in vector
-WordInfo* insert_sorted_vector(WordVector *vec, const char *word, const char *quote, const char *movie, int year) {
-    // --- Binary search to find position or existing word ---
-    int low = 0, high = vec->size - 1;
-    int mid;
-    int cmp = -1; // Initialize cmp to handle empty vector case correctly
-    int found_index = -1;
+// MSD radix sort on the byte at 'depth'. Distribution through 'aux' keeps equal
+// keys in their original order, which is what makes the whole sort stable.
+static void msd_radix_sort(WordOccurrence *items, WordOccurrence *aux, size_t count, size_t depth) {
+    if (count <= RADIX_INSERTION_CUTOFF) {
+        insertion_sort_occurrences(items, count, depth);
+        return;
+    }
 
-    while (low <= high) {
-        mid = low + (high - low) / 2; // Avoid overflow
-        cmp = strcmp(word, vec->words[mid]->word);
+    size_t bucket_start[257] = {0};
+    for (size_t i = 0; i < count; i++) {
+        bucket_start[occurrence_byte(&items[i], depth) + 1]++;
+    }
+    for (int b = 1; b < 257; b++) {
+        bucket_start[b] += bucket_start[b - 1];
+    }
 
-        if (cmp == 0) {
-            // Word found
-            found_index = mid;
-            break;
-        } else if (cmp < 0) {
-            high = mid - 1;
-        } else {
-            low = mid + 1;
+    size_t next[256];
+    memcpy(next, bucket_start, sizeof(next));
+    for (size_t i = 0; i < count; i++) {
+        aux[next[occurrence_byte(&items[i], depth)]++] = items[i];
+    }
+    memcpy(items, aux, count * sizeof(WordOccurrence));
+
+    // Bucket 0 holds words that end here; they are all equal and already in input order
+    for (int b = 1; b < 256; b++) {
+        size_t size = bucket_start[b + 1] - bucket_start[b];
+        if (size > 1) {
+            msd_radix_sort(items + bucket_start[b], aux, size, depth + 1);
         }
     }
+}
+
+void sort_occurrences(WordOccurrence *items, size_t count) {
+    if (count < 2) return;
+    WordOccurrence *aux = (WordOccurrence *)mem_alloc(MEM_LOAD_SCRATCH, count * sizeof(WordOccurrence));
+    if (!aux) {
+        // Without scratch space fall back to the in-place stable sort
+        perror("Failed to allocate radix sort buffer");
+        insertion_sort_occurrences(items, count, 0);
+        return;
+    }
+    msd_radix_sort(items, aux, count, 0);
+    mem_free(aux);
+}
+
+void free_occurrence_list(OccurrenceList *list) {
+    if (list) {
+        mem_free(list->items);
+        list->items = NULL;
+        list->count = 0;
+        list->capacity = 0;
+    }
+}
+
+// --- Chunk Vocabularies ---
+
+// Compares two words given as views, with strcmp ordering
+static int compare_views(const char *a, int len_a, const char *b, int len_b) {
+    int cmp = memcmp(a, b, len_a < len_b ? len_a : len_b);
+    if (cmp != 0) return cmp;
+    return (len_a > len_b) - (len_a < len_b);
+}
+
+int collapse_occurrences(OccurrenceList *list, int quote_base, int positions, IndexArena *arena,
+                         LocalVocabulary *vocabulary, int *token_entries) {
+    vocabulary->words = NULL;
+    vocabulary->size = 0;
+    vocabulary->merged = NULL;
+    sort_occurrences(list->items, list->count);
+
+    // Every run becomes one word, so the occurrence count bounds the vocabulary size
+    LocalWord *words = (LocalWord *)mem_alloc(MEM_LOAD_SCRATCH, (list->count ? list->count : 1) * sizeof(LocalWord));
+    if (!words) {
+        perror("Failed to allocate local vocabulary");
+        return 0;
+    }
 
-    // --- Handle insertion or update ---
-    WordInfo *target_info;
-
-    if (found_index != -1) {
-        // Word exists, update frequency and add citation
-        target_info = vec->words[found_index];
-        target_info->frequency++;
-        add_citation_to_word(target_info, quote, movie, year);
-    } else {
-        // Word not found, insert in sorted order
-        if (vec->size >= vec->capacity) {
-            if (!resize_vector(vec)) {
-                fprintf(stderr, "Error: Could not resize vector, skipping insertion of '%s'\n", word);
-                return NULL; // Indicate failure
+    int size = 0;
+    size_t i = 0;
+    while (i < list->count) {
+        const WordOccurrence *first = &list->items[i];
+        LocalWord *local = &words[size];
+        local->word = first->word;
+        local->length = first->length;
+        local->frequency = 0;
+
+        // Occurrences of the word are in input order, so quote IDs never decrease and the
+        // positions within a quote increase. A first pass sizes the encoded lists so the
+        // second one never has to grow them.
+        size_t run_end = i;
+        int bytes = 0, position_bytes = 0, previous = -1, term_count = 0, last_position = 0;
+        while (run_end < list->count && compare_occurrences(&list->items[run_end], first, 0) == 0) {
+            const WordOccurrence *occ = &list->items[run_end];
+            int quote_id = quote_base + occ->quote_id;
+            if (quote_id != previous) {
+                if (previous >= 0) bytes += varint_size(term_count);
+                bytes += varint_size(previous < 0 ? (unsigned)quote_id : (unsigned)(quote_id - previous));
+                previous = quote_id;
+                term_count = 0;
+                last_position = 0;
+            }
+            position_bytes += varint_size((unsigned)(occ->position - last_position));
+            last_position = occ->position;
+            term_count++;
+            run_end++;
+        }
+        bytes += varint_size(term_count);
+        if (!init_posting_list(&local->postings, bytes, &arena->slabs[SLAB_POSTINGS]) ||
+            !init_position_list(&local->positions, positions ? position_bytes : 0, &arena->slabs[SLAB_POSITIONS])) {
+            mem_free(words);
+            return 0;
+        }
+        previous = -1;
+        for (size_t j = i; j < run_end; j++) {
+            const WordOccurrence *occ = &list->items[j];
+            const int quote_id = quote_base + occ->quote_id;
+            if (!add_posting(&local->postings, quote_id, &arena->slabs[SLAB_POSTINGS])) {
+                mem_free(words);
+                return 0;
+            }
+            if (positions) {
+                const int previous_position = quote_id == previous ? list->items[j - 1].position : -1;
+                if (!add_position(&local->positions, occ->position, previous_position, &arena->slabs[SLAB_POSITIONS])) {
+                    mem_free(words);
+                    return 0;
+                }
+                previous = quote_id;
+            }
+            local->frequency++;
+            if (token_entries) {
+                token_entries[occ->seq] = size;
             }
         }
 
-        // The correct insertion index is 'low' (where the search ended)
-        int insert_pos = low;
+        size++; // Runs come out in sorted order
+        i = run_end;
+    }
+
+    vocabulary->words = words;
+    vocabulary->size = size;
+    vocabulary->merged = (WordInfo **)mem_alloc(MEM_LOAD_SCRATCH, (size ? size : 1) * sizeof(WordInfo *));
+    if (!vocabulary->merged) {
+        perror("Failed to allocate local vocabulary");
+        free_local_vocabulary(vocabulary);
+        return 0;
+    }
+    return 1;
+}
+
+// First word of the vocabulary that is not smaller than 'key' (size if there is none)
+static int lower_bound_local(const LocalVocabulary *vocabulary, const LocalWord *key) {
+    int low = 0, high = vocabulary->size;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        const LocalWord *word = &vocabulary->words[mid];
+        if (compare_views(word->word, word->length, key->word, key->length) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Cursor of one chunk during the merge
+typedef struct MergeCursor {
+    int chunk;
+    int position;
+    int end;
+} MergeCursor;
+
+// Orders cursors by their current word, then by chunk so equal words pop oldest chunk first
+static int cursor_less(const LocalVocabulary *vocabularies, const MergeCursor *a, const MergeCursor *b) {
+    const LocalWord *wa = &vocabularies[a->chunk].words[a->position];
+    const LocalWord *wb = &vocabularies[b->chunk].words[b->position];
+    int cmp = compare_views(wa->word, wa->length, wb->word, wb->length);
+    return cmp < 0 || (cmp == 0 && a->chunk < b->chunk);
+}
+
+static void sift_down_cursors(const LocalVocabulary *vocabularies, MergeCursor *heap, int size, int i) {
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && cursor_less(vocabularies, &heap[left], &heap[smallest])) smallest = left;
+        if (right < size && cursor_less(vocabularies, &heap[right], &heap[smallest])) smallest = right;
+        if (smallest == i) return;
+        MergeCursor tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+int merge_local_vocabularies(LocalVocabulary *vocabularies, int count, const LocalWord *low, const LocalWord *high,
+                             IndexArena *arena, WordInfo ***out, int *out_size) {
+    *out = NULL;
+    *out_size = 0;
+
+    MergeCursor *heap = (MergeCursor *)malloc((count ? count : 1) * sizeof(MergeCursor));
+    const LocalWord **holders = (const LocalWord **)malloc((count ? count : 1) * sizeof(LocalWord *));
+    if (!heap || !holders) {
+        perror("Failed to allocate merge heap");
+        free(heap);
+        free(holders);
+        return 0;
+    }
+
+    // Each chunk contributes the slice of its vocabulary that falls in [low, high)
+    int heap_size = 0, upper_bound = 0;
+    for (int c = 0; c < count; c++) {
+        int start = low ? lower_bound_local(&vocabularies[c], low) : 0;
+        int end = high ? lower_bound_local(&vocabularies[c], high) : vocabularies[c].size;
+        if (start < end) {
+            heap[heap_size].chunk = c;
+            heap[heap_size].position = start;
+            heap[heap_size].end = end;
+            heap_size++;
+            upper_bound += end - start;
+        }
+    }
+    for (int i = heap_size / 2 - 1; i >= 0; i--) {
+        sift_down_cursors(vocabularies, heap, heap_size, i);
+    }
+
+    WordInfo **words = (WordInfo **)mem_alloc(MEM_LOAD_SCRATCH, (upper_bound ? upper_bound : 1) * sizeof(WordInfo *));
+    if (!words) {
+        perror("Failed to allocate merged words");
+        free(heap);
+        free(holders);
+        return 0;
+    }
+
+    int size = 0;
+    while (heap_size > 0) {
+        const LocalWord *smallest = &vocabularies[heap[0].chunk].words[heap[0].position];
+        WordInfo *info = create_word_info(smallest->word, smallest->length, arena);
+        if (!info) {
+            free(heap);
+            free(holders);
+            mem_free(words);
+            return 0;
+        }
+
+        // Pop every chunk holding this word, oldest chunk first
+        int holder_count = 0, bytes = 0, position_bytes = 0;
+        for (;;) {
+            MergeCursor *top = &heap[0];
+            LocalWord *local = &vocabularies[top->chunk].words[top->position];
+            if (compare_views(local->word, local->length, info->word, smallest->length) != 0) {
+                break;
+            }
+            holders[holder_count++] = local;
+            bytes += local->postings.length;
+            position_bytes += local->positions.length;
+            info->frequency += local->frequency;
+            vocabularies[top->chunk].merged[top->position] = info;
 
-        // Shift elements to make space
-        for (int i = vec->size; i > insert_pos; i--) {
-            vec->words[i] = vec->words[i - 1];
+            if (++top->position == top->end) {
+                heap[0] = heap[--heap_size];
+            }
+            if (heap_size == 0) break;
+            sift_down_cursors(vocabularies, heap, heap_size, 0);
         }
 
-        // Create new WordInfo
-        target_info = create_word_info(word);
-        if (!target_info) {
-             fprintf(stderr, "Error: Could not create WordInfo for '%s', skipping insertion.\n", word);
-             // Shift back if needed? No, just don't increment size.
-             return NULL; // Indicate failure
+        // Chunks cover consecutive quote IDs, so their lists are concatenated in chunk order.
+        // A word found in a single chunk keeps that chunk's list as is.
+        if (holder_count == 1) {
+            info->postings = holders[0]->postings;
+            info->positions = holders[0]->positions;
+        } else {
+            int ok = init_posting_list(&info->postings, bytes, &arena->slabs[SLAB_POSTINGS]) &&
+                     init_position_list(&info->positions, position_bytes, &arena->slabs[SLAB_POSITIONS]);
+            for (int h = 0; h < holder_count && ok; h++) {
+                ok = append_posting_list(&info->postings, &holders[h]->postings, &arena->slabs[SLAB_POSTINGS]) &&
+                     append_position_list(&info->positions, &holders[h]->positions, &arena->slabs[SLAB_POSITIONS]);
+            }
+            if (!ok) {
+                free(heap);
+                free(holders);
+                mem_free(words);
+                return 0;
+            }
         }
-        target_info->frequency = 1; // First occurrence
-        add_citation_to_word(target_info, quote, movie, year);
 
-        // Insert the new WordInfo pointer
-        vec->words[insert_pos] = target_info;
-        vec->size++;
+        words[size++] = info;
     }
-    return target_info; // Return pointer to the WordInfo in the vector
+
+    free(heap);
+    free(holders);
+    *out = words;
+    *out_size = size;
+    return 1;
 }
 
+void free_local_vocabulary(LocalVocabulary *vocabulary) {
+    if (vocabulary) {
+        mem_free(vocabulary->words);
+        mem_free(vocabulary->merged);
+        vocabulary->words = NULL;
+        vocabulary->merged = NULL;
+        vocabulary->size = 0;
+    }
+}
 
 // Searches for a word in the vector using binary search.
-WordInfo* search_vector(const WordVector *vec, const char *word) {
+int search_vector_position(const WordVector *vec, const char *word) {
     int low = 0, high = vec->size - 1;
     while (low <= high) {
         int mid = low + (high - low) / 2;
         int cmp = strcmp(word, vec->words[mid]->word);
         if (cmp == 0) {
-            return vec->words[mid]; // Found
+            return mid; // Found
         } else if (cmp < 0) {
             high = mid - 1;
         } else {
             low = mid + 1;
         }
     }
-    return NULL; // Not found
+    return -1; // Not found
 }
 
-// Frees the memory used by the WordVector
-// IMPORTANT: This assumes the vector OWNS the WordInfo structures.
+WordInfo* search_vector(const WordVector *vec, const char *word) {
+    int position = search_vector_position(vec, word);
+    return position >= 0 ? vec->words[position] : NULL;
+}
+
+// Words with the prefix are contiguous: the range starts at the first word >= prefix and ends at
+// the first word whose leading characters compare greater than the prefix
+int prefix_range_vector(const WordVector *vec, const char *prefix, int *first) {
+    size_t length = strlen(prefix);
+    int low = 0, high = vec->size;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strcmp(vec->words[mid]->word, prefix) < 0) low = mid + 1;
+        else high = mid;
+    }
+    *first = low;
+    high = vec->size;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strncmp(vec->words[mid]->word, prefix, length) <= 0) low = mid + 1;
+        else high = mid;
+    }
+    return low - *first;
+}
+
+// Frees the pointer array of the WordVector
+// IMPORTANT: The WordInfo structures live in the index arena and are freed with it.
 void free_vector(WordVector *vec) {
     if (vec && vec->words) {
-        for (int i = 0; i < vec->size; i++) {
-            if (vec->words[i]) {
-                free_word_info(vec->words[i]); // Free the WordInfo struct and its contents
-            }
-        }
-        free(vec->words); // Free the array of pointers
+        mem_free(vec->words); // Free the array of pointers
         vec->words = NULL;
         vec->size = 0;
         vec->capacity = 0;
@@ -2,19 +2,54 @@
 #define ARRAY_OPERATIONS_H
 
 #include "structures.h"
+#include "arena.h"
 
-// Initializes a WordVector
-void init_vector(WordVector *vec, int initial_capacity);
+// Appends a (word, quote) pair to the list gathered during parsing, with the position of
+// the token in the quote. The word is a 'length'-byte view that must stay valid until the
+// vector is built. Returns 1 on success.
+int append_occurrence(OccurrenceList *list, const char *word, int length, int quote_id, int position);
 
-// Inserts WordInfo into the sorted vector. Handles duplicates (increments frequency).
-// Returns a pointer to the (potentially new) WordInfo struct in the vector.
-WordInfo* insert_sorted_vector(WordVector *vec, const char *word, const char *quote, const char *movie, int year);
+// Sorts occurrences by word with a stable MSD radix sort, so occurrences of the same
+// word keep their input order.
+void sort_occurrences(WordOccurrence *items, size_t count);
+
+// Frees the occurrence array (not the words it points to).
+void free_occurrence_list(OccurrenceList *list);
+
+// Sorts the occurrences of one input chunk and collapses each run of equal words into
+// a LocalWord in a single pass. Quote IDs are translated to index IDs with
+// quote_base + quote_id; posting lists come from the given arena, and so do the position
+// lists when 'positions' is set (they are left empty otherwise).
+// If token_entries is not NULL, token_entries[seq] receives the local word of each occurrence.
+// Returns 1 on success, 0 on allocation failure.
+int collapse_occurrences(OccurrenceList *list, int quote_base, int positions, IndexArena *arena,
+                         LocalVocabulary *vocabulary, int *token_entries);
+
+// Merges the words in [low, high) of the local vocabularies of consecutive input chunks
+// into new WordInfo entries, written in sorted order to a malloc'd array in *out.
+// low/high may be NULL for an open range. Frequencies are added up and posting and
+// position lists are concatenated in chunk order, so the result is identical to loading the chunks
+// one after the other. Also fills vocabularies[c].merged for every word in the range.
+// Returns 1 on success, 0 on allocation failure.
+int merge_local_vocabularies(LocalVocabulary *vocabularies, int count, const LocalWord *low, const LocalWord *high,
+                             IndexArena *arena, WordInfo ***out, int *out_size);
+
+// Frees the arrays of a local vocabulary (not the posting lists).
+void free_local_vocabulary(LocalVocabulary *vocabulary);
 
 // Searches for a word in the vector using binary search.
 // Returns a pointer to the WordInfo if found, NULL otherwise.
 WordInfo* search_vector(const WordVector *vec, const char *word);
 
-// Frees the memory used by the WordVector, including the WordInfo structs it owns.
+// Same binary search, returning the position of the word in the vector, or -1 if it is absent.
+int search_vector_position(const WordVector *vec, const char *word);
+
+// Finds the words that start with 'prefix' with two binary searches: they are
+// vec->words[*first ..]. Returns how many there are.
+int prefix_range_vector(const WordVector *vec, const char *prefix, int *first);
+
+// Frees the pointer array of the WordVector.
+// The WordInfo structs belong to the index arena and are released with it.
 void free_vector(WordVector *vec);
 
 #endif // ARRAY_OPERATIONS_H
\ No newline at end of file
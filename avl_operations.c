@@ -19,8 +19,8 @@ static int max_avl(int a, int b) {
 }
 
 // Create a new AVL node
-static AVLNode* create_avl_node(WordInfo *wordInfo) {
-    AVLNode* node = (AVLNode*)malloc(sizeof(AVLNode));
+static AVLNode* create_avl_node(WordInfo *wordInfo, IndexArena *arena) {
+    AVLNode* node = (AVLNode*)arena_alloc(&arena->slabs[SLAB_AVL], sizeof(AVLNode));
     if (!node) {
         perror("Failed to allocate AVL node");
         return NULL;
@@ -76,22 +76,22 @@ static int get_balance_avl(AVLNode *N) {
 // --- AVL Insertion ---
 
 // Inserts a WordInfo pointer into the AVL tree (Recursive)
-AVLNode* insert_avl(AVLNode *node, WordInfo *wordInfo, const char *quote, const char *movie, int year) {
+AVLNode* insert_avl(AVLNode *node, WordInfo *wordInfo, IndexArena *arena) {
     // 1. Perform the normal BST insertion
     if (node == NULL) {
         // WordInfo should already exist (created by vector insert)
         if (!wordInfo) return NULL;
          // Frequency/citation handled by vector insert.
-        return(create_avl_node(wordInfo));
+        return(create_avl_node(wordInfo, arena));
     }
 
 
     int cmp = strcmp(wordInfo->word, node->data->word);
 
     if (cmp < 0)
-        node->left = insert_avl(node->left, wordInfo, quote, movie, year);
+        node->left = insert_avl(node->left, wordInfo, arena);
     else if (cmp > 0)
-        node->right = insert_avl(node->right, wordInfo, quote, movie, year);
+        node->right = insert_avl(node->right, wordInfo, arena);
     else {
         // Duplicate word found in AVL tree node.
         // Actual frequency/citation update happened in vector.
@@ -132,6 +132,28 @@ AVLNode* insert_avl(AVLNode *node, WordInfo *wordInfo, const char *quote, const
     return node;
 }
 
+// --- AVL Bulk Build ---
+
+// Builds the subtree for words[low..high], rooted at the middle word.
+// Both halves differ in size by at most one, so no rotation is ever needed.
+static AVLNode* build_avl_range(WordInfo **words, int low, int high, IndexArena *arena) {
+    if (low > high) return NULL;
+
+    int mid = low + (high - low) / 2;
+    AVLNode *node = create_avl_node(words[mid], arena);
+    if (!node) return NULL;
+    node->left = build_avl_range(words, low, mid - 1, arena);
+    node->right = build_avl_range(words, mid + 1, high, arena);
+    node->height = 1 + max_avl(height_avl(node->left), height_avl(node->right));
+    return node;
+}
+
+// Builds a perfectly balanced AVL tree from the sorted vector (each word visited once)
+AVLNode* build_avl_from_sorted_vector(const WordVector *vec, IndexArena *arena) {
+    if (!vec || vec->size == 0) return NULL;
+    return build_avl_range(vec->words, 0, vec->size - 1, arena);
+}
+
 // --- AVL Search ---
 
 // Searches for a word in the AVL tree (Recursive - same as BST search)
@@ -150,15 +172,3 @@ WordInfo* search_avl(AVLNode *root, const char *word) {
         return search_avl(root->right, word);
     }
 }
-
-// --- AVL Free ---
-
-// Frees the memory allocated for the AVL tree nodes (not the WordInfo structs).
-void free_avl(AVLNode *root) {
-     if (root != NULL) {
-        free_avl(root->left);
-        free_avl(root->right);
-        // IMPORTANT: Only free the node, not root->data (WordInfo)
-        free(root);
-    }
-}
\ No newline at end of file
@@ -2,18 +2,20 @@
 #define AVL_OPERATIONS_H
 
 #include "structures.h"
+#include "arena.h"
 
 // Inserts a WordInfo pointer into the AVL Tree.
 // Does NOT duplicate WordInfo, assumes pointer is valid and managed elsewhere.
 // Updates frequency and citations if word already exists (indirectly via vector).
-// Balances the tree as needed.
-AVLNode* insert_avl(AVLNode *node, WordInfo *wordInfo, const char *quote, const char *movie, int year);
+// Balances the tree as needed. New nodes are allocated from the AVL slab of the index arena.
+AVLNode* insert_avl(AVLNode *node, WordInfo *wordInfo, IndexArena *arena);
+
+// Builds a perfectly balanced AVL tree over the sorted vector in O(n), with correct heights.
+// Nodes are allocated from the AVL slab of the index arena.
+AVLNode* build_avl_from_sorted_vector(const WordVector *vec, IndexArena *arena);
 
 // Searches for a word in the AVL tree.
 // Returns a pointer to the WordInfo if found, NULL otherwise.
 WordInfo* search_avl(AVLNode *root, const char *word);
 
-// Frees the memory allocated for the AVL tree nodes (not the WordInfo structs).
-void free_avl(AVLNode *root);
-
 #endif // AVL_OPERATIONS_H
\ No newline at end of file
@@ -0,0 +1,746 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "structures.h"
+#include "file_parser.h"
+#include "array_operations.h"
+#include "eytzinger_operations.h"
+#include "hash_operations.h"
+#include "freq_avl_operations.h"
+#include "radix_operations.h"
+#include "boolean_operations.h"
+#include "ranking_operations.h"
+#include "quote_pool.h"
+#include "query_operations.h"
+#include "arena.h"
+#include "utils.h"
+
+#define BENCH_WORD_MAX 32           // Synthetic words stay far below this
+#define BENCH_LINE_MAX 1024
+#define BENCH_OUTPUT_BUFFER (1 << 20)
+#define BENCH_MAX_RESULTS 1024
+#define BENCH_COMPLETIONS 10
+
+// Two-letter syllables the synthetic words are spelled with
+static const char *syllables[] = {
+    "ka", "lo", "mi", "ne", "ru", "sa", "to", "vi", "de", "fa",
+    "go", "hu", "ja", "be", "po", "ri", "se", "tu", "wo", "za"
+};
+#define SYLLABLE_COUNT ((int)(sizeof(syllables) / sizeof(syllables[0])))
+
+// Words of the word lookups: the hits are drawn with the corpus' Zipf weights, the misses
+// are spelled like corpus words but lie outside the vocabulary.
+static const QueryStructure lookup_structures[] = {
+    QUERY_VECTOR, QUERY_EYTZINGER, QUERY_BST, QUERY_AVL, QUERY_HASH
+};
+#define LOOKUP_STRUCTURE_COUNT ((int)(sizeof(lookup_structures) / sizeof(lookup_structures[0])))
+
+// One measured operation on one corpus; times are per operation
+typedef struct BenchResult {
+    long lines;
+    size_t bytes;
+    int words;            // Distinct words in the loaded index
+    const char *operation;
+    const char *target;
+    int repetitions;
+    long ops;             // Operations per repetition
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+    double max_ns;
+    double examined;      // Candidates examined per operation, where the operation counts them (else 0)
+} BenchResult;
+
+// Index built from one corpus, owned by the benchmark
+typedef struct BenchIndex {
+    IndexArena arena;
+    QuotePool pool;
+    WordVector vector;
+    BSTNode *bst;
+    AVLNode *avl;
+    HashIndex hash;
+    EytzingerIndex eytzinger;
+    FreqAVLNode *freq_avl;
+    RadixNode *radix;
+    FreqOrder freq_order;
+    YearCounts year_counts;
+    QuoteIdLists quote_ids;
+} BenchIndex;
+
+static double next_uniform(unsigned long long *state) {
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+}
+
+// Spells the word of a rank: its base-20 digits as syllables, at least two of them, so every
+// rank gets a distinct word of 4+ letters that normalize_word keeps as is.
+static int synthetic_word(unsigned long rank, char *buffer) {
+    char digits[16];
+    int count = 0;
+    do {
+        digits[count++] = (char)(rank % SYLLABLE_COUNT);
+        rank /= SYLLABLE_COUNT;
+    } while (rank > 0 || count < 2);
+
+    int length = 0;
+    while (count > 0) {
+        const char *syllable = syllables[(int)digits[--count]];
+        buffer[length++] = syllable[0];
+        buffer[length++] = syllable[1];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+// Cumulative Zipf weights of ranks 1..vocabulary, normalized to end at 1
+static double* build_zipf_cdf(int vocabulary, double exponent) {
+    double *cdf = (double *)malloc(vocabulary * sizeof(double));
+    if (!cdf) {
+        perror("Falha ao alocar a distribuição de Zipf");
+        return NULL;
+    }
+    double total = 0.0;
+    for (int r = 0; r < vocabulary; r++) {
+        total += 1.0 / pow(r + 1, exponent);
+        cdf[r] = total;
+    }
+    for (int r = 0; r < vocabulary; r++) {
+        cdf[r] /= total;
+    }
+    return cdf;
+}
+
+// Draws a rank (0-based) by binary search over the cumulative weights
+static int draw_zipf_rank(const double *cdf, int vocabulary, unsigned long long *state) {
+    const double u = next_uniform(state);
+    int low = 0, high = vocabulary - 1;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (cdf[mid] <= u) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+int generate_zipf_corpus(const char *filename, long lines, int vocabulary, double zipf_exponent,
+                         unsigned long long seed) {
+    if (lines <= 0 || vocabulary <= 0) {
+        fprintf(stderr, "Erro: o corpus precisa de pelo menos uma linha e uma palavra.\n");
+        return 0;
+    }
+    double *cdf = build_zipf_cdf(vocabulary, zipf_exponent);
+    if (!cdf) return 0;
+
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        perror("Falha ao criar o corpus");
+        free(cdf);
+        return 0;
+    }
+    setvbuf(out, NULL, _IOFBF, BENCH_OUTPUT_BUFFER);
+
+    static const char endings[] = ".!?";
+    const long movies = lines / 40 > 0 ? lines / 40 : 1;
+    unsigned long long state = seed;
+    char line[BENCH_LINE_MAX];
+    for (long l = 0; l < lines; l++) {
+        // "Quote words...","Synthetic Movie N","YEAR" - the layout of movie_quotes.csv
+        int length = 0;
+        line[length++] = '"';
+        const int word_count = 4 + (int)(next_random(&state) % 12);
+        for (int w = 0; w < word_count; w++) {
+            if (w > 0) line[length++] = ' ';
+            const int start = length;
+            length += synthetic_word((unsigned long)draw_zipf_rank(cdf, vocabulary, &state), line + length);
+            if (w == 0) line[start] -= 'a' - 'A';
+            if (w + 1 < word_count && next_random(&state) % 8 == 0) line[length++] = ',';
+        }
+        line[length++] = endings[next_random(&state) % 3];
+        const long movie = (long)(next_random(&state) % (unsigned long long)movies);
+        length += snprintf(line + length, sizeof(line) - length, "\",\"Synthetic Movie %ld\",\"%ld\"\n", movie,
+                           1930 + movie % 90);
+        fwrite(line, 1, length, out);
+    }
+
+    free(cdf);
+    if (fclose(out) != 0) {
+        perror("Falha ao gravar o corpus");
+        return 0;
+    }
+    return 1;
+}
+
+void init_benchmark_options(BenchmarkOptions *options) {
+    memset(options, 0, sizeof(*options));
+    options->sizes[0] = 10000;
+    options->sizes[1] = 100000;
+    options->sizes[2] = 1000000;
+    options->size_count = 3;
+    options->vocabulary = 50000;
+    options->zipf_exponent = 1.0;
+    options->seed = 42;
+    options->load_repetitions = 3;
+    options->repetitions = 20;
+    options->lookups = 100000;
+    options->corpus_dir = ".";
+    options->csv_file = "benchmark.csv";
+}
+
+// Parses "10000,100000,1e6" into the size list
+static int parse_sizes(const char *text, BenchmarkOptions *options) {
+    options->size_count = 0;
+    while (*text) {
+        char *end;
+        const double size = strtod(text, &end);
+        if (end == text || size < 1 || options->size_count == BENCH_MAX_SIZES) return 0;
+        options->sizes[options->size_count++] = (long)size;
+        if (*end == ',') end++;
+        else if (*end != '\0') return 0;
+        text = end;
+    }
+    return options->size_count > 0;
+}
+
+int parse_benchmark_option(int argc, char *argv[], int *i, BenchmarkOptions *options) {
+    const char *option = argv[*i];
+    if (strcmp(option, "--bench-keep") == 0) {
+        options->keep_corpora = 1;
+        return 1;
+    }
+    if (strcmp(option, "--bench-incremental") == 0) {
+        options->compare_incremental_trees = 1;
+        return 1;
+    }
+    if (strncmp(option, "--bench-", 8) != 0 || *i + 1 >= argc) return 0;
+
+    const char *value = argv[++*i];
+    int ok = 1;
+    if (strcmp(option, "--bench-sizes") == 0) {
+        ok = parse_sizes(value, options);
+    } else if (strcmp(option, "--bench-vocab") == 0) {
+        options->vocabulary = atoi(value);
+        ok = options->vocabulary > 0;
+    } else if (strcmp(option, "--bench-zipf") == 0) {
+        options->zipf_exponent = atof(value);
+        ok = options->zipf_exponent > 0;
+    } else if (strcmp(option, "--bench-seed") == 0) {
+        options->seed = strtoull(value, NULL, 10);
+    } else if (strcmp(option, "--bench-reps") == 0) {
+        options->repetitions = atoi(value);
+        ok = options->repetitions > 0;
+    } else if (strcmp(option, "--bench-load-reps") == 0) {
+        options->load_repetitions = atoi(value);
+        ok = options->load_repetitions > 0;
+    } else if (strcmp(option, "--bench-lookups") == 0) {
+        options->lookups = atoi(value);
+        ok = options->lookups > 0;
+    } else if (strcmp(option, "--bench-dir") == 0) {
+        options->corpus_dir = value;
+    } else if (strcmp(option, "--bench-csv") == 0) {
+        options->csv_file = strcmp(value, "none") == 0 ? NULL : value;
+    } else if (strcmp(option, "--bench-json") == 0) {
+        options->json_file = strcmp(value, "none") == 0 ? NULL : value;
+    } else {
+        --*i;
+        return 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "Valor inválido para %s: '%s'.\n", option, value);
+        return -1;
+    }
+    return 1;
+}
+
+// Summarizes the per-operation times of each repetition (sorts 'samples'), with the candidates
+// the operation examined on average
+static void add_counted_result(BenchResult *results, int *count, const BenchResult *corpus, const char *operation,
+                               const char *target, double *samples, int repetitions, long ops, double examined) {
+    if (*count == BENCH_MAX_RESULTS) return;
+    BenchResult *result = &results[(*count)++];
+    *result = *corpus;
+    result->operation = operation;
+    result->target = target;
+    result->repetitions = repetitions;
+    result->ops = ops;
+    result->examined = examined;
+
+    qsort(samples, repetitions, sizeof(double), compare_doubles);
+    double sum = 0.0;
+    for (int r = 0; r < repetitions; r++) sum += samples[r];
+    result->min_ns = samples[0];
+    result->max_ns = samples[repetitions - 1];
+    result->mean_ns = sum / repetitions;
+    result->median_ns = repetitions % 2 ? samples[repetitions / 2]
+                                        : (samples[repetitions / 2 - 1] + samples[repetitions / 2]) / 2.0;
+
+    printf("%-10ld %-12s %-20s %8d %10ld %14.1f %14.1f %14.1f", result->lines, operation, target, repetitions, ops,
+           result->min_ns, result->median_ns, result->mean_ns);
+    if (examined > 0) printf(" %14.1f", examined);
+    printf("\n");
+    fflush(stdout);
+}
+
+static void add_result(BenchResult *results, int *count, const BenchResult *corpus, const char *operation,
+                       const char *target, double *samples, int repetitions, long ops) {
+    add_counted_result(results, count, corpus, operation, target, samples, repetitions, ops, 0.0);
+}
+
+static void release_bench_index(BenchIndex *index) {
+    free_vector(&index->vector);
+    free_hash_index(&index->hash);
+    free_eytzinger(&index->eytzinger);
+    free_freq_order(&index->freq_order);
+    free_year_counts(&index->year_counts);
+    free_quote_id_lists(&index->quote_ids);
+    free_quote_pool(&index->pool);
+    index_arena_release(&index->arena);
+    memset(index, 0, sizeof(*index));
+}
+
+// Builds that follow load_data_from_file, timed in nanoseconds
+typedef struct PostLoadTimes {
+    double freq_avl_ns;      // Frequency order and frequency AVL
+    double eytzinger_ns;
+    double radix_ns;
+    double quote_ids_ns;
+    double year_counts_ns;
+} PostLoadTimes;
+
+static QueryIndex bench_query_index(const BenchIndex *index) {
+    QueryIndex query_index;
+    memset(&query_index, 0, sizeof(query_index));
+    query_index.vector = &index->vector;
+    query_index.eytzinger = &index->eytzinger;
+    query_index.bst = index->bst;
+    query_index.avl = index->avl;
+    query_index.hash = &index->hash;
+    query_index.freq_avl = index->freq_avl;
+    query_index.radix = index->radix;
+    query_index.freq_order = &index->freq_order;
+    query_index.pool = &index->pool;
+    query_index.year_counts = &index->year_counts;
+    query_index.quote_ids = &index->quote_ids;
+    return query_index;
+}
+
+// Loads the corpus into a fresh index the way the menu does: file, trees, frequency AVL,
+// Eytzinger layout, radix tree, quote ID lists and year counts. Returns the total in nanoseconds, or -1 on failure.
+static double load_bench_index(const char *filename, const LoadOptions *load_options, BenchIndex *index,
+                               LoadTimes *times, PostLoadTimes *post_times) {
+    memset(index, 0, sizeof(*index));
+    const uint64_t start = monotonic_ns();
+    *times = load_data_from_file(filename, load_options, &index->arena, &index->pool, &index->vector, &index->bst,
+                                 &index->avl, &index->hash);
+    if (times->vector_time_ms < 0) return -1.0;
+    const uint64_t start_freq = monotonic_ns();
+    const int freq_order_built = build_freq_order(&index->freq_order, &index->vector);
+    index->freq_avl = build_freq_avl_from_order(&index->freq_order, &index->arena);
+    const uint64_t start_eytzinger = monotonic_ns();
+    const int eytzinger_built = build_eytzinger_from_vector(&index->eytzinger, &index->vector);
+    const uint64_t start_radix = monotonic_ns();
+    index->radix = build_radix_from_sorted_vector(&index->vector, &index->arena);
+    const uint64_t start_quote_ids = monotonic_ns();
+    const int quote_ids_built = build_quote_id_lists(&index->quote_ids, &index->vector);
+    const uint64_t start_years = monotonic_ns();
+    const QueryIndex query_index = bench_query_index(index);
+    build_year_counts(&index->year_counts, &query_index); // Without them top-K reads the postings
+    const uint64_t end = monotonic_ns();
+    if (!freq_order_built || !index->freq_avl || !eytzinger_built || !index->radix || !quote_ids_built) {
+        release_bench_index(index);
+        return -1.0;
+    }
+    post_times->freq_avl_ns = (double)(start_eytzinger - start_freq);
+    post_times->eytzinger_ns = (double)(start_radix - start_eytzinger);
+    post_times->radix_ns = (double)(start_quote_ids - start_radix);
+    post_times->quote_ids_ns = (double)(start_years - start_quote_ids);
+    post_times->year_counts_ns = (double)(end - start_years);
+    return (double)(end - start);
+}
+
+// Times 'load_repetitions' loads of the corpus and keeps the index of the last one
+static int measure_load(const BenchmarkOptions *options, const char *filename, BenchIndex *index,
+                        BenchResult *corpus, BenchResult *results, int *result_count) {
+    enum { PHASE_TOTAL, PHASE_PARSE, PHASE_LOCAL, PHASE_MERGE, PHASE_BST, PHASE_AVL, PHASE_HASH, PHASE_FREQ_AVL,
+           PHASE_EYTZINGER, PHASE_RADIX, PHASE_QUOTE_IDS, PHASE_YEAR_COUNTS, PHASE_BST_INCREMENTAL, PHASE_AVL_INCREMENTAL, PHASE_COUNT };
+    static const char *phase_names[PHASE_COUNT] = {
+        "total", "parse", "local_vocabularies", "merge", "bst", "avl", "hash", "freq_avl", "eytzinger",
+        "radix", "quote_ids", "year_counts", "bst_incremental", "avl_incremental"
+    };
+    const int repetitions = options->load_repetitions;
+    double *samples = (double *)malloc(PHASE_COUNT * repetitions * sizeof(double));
+    if (!samples) {
+        perror("Falha ao alocar as medidas");
+        return 0;
+    }
+
+    const LoadOptions load_options = { options->compare_incremental_trees, options->threads, 1, 0, 0 };
+    for (int r = 0; r < repetitions; r++) {
+        if (r > 0) release_bench_index(index);
+        LoadTimes times;
+        PostLoadTimes post_times;
+        const double total = load_bench_index(filename, &load_options, index, &times, &post_times);
+        if (total < 0) {
+            fprintf(stderr, "Falha ao carregar '%s'.\n", filename);
+            free(samples);
+            return 0;
+        }
+        double *sample = samples + r;
+        sample[PHASE_TOTAL * repetitions] = total;
+        sample[PHASE_PARSE * repetitions] = times.parse_time_ms * 1e6;
+        sample[PHASE_LOCAL * repetitions] = times.local_build_time_ms * 1e6;
+        sample[PHASE_MERGE * repetitions] = times.merge_time_ms * 1e6;
+        sample[PHASE_BST * repetitions] = times.bst_bulk_time_ms * 1e6;
+        sample[PHASE_AVL * repetitions] = times.avl_bulk_time_ms * 1e6;
+        sample[PHASE_HASH * repetitions] = times.hash_time_ms * 1e6;
+        sample[PHASE_FREQ_AVL * repetitions] = post_times.freq_avl_ns;
+        sample[PHASE_EYTZINGER * repetitions] = post_times.eytzinger_ns;
+        sample[PHASE_RADIX * repetitions] = post_times.radix_ns;
+        sample[PHASE_QUOTE_IDS * repetitions] = post_times.quote_ids_ns;
+        sample[PHASE_YEAR_COUNTS * repetitions] = post_times.year_counts_ns;
+        sample[PHASE_BST_INCREMENTAL * repetitions] = times.bst_time_ms * 1e6;
+        sample[PHASE_AVL_INCREMENTAL * repetitions] = times.avl_time_ms * 1e6;
+    }
+    corpus->words = index->vector.size;
+
+    const int phases = options->compare_incremental_trees ? PHASE_COUNT : PHASE_BST_INCREMENTAL;
+    for (int p = 0; p < phases; p++) {
+        add_result(results, result_count, corpus, "load", phase_names[p], samples + p * repetitions, repetitions, 1);
+    }
+    free(samples);
+    return 1;
+}
+
+static void count_range_word(const WordInfo *info, void *context) {
+    (void)info;
+    (*(long *)context)++;
+}
+
+// Times the word lookups of every structure, the frequency ranges, top-K and prefix completions
+// on the loaded index
+static int measure_searches(const BenchmarkOptions *options, const BenchIndex *index, const BenchResult *corpus,
+                            BenchResult *results, int *result_count) {
+    const int lookups = options->lookups;
+    const int repetitions = options->repetitions;
+    char (*hits)[BENCH_WORD_MAX] = malloc((size_t)lookups * BENCH_WORD_MAX);
+    char (*misses)[BENCH_WORD_MAX] = malloc((size_t)lookups * BENCH_WORD_MAX);
+    double *samples = (double *)malloc(repetitions * sizeof(double));
+    double *cdf = build_zipf_cdf(options->vocabulary, options->zipf_exponent);
+    if (!hits || !misses || !samples || !cdf) {
+        perror("Falha ao alocar as consultas");
+        free(hits);
+        free(misses);
+        free(samples);
+        free(cdf);
+        return 0;
+    }
+
+    // Same mix for every structure; hits that the corpus happened not to use are redrawn
+    unsigned long long state = options->seed ^ 0x5DEECE66Dull;
+    for (int q = 0; q < lookups; q++) {
+        int found = 0;
+        for (int attempt = 0; attempt < 8 && !found; attempt++) {
+            synthetic_word((unsigned long)draw_zipf_rank(cdf, options->vocabulary, &state), hits[q]);
+            found = search_hash_index(&index->hash, hits[q]) != NULL;
+        }
+        if (!found) {
+            strcpy(hits[q], index->vector.words[next_random(&state) % index->vector.size]->word);
+        }
+        synthetic_word((unsigned long)options->vocabulary + next_random(&state) % (unsigned long)options->vocabulary,
+                       misses[q]);
+    }
+
+    const QueryIndex query_index = bench_query_index(index);
+    WordInfo view;
+    for (int s = 0; s < LOOKUP_STRUCTURE_COUNT; s++) {
+        const QueryStructure structure = lookup_structures[s];
+        for (int kind = 0; kind < 2; kind++) {
+            char (*queries)[BENCH_WORD_MAX] = kind == 0 ? hits : misses;
+            long found = 0;
+            for (int r = -1; r < repetitions; r++) { // Round -1 warms the caches up and is not kept
+                const uint64_t start = monotonic_ns();
+                for (int q = 0; q < lookups; q++) {
+                    found += lookup_word(&query_index, structure, queries[q], &view) != NULL;
+                }
+                if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / lookups;
+            }
+            const long expected = kind == 0 ? (long)lookups * (repetitions + 1) : 0;
+            if (found != expected) {
+                fprintf(stderr, "Aviso: %s encontrou %ld de %ld palavras esperadas.\n",
+                        query_structure_name(structure), found, expected);
+            }
+            add_result(results, result_count, corpus, kind == 0 ? "lookup_hit" : "lookup_miss",
+                       query_structure_name(structure), samples, repetitions, lookups);
+        }
+    }
+
+    // Frequency ranges around the frequency of a random word, 10% wide
+    const int ranges = lookups / 100 > 100 ? lookups / 100 : 100; // Also the rounds of each top-K query
+    int *bounds = (int *)malloc(2 * ranges * sizeof(int));
+    if (bounds) {
+        for (int q = 0; q < ranges; q++) {
+            const int frequency = index->vector.words[next_random(&state) % index->vector.size]->frequency;
+            bounds[2 * q] = frequency;
+            bounds[2 * q + 1] = frequency + frequency / 10;
+        }
+        long visited = 0;
+        for (int r = -1; r < repetitions; r++) {
+            const uint64_t start = monotonic_ns();
+            for (int q = 0; q < ranges; q++) {
+                visit_freq_range(&query_index, bounds[2 * q], bounds[2 * q + 1], count_range_word, &visited);
+            }
+            if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / ranges;
+        }
+        add_result(results, result_count, corpus, "freq_range", "freq_avl", samples, repetitions, ranges);
+        free(bounds);
+    }
+
+    // Top-50 words, without filters and with each filter (the corpora span 1930-2019)
+    static const TopKFilter top_filters[] = { { 0, 0, 0 }, { 8, 0, 0 }, { 0, 1980, 1989 } };
+    static const char *top_targets[] = { "k50", "k50_min_length8", "k50_years1980s" };
+    TopKEntry top[50];
+    for (int f = 0; f < (int)(sizeof(top_filters) / sizeof(top_filters[0])); f++) {
+        for (int r = -1; r < repetitions; r++) {
+            const uint64_t start = monotonic_ns();
+            for (int q = 0; q < ranges; q++) {
+                top_k_words(&query_index, 50, &top_filters[f], top);
+            }
+            if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / ranges;
+        }
+        add_result(results, result_count, corpus, "top_k", top_targets[f], samples, repetitions, ranges);
+    }
+
+    // Top-10 completions of the first 2 and 3 letters of random words: the radix tree against
+    // the prefix range scan of the sorted vector
+    static const QueryStructure prefix_structures[] = { QUERY_RADIX, QUERY_VECTOR };
+    static const char *prefix_targets[2][2] = { { "radix_len2", "vector_len2" }, { "radix_len3", "vector_len3" } };
+    TopKEntry completions[BENCH_COMPLETIONS];
+    for (int length = 2; length <= 3; length++) {
+        char (*prefixes)[4] = malloc((size_t)ranges * 4);
+        if (!prefixes) break;
+        for (int q = 0; q < ranges; q++) {
+            const WordInfo *word = index->vector.words[next_random(&state) % index->vector.size];
+            snprintf(prefixes[q], 4, "%.*s", length, word->word);
+        }
+        for (int s = 0; s < 2; s++) {
+            for (int r = -1; r < repetitions; r++) {
+                const uint64_t start = monotonic_ns();
+                for (int q = 0; q < ranges; q++) {
+                    complete_prefix(&query_index, prefix_structures[s], prefixes[q], BENCH_COMPLETIONS, completions,
+                                    NULL);
+                }
+                if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / ranges;
+            }
+            add_result(results, result_count, corpus, "prefix_top10", prefix_targets[length - 2][s], samples,
+                       repetitions, ranges);
+        }
+        free(prefixes);
+    }
+
+    // Top-10 fuzzy matches of Zipf-drawn words with one letter replaced, within 1 and 2 edits: the
+    // radix tree against the distance to every word of the sorted vector, with the radix nodes
+    // visited and the words compared per query
+    static const char *fuzzy_targets[2][2] = { { "radix_k1", "vector_k1" }, { "radix_k2", "vector_k2" } };
+    FuzzyEntry fuzzy[BENCH_COMPLETIONS];
+    char (*typos)[BENCH_WORD_MAX] = malloc((size_t)ranges * BENCH_WORD_MAX);
+    for (int q = 0; typos && q < ranges; q++) {
+        strcpy(typos[q], hits[q % lookups]);
+        typos[q][next_random(&state) % strlen(typos[q])] = (char)('a' + next_random(&state) % 26);
+    }
+    for (int distance = 1; distance <= 2 && typos; distance++) {
+        for (int s = 0; s < 2; s++) {
+            long examined = 0;
+            for (int r = -1; r < repetitions; r++) {
+                const uint64_t start = monotonic_ns();
+                for (int q = 0; q < ranges; q++) {
+                    long candidates = 0;
+                    fuzzy_lookup(&query_index, prefix_structures[s], typos[q], distance, BENCH_COMPLETIONS, fuzzy,
+                                 NULL, &candidates);
+                    if (r < 0) examined += candidates;
+                }
+                if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / ranges;
+            }
+            add_counted_result(results, result_count, corpus, "fuzzy_top10", fuzzy_targets[distance - 1][s], samples,
+                               repetitions, ranges, (double)examined / ranges);
+        }
+    }
+    free(typos);
+
+    // Boolean queries over pairs of the Zipf-drawn words; "and2_decode" runs the AND on the varint
+    // postings, without the decoded quote ID lists
+    static const char *boolean_formats[] = { "%s AND %s", "%s AND %s", "%s OR %s", "%s AND NOT %s" };
+    static const char *boolean_targets[] = { "and2", "and2_decode", "or2", "and_not2" };
+    BooleanNode **boolean_queries = (BooleanNode **)calloc(ranges, sizeof(BooleanNode *));
+    QueryIndex decode_index = query_index;
+    decode_index.quote_ids = NULL;
+    for (int f = 0; f < 4 && boolean_queries; f++) {
+        int parsed = 1;
+        for (int q = 0; q < ranges && parsed; q++) {
+            char text[2 * BENCH_WORD_MAX + 16], error[128];
+            snprintf(text, sizeof(text), boolean_formats[f], hits[(2 * q) % lookups], hits[(2 * q + 1) % lookups]);
+            parsed = (boolean_queries[q] = parse_boolean_query(text, error, sizeof(error))) != NULL;
+        }
+        const QueryIndex *target_index = f == 1 ? &decode_index : &query_index;
+        for (int r = -1; r < repetitions && parsed; r++) {
+            const uint64_t start = monotonic_ns();
+            for (int q = 0; q < ranges; q++) {
+                int *ids;
+                evaluate_boolean_query(target_index, boolean_queries[q], &ids);
+                free(ids);
+            }
+            if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / ranges;
+        }
+        if (parsed) {
+            add_result(results, result_count, corpus, "boolean", boolean_targets[f], samples, repetitions, ranges);
+        }
+        for (int q = 0; q < ranges; q++) {
+            free_boolean_query(boolean_queries[q]);
+            boolean_queries[q] = NULL;
+        }
+    }
+    free(boolean_queries);
+
+    // Top-10 BM25 quotes for one and two of the Zipf-drawn words, with the MaxScore bounds and
+    // scoring every posting, next to the unranked OR above; with the postings scored per query
+    static const char *ranked_targets[2][2] = { { "maxscore_1word", "all_1word" }, { "maxscore_2words", "all_2words" } };
+    RankedQuery **ranked_queries = (RankedQuery **)calloc(ranges, sizeof(RankedQuery *));
+    RankedQuote ranked[BENCH_COMPLETIONS];
+    for (int words = 1; words <= 2 && ranked_queries; words++) {
+        int parsed = 1;
+        for (int q = 0; q < ranges && parsed; q++) {
+            char text[2 * BENCH_WORD_MAX + 2], error[128];
+            snprintf(text, sizeof(text), words == 1 ? "%s" : "%s %s", hits[(2 * q) % lookups],
+                     hits[(2 * q + 1) % lookups]);
+            parsed = (ranked_queries[q] = parse_ranked_query(text, error, sizeof(error))) != NULL;
+        }
+        for (int prune = 1; prune >= 0 && parsed; prune--) {
+            long scored = 0;
+            for (int r = -1; r < repetitions; r++) {
+                const uint64_t start = monotonic_ns();
+                for (int q = 0; q < ranges; q++) {
+                    long postings = 0;
+                    rank_quotes(&query_index, ranked_queries[q], BENCH_COMPLETIONS, prune, ranked, &postings);
+                    if (r < 0) scored += postings;
+                }
+                if (r >= 0) samples[r] = (double)(monotonic_ns() - start) / ranges;
+            }
+            add_counted_result(results, result_count, corpus, "ranked_top10", ranked_targets[words - 1][1 - prune],
+                               samples, repetitions, ranges, (double)scored / ranges);
+        }
+        for (int q = 0; q < ranges; q++) {
+            free_ranked_query(ranked_queries[q]);
+            ranked_queries[q] = NULL;
+        }
+    }
+    free(ranked_queries);
+
+    free(hits);
+    free(misses);
+    free(samples);
+    free(cdf);
+    return bounds != NULL;
+}
+
+static int write_csv_results(const char *filename, const BenchmarkOptions *options, const BenchResult *results,
+                             int count) {
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        perror("Falha ao criar o arquivo CSV");
+        return 0;
+    }
+    fprintf(out, "lines,vocabulary,zipf_exponent,bytes,words,operation,target,repetitions,ops_per_repetition,"
+                 "min_ns,median_ns,mean_ns,max_ns,examined_per_op\n");
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(out, "%ld,%d,%g,%zu,%d,%s,%s,%d,%ld,%.1f,%.1f,%.1f,%.1f,%.1f\n", r->lines, options->vocabulary,
+                options->zipf_exponent, r->bytes, r->words, r->operation, r->target, r->repetitions, r->ops,
+                r->min_ns, r->median_ns, r->mean_ns, r->max_ns, r->examined);
+    }
+    if (fclose(out) != 0) {
+        perror("Falha ao gravar o arquivo CSV");
+        return 0;
+    }
+    return 1;
+}
+
+static int write_json_results(const char *filename, const BenchmarkOptions *options, const BenchResult *results,
+                              int count) {
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        perror("Falha ao criar o arquivo JSON");
+        return 0;
+    }
+    fprintf(out, "{\n  \"vocabulary\": %d,\n  \"zipf_exponent\": %g,\n  \"seed\": %llu,\n  \"threads\": %d,\n"
+                 "  \"results\": [\n", options->vocabulary, options->zipf_exponent, options->seed, options->threads);
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(out, "    {\"lines\": %ld, \"bytes\": %zu, \"words\": %d, \"operation\": \"%s\", \"target\": \"%s\", "
+                     "\"repetitions\": %d, \"ops_per_repetition\": %ld, \"min_ns\": %.1f, \"median_ns\": %.1f, "
+                     "\"mean_ns\": %.1f, \"max_ns\": %.1f, \"examined_per_op\": %.1f}%s\n", r->lines, r->bytes,
+                r->words, r->operation, r->target, r->repetitions, r->ops, r->min_ns, r->median_ns, r->mean_ns,
+                r->max_ns, r->examined, i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    if (fclose(out) != 0) {
+        perror("Falha ao gravar o arquivo JSON");
+        return 0;
+    }
+    return 1;
+}
+
+int run_benchmark(const BenchmarkOptions *options) {
+    BenchResult *results = (BenchResult *)malloc(BENCH_MAX_RESULTS * sizeof(BenchResult));
+    if (!results) {
+        perror("Falha ao alocar os resultados");
+        return 0;
+    }
+    int result_count = 0;
+    int ok = 1;
+
+    printf("Benchmark: vocabulário de %d palavras, Zipf s = %g, semente %llu\n", options->vocabulary,
+           options->zipf_exponent, options->seed);
+    printf("%-10s %-14s %-20s %8s %10s %15s %14s %15s %14s\n", "linhas", "operação", "alvo", "rodadas", "ops/rodada",
+           "mín (ns/op)", "mediana", "média", "examinados/op");
+
+    for (int s = 0; s < options->size_count && ok; s++) {
+        const long lines = options->sizes[s];
+        char filename[1024];
+        snprintf(filename, sizeof(filename), "%s/zipf_%ld_%d.csv", options->corpus_dir, lines, options->vocabulary);
+
+        const uint64_t start_generation = monotonic_ns();
+        if (!generate_zipf_corpus(filename, lines, options->vocabulary, options->zipf_exponent, options->seed + s)) {
+            ok = 0;
+            break;
+        }
+        const double generation_ms = (monotonic_ns() - start_generation) / 1000000.0;
+
+        BenchResult corpus;
+        memset(&corpus, 0, sizeof(corpus));
+        corpus.lines = lines;
+        FILE *file = fopen(filename, "rb");
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            corpus.bytes = (size_t)ftell(file);
+            fclose(file);
+        }
+        fprintf(stderr, "Corpus '%s' gerado em %.1f ms (%.1f MB).\n", filename, generation_ms,
+                corpus.bytes / (1024.0 * 1024.0));
+
+        BenchIndex index;
+        memset(&index, 0, sizeof(index));
+        ok = measure_load(options, filename, &index, &corpus, results, &result_count) &&
+             measure_searches(options, &index, &corpus, results, &result_count);
+        release_bench_index(&index);
+        if (!options->keep_corpora) unlink(filename);
+    }
+
+    if (options->csv_file && !write_csv_results(options->csv_file, options, results, result_count)) ok = 0;
+    if (options->json_file && !write_json_results(options->json_file, options, results, result_count)) ok = 0;
+    if (ok) {
+        if (options->csv_file) printf("Resultados gravados em '%s'.\n", options->csv_file);
+        if (options->json_file) printf("Resultados gravados em '%s'.\n", options->json_file);
+    }
+    free(results);
+    return ok;
+}
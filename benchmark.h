@@ -0,0 +1,41 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#define BENCH_MAX_SIZES 16
+
+// Settings of the end-to-end benchmark (--benchmark)
+typedef struct BenchmarkOptions {
+  long sizes[BENCH_MAX_SIZES];  // Lines of each generated corpus, smallest first
+  int size_count;
+  int vocabulary;               // Distinct words the generator draws from
+  double zipf_exponent;         // Word rank r is drawn with probability proportional to 1 / r^s
+  unsigned long long seed;      // Same seed, same corpora and queries
+  int load_repetitions;         // Timed loads of each corpus
+  int repetitions;              // Timed rounds of each search
+  int lookups;                  // Searches per round
+  int threads;                  // Load threads (0 = one per processor)
+  int compare_incremental_trees; // Also times the token-by-token BST/AVL inserts
+  const char *corpus_dir;       // Where the corpora are generated
+  int keep_corpora;             // Leaves the generated files behind
+  const char *csv_file;         // NULL skips the CSV results
+  const char *json_file;        // NULL skips the JSON results
+} BenchmarkOptions;
+
+// Fills in the defaults: 10K, 100K and 1M lines, 50K words, s = 1.0.
+void init_benchmark_options(BenchmarkOptions *options);
+
+// Consumes the benchmark option at argv[*i] (and its value), advancing *i.
+// Returns 1 if it was one, 0 if not, -1 if its value is invalid.
+int parse_benchmark_option(int argc, char *argv[], int *i, BenchmarkOptions *options);
+
+// Writes a CSV corpus in the movie quotes format with 'lines' quotes whose words follow a
+// Zipf distribution over 'vocabulary' synthetic words. Returns 1 on success.
+int generate_zipf_corpus(const char *filename, long lines, int vocabulary, double zipf_exponent,
+                         unsigned long long seed);
+
+// Generates each corpus, times its load and the searches of every structure over many
+// repetitions (monotonic nanosecond clock), prints a table and writes the CSV/JSON results.
+// Returns 1 on success.
+int run_benchmark(const BenchmarkOptions *options);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,647 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "boolean_operations.h"
+#include "array_operations.h"
+#include "posting_operations.h"
+#include "word_processing.h"
+#include "index_snapshot.h"
+#include "mem_accounting.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// From this length ratio on, every ID of the shorter list gallops through the longer one, which
+// costs O(short * log(long / short)) instead of O(short + long). Below it the merge wins: it
+// skips 4 IDs per comparison and its branches are predictable (measured crossover: 128-256).
+#define GALLOP_RATIO 128
+
+// --- Quote ID Lists ---
+
+int build_quote_id_lists(QuoteIdLists *lists, const WordVector *vec) {
+    memset(lists, 0, sizeof(*lists));
+    size_t total = 0;
+    for (int r = 0; r < vec->size; r++) total += vec->words[r]->postings.quote_count;
+
+    lists->offsets = (int *)mem_alloc(MEM_QUOTE_IDS, (vec->size + 1) * sizeof(int));
+    lists->max_counts = (int *)mem_alloc(MEM_QUOTE_IDS, (vec->size + 1) * sizeof(int));
+    lists->ids = (int *)mem_alloc(MEM_QUOTE_IDS, (total ? total : 1) * sizeof(int));
+    lists->counts = (int *)mem_alloc(MEM_QUOTE_IDS, (total ? total : 1) * sizeof(int));
+    if (!lists->offsets || !lists->max_counts || !lists->ids || !lists->counts) {
+        perror("Failed to allocate quote ID lists");
+        free_quote_id_lists(lists);
+        return 0;
+    }
+
+    int next = 0;
+    for (int r = 0; r < vec->size; r++) {
+        lists->offsets[r] = next;
+        lists->max_counts[r] = 0;
+        PostingIterator it;
+        posting_iterator_init(&it, &vec->words[r]->postings);
+        while (posting_iterator_next(&it)) {
+            lists->ids[next] = it.quote_id;
+            lists->counts[next++] = it.term_count;
+            if (it.term_count > lists->max_counts[r]) lists->max_counts[r] = it.term_count;
+        }
+    }
+    lists->offsets[vec->size] = next;
+    lists->size = vec->size;
+    return 1;
+}
+
+// A word the index did not have before an append has only quotes of the appended file
+static int is_appended_word(const PostingList *postings, int first_new_quote) {
+    PostingIterator it;
+    posting_iterator_init(&it, postings);
+    return !posting_iterator_next(&it) || it.quote_id >= first_new_quote;
+}
+
+int extend_quote_id_lists(QuoteIdLists *lists, const WordVector *vec, int first_new_quote) {
+    if (!lists->offsets) return build_quote_id_lists(lists, vec);
+    size_t total = 0;
+    for (int r = 0; r < vec->size; r++) total += vec->words[r]->postings.quote_count;
+
+    int *offsets = (int *)mem_realloc(MEM_QUOTE_IDS, lists->offsets, (vec->size + 1) * sizeof(int));
+    if (offsets) lists->offsets = offsets;
+    int *max_counts = (int *)mem_realloc(MEM_QUOTE_IDS, lists->max_counts, (vec->size + 1) * sizeof(int));
+    if (max_counts) lists->max_counts = max_counts;
+    int *ids = (int *)mem_realloc(MEM_QUOTE_IDS, lists->ids, (total ? total : 1) * sizeof(int));
+    if (ids) lists->ids = ids;
+    int *counts = (int *)mem_realloc(MEM_QUOTE_IDS, lists->counts, (total ? total : 1) * sizeof(int));
+    if (counts) lists->counts = counts;
+    if (!offsets || !max_counts || !ids || !counts) {
+        perror("Failed to extend quote ID lists");
+        free_quote_id_lists(lists);
+        return 0;
+    }
+
+    // From the last word back, so every list only moves towards the end and lands past the
+    // old lists still to be moved. Known words keep their order in the vector.
+    int old = lists->size - 1;
+    int old_end = lists->offsets[lists->size];
+    int end = (int)total;
+    for (int r = vec->size - 1; r >= 0; r--) {
+        const PostingList *postings = &vec->words[r]->postings;
+        const int start = end - postings->quote_count;
+        int next = start, max_count = 0;
+        PostingIterator it;
+        if (old >= 0 && !is_appended_word(postings, first_new_quote)) {
+            const int old_start = offsets[old];
+            const int kept = old_end - old_start;
+            memmove(ids + start, ids + old_start, kept * sizeof(int));
+            memmove(counts + start, counts + old_start, kept * sizeof(int));
+            max_count = max_counts[old];
+            next = start + kept;
+            posting_iterator_init_tail(&it, postings, postings->quote_count - kept, ids[next - 1]);
+            old_end = old_start;
+            old--;
+        } else {
+            posting_iterator_init(&it, postings);
+        }
+        while (posting_iterator_next(&it)) {
+            ids[next] = it.quote_id;
+            counts[next++] = it.term_count;
+            if (it.term_count > max_count) max_count = it.term_count;
+        }
+        offsets[r] = start;
+        max_counts[r] = max_count;
+        end = start;
+    }
+    offsets[vec->size] = (int)total;
+    lists->size = vec->size;
+    return 1;
+}
+
+void free_quote_id_lists(QuoteIdLists *lists) {
+    mem_free(lists->ids);
+    mem_free(lists->counts);
+    mem_free(lists->offsets);
+    mem_free(lists->max_counts);
+    memset(lists, 0, sizeof(*lists));
+}
+
+// --- List Operations ---
+
+// First position from 'low' on whose ID is not below 'target': doubles the step until it
+// passes the target, then binary searches the last step
+int gallop_quote_ids(const int *ids, int count, int low, int target) {
+    if (low >= count || ids[low] >= target) return low;
+    int step = 1;
+    while (low + step < count && ids[low + step] < target) step <<= 1;
+    // ids[low + step / 2] < target <= ids[low + step] (or the end of the list)
+    int first = low + step / 2 + 1, last = low + step < count ? low + step : count;
+    while (first < last) {
+        int mid = first + (last - first) / 2;
+        if (ids[mid] < target) first = mid + 1;
+        else last = mid;
+    }
+    return first;
+}
+
+int intersect_quote_ids(const int *a, int a_count, const int *b, int b_count, int *out) {
+    if (a_count > b_count) {
+        const int *ids = a; a = b; b = ids;
+        int count = a_count; a_count = b_count; b_count = count;
+    }
+    // Every ID written matches one already read from both lists, so 'out' never overtakes them
+    int count = 0, j = 0;
+    if (b_count / GALLOP_RATIO >= a_count) {
+        for (int i = 0; i < a_count; i++) {
+            j = gallop_quote_ids(b, b_count, j, a[i]);
+            if (j == b_count) break;
+            if (b[j] == a[i]) out[count++] = a[i];
+        }
+        return count;
+    }
+
+    for (int i = 0; i < a_count; i++) {
+        const int target = a[i];
+#ifdef __SSE2__
+        // Skips whole blocks of 4 IDs below the target, then looks for it in the next block at once
+        while (j + 4 <= b_count && b[j + 3] < target) j += 4;
+        if (j + 4 <= b_count) {
+            __m128i block = _mm_loadu_si128((const __m128i *)(b + j));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(block, _mm_set1_epi32(target)))) out[count++] = target;
+            continue;
+        }
+#endif
+        while (j < b_count && b[j] < target) j++;
+        if (j == b_count) break;
+        if (b[j] == target) out[count++] = target;
+    }
+    return count;
+}
+
+int subtract_quote_ids(const int *a, int a_count, const int *b, int b_count, int *out) {
+    const int gallop = b_count / GALLOP_RATIO >= a_count;
+    int count = 0, j = 0;
+    for (int i = 0; i < a_count; i++) {
+        if (gallop) {
+            j = gallop_quote_ids(b, b_count, j, a[i]);
+        } else {
+            while (j < b_count && b[j] < a[i]) j++;
+        }
+        if (j < b_count && b[j] == a[i]) continue;
+        out[count++] = a[i];
+    }
+    return count;
+}
+
+int unite_quote_ids(const int *a, int a_count, const int *b, int b_count, int *out) {
+    int count = 0, i = 0, j = 0;
+    while (i < a_count && j < b_count) {
+        if (a[i] < b[j]) {
+            out[count++] = a[i++];
+        } else if (b[j] < a[i]) {
+            out[count++] = b[j++];
+        } else {
+            out[count++] = a[i++]; // In both lists: written once
+            j++;
+        }
+    }
+    while (i < a_count) out[count++] = a[i++];
+    while (j < b_count) out[count++] = b[j++];
+    return count;
+}
+
+// --- Parser ---
+
+typedef enum BooleanTokenType {
+    TOKEN_END, TOKEN_WORD, TOKEN_AND, TOKEN_OR, TOKEN_NOT, TOKEN_OPEN, TOKEN_CLOSE
+} BooleanTokenType;
+
+typedef struct BooleanParser {
+    const char *cursor;
+    BooleanTokenType token;  // Current token
+    const char *start;
+    int length;
+    char *error;
+    int error_size;
+    int failed;
+} BooleanParser;
+
+static int is_operator(const char *start, int length, const char *name) {
+    if ((int)strlen(name) != length) return 0;
+    for (int i = 0; i < length; i++) {
+        if (tolower((unsigned char)start[i]) != name[i]) return 0;
+    }
+    return 1;
+}
+
+// Reads the next token: a parenthesis, an operator or a word up to the next space or parenthesis
+static void next_token(BooleanParser *parser) {
+    const char *c = parser->cursor;
+    while (isspace((unsigned char)*c)) c++;
+    parser->start = c;
+    if (*c == '\0') {
+        parser->token = TOKEN_END;
+    } else if (*c == '(' || *c == ')') {
+        parser->token = *c == '(' ? TOKEN_OPEN : TOKEN_CLOSE;
+        c++;
+    } else {
+        while (*c != '\0' && !isspace((unsigned char)*c) && *c != '(' && *c != ')') c++;
+        const int length = (int)(c - parser->start);
+        if (is_operator(parser->start, length, "and")) parser->token = TOKEN_AND;
+        else if (is_operator(parser->start, length, "or")) parser->token = TOKEN_OR;
+        else if (is_operator(parser->start, length, "not")) parser->token = TOKEN_NOT;
+        else parser->token = TOKEN_WORD;
+    }
+    parser->length = (int)(c - parser->start);
+    parser->cursor = c;
+}
+
+static void parse_error(BooleanParser *parser, const char *message) {
+    if (!parser->failed) snprintf(parser->error, parser->error_size, "%s", message);
+    parser->failed = 1;
+}
+
+static BooleanNode* new_boolean_node(BooleanParser *parser, BooleanNodeType type) {
+    BooleanNode *node = (BooleanNode *)calloc(1, sizeof(BooleanNode));
+    if (!node) {
+        perror("Failed to allocate boolean query");
+        parse_error(parser, "Falta de memória.");
+        return NULL;
+    }
+    node->type = type;
+    return node;
+}
+
+// Adds 'child' to the operands of 'node'; the operands of a child of the same type are moved
+// up, so "(a AND b) AND c" is a single AND with three operands
+static int add_boolean_child(BooleanNode *node, BooleanNode *child) {
+    const int flatten = child->type == node->type && node->type != BOOLEAN_NOT;
+    const int added = flatten ? child->child_count : 1;
+    BooleanNode **children = (BooleanNode **)realloc(node->children,
+                                                     (node->child_count + added) * sizeof(BooleanNode *));
+    if (!children) {
+        perror("Failed to allocate boolean query");
+        return 0;
+    }
+    node->children = children;
+    if (flatten) {
+        memcpy(children + node->child_count, child->children, added * sizeof(BooleanNode *));
+        free(child->children);
+        free(child);
+    } else {
+        children[node->child_count] = child;
+    }
+    node->child_count += added;
+    return 1;
+}
+
+// Joins two operands with AND or OR, extending 'left' if it already is that operator
+static BooleanNode* join_boolean_nodes(BooleanParser *parser, BooleanNodeType type, BooleanNode *left,
+                                       BooleanNode *right) {
+    BooleanNode *node = left;
+    if (left->type != type) {
+        node = new_boolean_node(parser, type);
+        if (node && !add_boolean_child(node, left)) {
+            free(node);
+            node = NULL;
+        }
+    }
+    if (!node || !add_boolean_child(node, right)) {
+        if (node) parse_error(parser, "Falta de memória.");
+        if (node != left) free_boolean_query(left);
+        free_boolean_query(right);
+        return NULL;
+    }
+    return node;
+}
+
+static BooleanNode* parse_or(BooleanParser *parser);
+
+// unary := NOT unary | '(' or ')' | WORD
+static BooleanNode* parse_unary(BooleanParser *parser) {
+    char message[320];
+    if (parser->token == TOKEN_NOT) {
+        next_token(parser);
+        BooleanNode *operand = parse_unary(parser);
+        if (!operand) return NULL;
+        BooleanNode *node = new_boolean_node(parser, BOOLEAN_NOT);
+        if (!node || !add_boolean_child(node, operand)) {
+            parse_error(parser, "Falta de memória.");
+            free(node);
+            free_boolean_query(operand);
+            return NULL;
+        }
+        return node;
+    }
+    if (parser->token == TOKEN_OPEN) {
+        next_token(parser);
+        BooleanNode *node = parse_or(parser);
+        if (!node) return NULL;
+        if (parser->token != TOKEN_CLOSE) {
+            parse_error(parser, "Falta fechar um parêntese.");
+            free_boolean_query(node);
+            return NULL;
+        }
+        next_token(parser);
+        return node;
+    }
+    if (parser->token == TOKEN_WORD) {
+        char raw[256];
+        const int length = parser->length < (int)sizeof(raw) - 1 ? parser->length : (int)sizeof(raw) - 1;
+        memcpy(raw, parser->start, length);
+        raw[length] = '\0';
+        char *word = normalize_word(raw);
+        if (!word) {
+            snprintf(message, sizeof(message), "Palavra inválida: '%s' (ela deve possuir mais que 3 letras).", raw);
+            parse_error(parser, message);
+            return NULL;
+        }
+        BooleanNode *node = new_boolean_node(parser, BOOLEAN_WORD);
+        if (!node) {
+            free(word);
+            return NULL;
+        }
+        node->word = word;
+        next_token(parser);
+        return node;
+    }
+    if (parser->token == TOKEN_END) {
+        parse_error(parser, "A consulta termina sem um operando.");
+    } else {
+        snprintf(message, sizeof(message), "Falta um operando antes de '%.*s'.", parser->length, parser->start);
+        parse_error(parser, message);
+    }
+    return NULL;
+}
+
+// and := unary ([AND] unary)*
+static BooleanNode* parse_and(BooleanParser *parser) {
+    BooleanNode *node = parse_unary(parser);
+    while (node && (parser->token == TOKEN_AND || parser->token == TOKEN_WORD || parser->token == TOKEN_NOT ||
+                    parser->token == TOKEN_OPEN)) {
+        if (parser->token == TOKEN_AND) next_token(parser);
+        BooleanNode *right = parse_unary(parser);
+        if (!right) {
+            free_boolean_query(node);
+            return NULL;
+        }
+        node = join_boolean_nodes(parser, BOOLEAN_AND, node, right);
+    }
+    return node;
+}
+
+// or := and (OR and)*
+static BooleanNode* parse_or(BooleanParser *parser) {
+    BooleanNode *node = parse_and(parser);
+    while (node && parser->token == TOKEN_OR) {
+        next_token(parser);
+        BooleanNode *right = parse_and(parser);
+        if (!right) {
+            free_boolean_query(node);
+            return NULL;
+        }
+        node = join_boolean_nodes(parser, BOOLEAN_OR, node, right);
+    }
+    return node;
+}
+
+BooleanNode* parse_boolean_query(const char *text, char *error, int error_size) {
+    BooleanParser parser = { text, TOKEN_END, text, 0, error, error_size, 0 };
+    next_token(&parser);
+    if (parser.token == TOKEN_END) {
+        parse_error(&parser, "Consulta vazia.");
+        return NULL;
+    }
+    BooleanNode *query = parse_or(&parser);
+    if (query && parser.token != TOKEN_END) {
+        parse_error(&parser, parser.token == TOKEN_CLOSE ? "Parêntese fechado sem ter sido aberto."
+                                                         : "Falta um operador entre os operandos.");
+        free_boolean_query(query);
+        return NULL;
+    }
+    return query;
+}
+
+void free_boolean_query(BooleanNode *query) {
+    if (!query) return;
+    for (int i = 0; i < query->child_count; i++) {
+        free_boolean_query(query->children[i]);
+    }
+    free(query->children);
+    free(query->word);
+    free(query);
+}
+
+// --- Evaluation ---
+
+// Quote IDs of an operand: borrowed from the index, or owned by the list
+typedef struct IdList {
+    const int *ids;
+    int count;
+    int *owned;  // Same as ids when the list must be freed, NULL otherwise
+} IdList;
+
+static void release_id_list(IdList *list) {
+    free(list->owned);
+    list->ids = list->owned = NULL;
+    list->count = 0;
+}
+
+static int compare_id_list_sizes(const void *a, const void *b) {
+    return ((const IdList *)a)->count - ((const IdList *)b)->count;
+}
+
+// Decodes a posting list the index has no quote ID list for
+static int decode_quote_ids(const PostingList *postings, IdList *out) {
+    out->owned = (int *)malloc((postings->quote_count ? postings->quote_count : 1) * sizeof(int));
+    if (!out->owned) {
+        perror("Failed to decode quote IDs");
+        return 0;
+    }
+    PostingIterator it;
+    posting_iterator_init(&it, postings);
+    while (posting_iterator_next(&it)) {
+        out->owned[out->count++] = it.quote_id;
+    }
+    out->ids = out->owned;
+    return 1;
+}
+
+static int word_quote_ids(const QueryIndex *index, const char *word, IdList *out) {
+    memset(out, 0, sizeof(*out));
+    if (index->snapshot) {
+        WordInfo view;
+        return search_snapshot(index->snapshot, word, &view) ? decode_quote_ids(&view.postings, out) : 1;
+    }
+    const int position = search_vector_position(index->vector, word);
+    if (position < 0) return 1;
+    const QuoteIdLists *lists = index->quote_ids;
+    if (!lists || lists->size != index->vector->size) {
+        return decode_quote_ids(&index->vector->words[position]->postings, out);
+    }
+    out->ids = lists->ids + lists->offsets[position];
+    out->count = lists->offsets[position + 1] - lists->offsets[position];
+    return 1;
+}
+
+// Every quote of the index, the base of a NOT that has nothing to be subtracted from
+static int all_quote_ids(const QueryIndex *index, IdList *out) {
+    const int count = index->pool ? index->pool->quote_count : 0;
+    out->owned = (int *)malloc((count ? count : 1) * sizeof(int));
+    if (!out->owned) {
+        perror("Failed to allocate quote IDs");
+        return 0;
+    }
+    for (int i = 0; i < count; i++) out->owned[i] = i;
+    out->ids = out->owned;
+    out->count = count;
+    return 1;
+}
+
+// Result buffer of an operation on 'list': the list itself when it owns its IDs
+static int* writable_ids(IdList *list, int capacity) {
+    if (list->owned) return list->owned;
+    int *ids = (int *)malloc((capacity ? capacity : 1) * sizeof(int));
+    if (!ids) perror("Failed to allocate quote IDs");
+    return ids;
+}
+
+// Keeps in 'result' the IDs also in 'other', which is released
+static int intersect_id_lists(IdList *result, IdList *other) {
+    int *out = writable_ids(result, result->count < other->count ? result->count : other->count);
+    if (!out) {
+        release_id_list(other);
+        return 0;
+    }
+    result->count = intersect_quote_ids(result->ids, result->count, other->ids, other->count, out);
+    result->ids = result->owned = out;
+    release_id_list(other);
+    return 1;
+}
+
+// Removes from 'result' the IDs in 'other', which is released
+static int subtract_id_lists(IdList *result, IdList *other) {
+    int *out = writable_ids(result, result->count);
+    if (!out) {
+        release_id_list(other);
+        return 0;
+    }
+    result->count = subtract_quote_ids(result->ids, result->count, other->ids, other->count, out);
+    result->ids = result->owned = out;
+    release_id_list(other);
+    return 1;
+}
+
+static int evaluate_node(const QueryIndex *index, const BooleanNode *node, IdList *out);
+
+// AND: the positive operands are intersected from the shortest up, so every step is bounded by
+// the smallest list and an empty result stops the evaluation; NOT operands are subtracted last
+static int evaluate_and(const QueryIndex *index, const BooleanNode *node, IdList *out) {
+    IdList *lists = (IdList *)calloc(node->child_count, sizeof(IdList));
+    if (!lists) {
+        perror("Failed to evaluate boolean query");
+        return 0;
+    }
+    int positive = 0, ok = 1;
+    for (int i = 0; i < node->child_count && ok; i++) {
+        if (node->children[i]->type != BOOLEAN_NOT) {
+            ok = evaluate_node(index, node->children[i], &lists[positive++]);
+        }
+    }
+
+    if (ok && positive == 0) {
+        ok = all_quote_ids(index, out);
+    } else if (ok) {
+        qsort(lists, positive, sizeof(IdList), compare_id_list_sizes);
+        *out = lists[0];
+        lists[0].owned = NULL;
+        for (int i = 1; i < positive && ok && out->count > 0; i++) {
+            ok = intersect_id_lists(out, &lists[i]);
+        }
+    }
+    for (int i = 0; i < positive; i++) release_id_list(&lists[i]);
+    free(lists);
+
+    for (int i = 0; i < node->child_count && ok && out->count > 0; i++) {
+        if (node->children[i]->type == BOOLEAN_NOT) {
+            IdList excluded;
+            ok = evaluate_node(index, node->children[i]->children[0], &excluded) && subtract_id_lists(out, &excluded);
+        }
+    }
+    if (!ok) release_id_list(out);
+    return ok;
+}
+
+// OR: the operands are merged from the shortest up, so the long lists are copied fewest times
+static int evaluate_or(const QueryIndex *index, const BooleanNode *node, IdList *out) {
+    IdList *lists = (IdList *)calloc(node->child_count, sizeof(IdList));
+    if (!lists) {
+        perror("Failed to evaluate boolean query");
+        return 0;
+    }
+    int ok = 1;
+    for (int i = 0; i < node->child_count && ok; i++) {
+        ok = evaluate_node(index, node->children[i], &lists[i]);
+    }
+    if (ok) {
+        qsort(lists, node->child_count, sizeof(IdList), compare_id_list_sizes);
+        *out = lists[0];
+        lists[0].owned = NULL;
+        for (int i = 1; i < node->child_count && ok; i++) {
+            int *ids = (int *)malloc((out->count + lists[i].count ? out->count + lists[i].count : 1) * sizeof(int));
+            if (!ids) {
+                perror("Failed to evaluate boolean query");
+                release_id_list(out);
+                ok = 0;
+                break;
+            }
+            const int count = unite_quote_ids(out->ids, out->count, lists[i].ids, lists[i].count, ids);
+            release_id_list(out);
+            out->ids = out->owned = ids;
+            out->count = count;
+        }
+    }
+    for (int i = 0; i < node->child_count; i++) release_id_list(&lists[i]);
+    free(lists);
+    return ok;
+}
+
+static int evaluate_node(const QueryIndex *index, const BooleanNode *node, IdList *out) {
+    memset(out, 0, sizeof(*out));
+    switch (node->type) {
+        case BOOLEAN_WORD:
+            return word_quote_ids(index, node->word, out);
+        case BOOLEAN_AND:
+            return evaluate_and(index, node, out);
+        case BOOLEAN_OR:
+            return evaluate_or(index, node, out);
+        case BOOLEAN_NOT: {
+            IdList excluded;
+            if (!evaluate_node(index, node->children[0], &excluded)) return 0;
+            if (!all_quote_ids(index, out)) {
+                release_id_list(&excluded);
+                return 0;
+            }
+            return subtract_id_lists(out, &excluded);
+        }
+    }
+    return 0;
+}
+
+int evaluate_boolean_query(const QueryIndex *index, const BooleanNode *query, int **ids) {
+    *ids = NULL;
+    IdList result;
+    if (!evaluate_node(index, query, &result)) return -1;
+    if (result.count == 0) {
+        release_id_list(&result);
+        return 0;
+    }
+    if (!result.owned) {
+        // A single word: its list belongs to the index
+        result.owned = (int *)malloc(result.count * sizeof(int));
+        if (!result.owned) {
+            perror("Failed to evaluate boolean query");
+            return -1;
+        }
+        memcpy(result.owned, result.ids, result.count * sizeof(int));
+    }
+    *ids = result.owned;
+    return result.count;
+}
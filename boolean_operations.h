@@ -0,0 +1,67 @@
+#ifndef BOOLEAN_OPERATIONS_H
+#define BOOLEAN_OPERATIONS_H
+
+#include "structures.h"
+#include "query_operations.h"
+
+// Node of a parsed boolean query
+typedef enum BooleanNodeType {
+  BOOLEAN_WORD,
+  BOOLEAN_AND,
+  BOOLEAN_OR,
+  BOOLEAN_NOT
+} BooleanNodeType;
+
+typedef struct BooleanNode {
+  BooleanNodeType type;
+  char *word;                     // Normalized word of a BOOLEAN_WORD
+  struct BooleanNode **children;  // Operands of AND/OR (nested ones of the same type are flattened),
+  int child_count;                // or the single operand of NOT
+} BooleanNode;
+
+// Decodes the posting list of every word of the sorted vector into 'lists', with the term
+// counts alongside the IDs. Returns 1 on success, 0 on allocation failure.
+int build_quote_id_lists(QuoteIdLists *lists, const WordVector *vec);
+
+// Brings the lists up to date with 'vec' after an append whose quotes are numbered from
+// 'first_new_quote' on. Only the postings the append added are decoded; the lists of the
+// other words are moved to their new positions. Returns 1 on success, 0 on allocation
+// failure, which leaves the lists freed.
+int extend_quote_id_lists(QuoteIdLists *lists, const WordVector *vec, int first_new_quote);
+
+// Frees the arrays of the lists.
+void free_quote_id_lists(QuoteIdLists *lists);
+
+// First position from 'low' on whose ID is not below 'target', found by doubling the step
+// and then binary searching the last one.
+int gallop_quote_ids(const int *ids, int count, int low, int target);
+
+// Writes the IDs found in both ascending lists into 'out', which needs room for the shorter
+// one and may be either input. Walks the shorter list and gallops through the longer one when
+// it is at least 128 times longer; otherwise merges, comparing 4 IDs at a time with SSE2.
+// Returns the number of IDs written.
+int intersect_quote_ids(const int *a, int a_count, const int *b, int b_count, int *out);
+
+// Writes the IDs of 'a' that are not in 'b' into 'out' (room for a_count; may be 'a').
+// Returns the number of IDs written.
+int subtract_quote_ids(const int *a, int a_count, const int *b, int b_count, int *out);
+
+// Writes the IDs of either list, each once, into 'out' (room for a_count + b_count; must not
+// be an input). Returns the number of IDs written.
+int unite_quote_ids(const int *a, int a_count, const int *b, int b_count, int *out);
+
+// Parses words joined by AND, OR and NOT (any case) with parentheses; AND binds tighter than
+// OR and adjacent words are ANDed. Words are normalized like in a word search.
+// Returns the query, or NULL with a message in 'error' if it is malformed.
+BooleanNode* parse_boolean_query(const char *text, char *error, int error_size);
+
+// Frees a parsed query.
+void free_boolean_query(BooleanNode *query);
+
+// Evaluates the query against the index into a malloc'd array of ascending, distinct quote IDs
+// in *ids (NULL when there are none), which the caller frees. The operands of an AND are
+// intersected from the shortest list up and its NOT operands subtracted last; a NOT elsewhere is
+// taken against every quote. Returns the number of quotes, or -1 on allocation failure.
+int evaluate_boolean_query(const QueryIndex *index, const BooleanNode *query, int **ids);
+
+#endif // BOOLEAN_OPERATIONS_H
@@ -5,8 +5,8 @@
 #include "word_processing.h" // For add_citation_to_word
 
 // Creates a new BST node
-static BSTNode* create_bst_node(WordInfo *wordInfo) {
-    BSTNode *newNode = (BSTNode *)malloc(sizeof(BSTNode));
+static BSTNode* create_bst_node(WordInfo *wordInfo, IndexArena *arena) {
+    BSTNode *newNode = (BSTNode *)arena_alloc(&arena->slabs[SLAB_BST], sizeof(BSTNode));
     if (!newNode) {
         perror("Failed to allocate BST node");
         return NULL; // Indicate failure
@@ -18,7 +18,7 @@ static BSTNode* create_bst_node(WordInfo *wordInfo) {
 }
 
 // Inserts a WordInfo pointer into the BST (Recursive)
-BSTNode* insert_bst(BSTNode *root, WordInfo *wordInfo, const char *quote, const char *movie, int year) {
+BSTNode* insert_bst(BSTNode *root, WordInfo *wordInfo, IndexArena *arena) {
     if (root == NULL) {
         // WordInfo should already exist (created by vector insert)
         // We just create the BST node pointing to it.
@@ -28,20 +28,20 @@ BSTNode* insert_bst(BSTNode *root, WordInfo *wordInfo, const char *quote, const
         // If the node *already* existed in the BST (handled below), then
         // frequency/citation were *also* handled by the vector insert.
         // So, no need to update frequency/citations here.
-        return create_bst_node(wordInfo);
+        return create_bst_node(wordInfo, arena);
     }
 
     // Compare based on the word in the WordInfo struct
     int cmp = strcmp(wordInfo->word, root->data->word);
 
     if (cmp < 0) {
-        root->left = insert_bst(root->left, wordInfo, quote, movie, year);
+        root->left = insert_bst(root->left, wordInfo, arena);
     } else if (cmp > 0) {
-        root->right = insert_bst(root->right, wordInfo, quote, movie, year);
+        root->right = insert_bst(root->right, wordInfo, arena);
     } else {
         // Word already exists in the BST (node exists).
-        // The actual frequency update and citation add happened
-        // when insert_sorted_vector found the existing WordInfo.
+        // The node points to the same WordInfo as the vector, whose
+        // frequency and postings the loader already updated.
         // No action needed here for the BST node itself.
         ; // Do nothing, node already points to the updated WordInfo
     }
@@ -50,6 +50,24 @@ BSTNode* insert_bst(BSTNode *root, WordInfo *wordInfo, const char *quote, const
 }
 
 
+// Builds the subtree for vec->words[low..high], rooted at the middle word
+static BSTNode* build_bst_range(WordInfo **words, int low, int high, IndexArena *arena) {
+    if (low > high) return NULL;
+
+    int mid = low + (high - low) / 2;
+    BSTNode *node = create_bst_node(words[mid], arena);
+    if (!node) return NULL;
+    node->left = build_bst_range(words, low, mid - 1, arena);
+    node->right = build_bst_range(words, mid + 1, high, arena);
+    return node;
+}
+
+// Builds a perfectly balanced BST from the sorted vector (each word visited once)
+BSTNode* build_bst_from_sorted_vector(const WordVector *vec, IndexArena *arena) {
+    if (!vec || vec->size == 0) return NULL;
+    return build_bst_range(vec->words, 0, vec->size - 1, arena);
+}
+
 // Searches for a word in the BST (Recursive)
 WordInfo* search_bst(BSTNode *root, const char *word) {
     if (root == NULL) {
@@ -66,14 +84,3 @@ WordInfo* search_bst(BSTNode *root, const char *word) {
         return search_bst(root->right, word);
     }
 }
-
-// Frees the memory allocated for the BST nodes (not the WordInfo structs).
-void free_bst(BSTNode *root) {
-    if (root != NULL) {
-        free_bst(root->left);
-        free_bst(root->right);
-        // IMPORTANT: Only free the node, not root->data (WordInfo)
-        // as it's owned by the vector.
-        free(root);
-    }
-}
\ No newline at end of file
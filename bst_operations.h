@@ -2,17 +2,20 @@
 #define BST_OPERATIONS_H
 
 #include "structures.h"
+#include "arena.h"
 
 // Inserts a WordInfo pointer into the BST.
 // Does NOT duplicate WordInfo, assumes pointer is valid and managed elsewhere.
 // Updates frequency and citations if word already exists.
-BSTNode* insert_bst(BSTNode *root, WordInfo *wordInfo, const char *quote, const char *movie, int year);
+// New nodes are allocated from the BST slab of the index arena.
+BSTNode* insert_bst(BSTNode *root, WordInfo *wordInfo, IndexArena *arena);
+
+// Builds a perfectly balanced BST over the sorted vector in O(n).
+// Nodes are allocated from the BST slab of the index arena.
+BSTNode* build_bst_from_sorted_vector(const WordVector *vec, IndexArena *arena);
 
 // Searches for a word in the BST.
 // Returns a pointer to the WordInfo if found, NULL otherwise.
 WordInfo* search_bst(BSTNode *root, const char *word);
 
-// Frees the memory allocated for the BST nodes (not the WordInfo structs).
-void free_bst(BSTNode *root);
-
 #endif // BST_OPERATIONS_H
\ No newline at end of file
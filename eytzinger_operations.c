@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "eytzinger_operations.h"
+#include "mem_accounting.h"
+
+#define CACHE_LINE_SIZE 64
+#define KEYS_PER_CACHE_LINE (CACHE_LINE_SIZE / sizeof(unsigned long long))
+
+// Packs the first 8 bytes of a word big-endian, padding with zeros.
+// Words never contain NUL, so a shorter word still sorts before its extensions.
+static unsigned long long word_prefix(const char *word) {
+    unsigned long long prefix = 0;
+    int i = 0;
+    for (; i < 8 && word[i]; i++) {
+        prefix = (prefix << 8) | (unsigned char)word[i];
+    }
+    return prefix << (8 * (8 - i));
+}
+
+// In-order walk of the implicit tree, handing out the sorted words one by one
+static int fill_eytzinger(EytzingerIndex *index, const WordVector *vec, int next, int slot) {
+    if (slot <= index->size) {
+        next = fill_eytzinger(index, vec, next, 2 * slot);
+        index->words[slot] = vec->words[next];
+        index->prefixes[slot] = word_prefix(vec->words[next]->word);
+        next++;
+        next = fill_eytzinger(index, vec, next, 2 * slot + 1);
+    }
+    return next;
+}
+
+int build_eytzinger_from_vector(EytzingerIndex *index, const WordVector *vec) {
+    index->size = vec->size;
+
+    // The prefix array is cache-line aligned so the 8 descendants three levels
+    // below slot k (slots 8k..8k+7) always share one line.
+    size_t prefix_bytes = (size_t)(vec->size + 1) * sizeof(unsigned long long);
+    prefix_bytes = (prefix_bytes + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+    index->prefixes = (unsigned long long *)mem_aligned_alloc(MEM_EYTZINGER, CACHE_LINE_SIZE, prefix_bytes);
+    index->words = (WordInfo **)mem_alloc(MEM_EYTZINGER, (size_t)(vec->size + 1) * sizeof(WordInfo *));
+    if (!index->prefixes || !index->words) {
+        perror("Failed to allocate Eytzinger layout");
+        free_eytzinger(index);
+        return 0;
+    }
+
+    index->prefixes[0] = 0;
+    index->words[0] = NULL;
+    fill_eytzinger(index, vec, 0, 1);
+    return 1;
+}
+
+// Branch-free descent to the lower bound of the word. Only the prefix array is
+// touched on the way down, and the line three levels ahead is prefetched while
+// the current level is compared.
+WordInfo* search_eytzinger(const EytzingerIndex *index, const char *word) {
+    if (!index->prefixes || index->size == 0) return NULL;
+
+    unsigned long long prefix = word_prefix(word);
+    size_t slot = 1;
+    size_t size = (size_t)index->size;
+
+    while (slot <= size) {
+        __builtin_prefetch(index->prefixes + slot * KEYS_PER_CACHE_LINE);
+        unsigned long long key = index->prefixes[slot];
+        int greater = prefix > key || (prefix == key && strcmp(word, index->words[slot]->word) > 0);
+        slot = 2 * slot + greater;
+    }
+
+    // Undo the final run of right turns: what remains is the first word >= the query
+    slot >>= __builtin_ffsll(~(long long)slot);
+    if (slot == 0 || index->prefixes[slot] != prefix) {
+        return NULL; // Not found
+    }
+    WordInfo *candidate = index->words[slot];
+    return strcmp(candidate->word, word) == 0 ? candidate : NULL;
+}
+
+void free_eytzinger(EytzingerIndex *index) {
+    if (index) {
+        mem_free(index->prefixes);
+        mem_free(index->words);
+        index->prefixes = NULL;
+        index->words = NULL;
+        index->size = 0;
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef EYTZINGER_OPERATIONS_H
+#define EYTZINGER_OPERATIONS_H
+
+#include "structures.h"
+
+// Builds the Eytzinger layout from the sorted vector in O(n).
+// Does NOT duplicate WordInfo. Returns 1 on success, 0 on allocation failure.
+int build_eytzinger_from_vector(EytzingerIndex *index, const WordVector *vec);
+
+// Searches for a word in the Eytzinger layout.
+// Returns a pointer to the WordInfo if found, NULL otherwise.
+WordInfo* search_eytzinger(const EytzingerIndex *index, const char *word);
+
+// Frees the layout arrays (not the WordInfo structs).
+void free_eytzinger(EytzingerIndex *index);
+
+#endif // EYTZINGER_OPERATIONS_H
@@ -3,15 +3,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "file_parser.h"
 #include "word_processing.h"
 #include "array_operations.h"
 #include "bst_operations.h"
 #include "avl_operations.h"
+#include "freq_avl_operations.h"
+#include "radix_operations.h"
+#include "quote_pool.h"
+#include "posting_operations.h"
+#include "hash_operations.h"
+#include "mapped_file.h"
 #include "utils.h"
+#include "tokenizer.h"
+#include "mem_accounting.h"
 
-#define MAX_LINE_LENGTH 2048
-#define INITIAL_VECTOR_CAPACITY 1000
+#define MAX_YEAR_LENGTH 19
+#define MAX_LOAD_THREADS 64
+#define MIN_AUTO_CHUNK_SIZE (256 * 1024) // Pedaços menores não compensam criar uma thread
 
 static void trim_quotes_whitespace(char *str) {
     if (!str) return;
@@ -35,107 +46,789 @@ static void trim_quotes_whitespace(char *str) {
     }
 }
 
-LoadTimes load_data_from_file(const char *filename, WordVector *vec, BSTNode **bst_root, AVLNode **avl_root) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("Falha ao abrir arquivo.");
-        LoadTimes times = { -1.0, -1.0, -1.0 };
-        return times;
+// Procura 'c' em [start, end), como strchr limitado ao fim da linha
+static const char* find_in_line(const char *start, const char *end, char c) {
+    return start < end ? (const char *)memchr(start, c, end - start) : NULL;
+}
+
+static LoadTimes failed_load_times(void) {
+    LoadTimes times = { .vector_time_ms = -1.0, .bst_time_ms = -1.0, .avl_time_ms = -1.0, .bst_bulk_time_ms = -1.0,
+                        .avl_bulk_time_ms = -1.0, .hash_time_ms = -1.0, .parse_time_ms = -1.0,
+                        .local_build_time_ms = -1.0, .merge_time_ms = -1.0, .tree_build_time_ms = -1.0 };
+    return times;
+}
+
+// --- Carregamento em paralelo ---
+
+// Aviso de ano inválido, impresso depois que os números globais das linhas são conhecidos
+typedef struct YearWarning {
+    int line; // Linha dentro do pedaço
+    char text[MAX_YEAR_LENGTH + 1];
+} YearWarning;
+
+// Estado de uma thread de carregamento, responsável por um pedaço de linhas inteiras do arquivo
+typedef struct LoadWorker {
+    const char *start;
+    const char *end;
+    int compare_incremental;
+    int positions;                  // Grava as posições das palavras nas frases
+    IndexArena arena;               // Listas de citações e títulos; incorporada à arena do índice no final
+    Arena scratch;                  // Palavras normalizadas por cópia; liberada após a junção
+    QuotePool pool;                 // Frases e filmes do pedaço, com IDs locais
+    OccurrenceList occurrences;
+    char *token_text;               // Buffer reutilizado do tokenizador
+    Token *tokens;
+    int token_text_capacity;
+    int line_count;
+    YearWarning *warnings;
+    int warning_count;
+    int warning_capacity;
+    int quote_base;                 // ID global da primeira frase do pedaço
+    int *movie_map;                 // ID local do filme -> ID global
+    LocalVocabulary *vocabulary;
+    int *token_entries;             // Palavra local de cada ocorrência, na ordem do arquivo
+    int ok;
+} LoadWorker;
+
+// Tokeniza a frase diretamente sobre o arquivo mapeado e guarda cada palavra normalizada.
+// As regras são as de normalize_word: só letras, em minúsculas, com mais de 3 caracteres.
+// Palavras que já estão normalizadas são guardadas como uma visão do arquivo, sem cópia;
+// as demais saem do buffer do tokenizador e são copiadas para a arena temporária.
+static void collect_quote_words(const char *quote, int length, int quote_id, LoadWorker *worker) {
+    if (length > worker->token_text_capacity) {
+        int capacity = length > 2 * worker->token_text_capacity ? length : 2 * worker->token_text_capacity;
+        char *text = (char *)realloc(worker->token_text, capacity + TOKENIZER_SCRATCH_SLACK);
+        if (text) worker->token_text = text;
+        Token *tokens = (Token *)realloc(worker->tokens, (capacity / 4 + 1) * sizeof(Token));
+        if (tokens) worker->tokens = tokens;
+        if (!text || !tokens) {
+            fprintf(stderr, "Aviso: falha ao tokenizar a frase %d, pulando.\n", quote_id);
+            return;
+        }
+        worker->token_text_capacity = capacity;
     }
 
-    char line[MAX_LINE_LENGTH];
-    char quote_buffer[MAX_LINE_LENGTH];
-    char movie_buffer[MAX_LINE_LENGTH];
-    char year_str[20];
+    int count = tokenize_fold(quote, length, worker->token_text, worker->tokens);
+    int stored = 0;
+    for (int t = 0; t < count; t++) {
+        const Token *token = &worker->tokens[t];
+        const char *word = token->text;
+        if (token->folded) {
+            word = arena_strndup(&worker->scratch, token->text, token->length);
+            if (!word) {
+                fprintf(stderr, "Aviso: falha ao guardar uma palavra da frase %d, pulando.\n", quote_id);
+                continue;
+            }
+        }
+        if (!append_occurrence(&worker->occurrences, word, token->length, quote_id, token->position)) {
+            fprintf(stderr, "Aviso: falha ao guardar uma palavra da frase %d, pulando.\n", quote_id);
+            continue;
+        }
+        stored++;
+    }
+    // O tamanho da frase na busca ranqueada: só as palavras indexadas, com repetições
+    worker->pool.quotes[quote_id].word_count = stored;
+    worker->pool.word_total += stored;
+}
 
-    init_vector(vec, INITIAL_VECTOR_CAPACITY);
-    *bst_root = NULL;
-    *avl_root = NULL;
+// Estado de uma thread da junção: um intervalo [low, high) de palavras de todos os pedaços
+typedef struct MergeWorker {
+    LocalVocabulary *vocabularies;
+    int vocabulary_count;
+    const LocalWord *low;
+    const LocalWord *high;
+    IndexArena arena;               // WordInfo, palavras e listas juntadas; incorporada à arena do índice no final
+    WordInfo **words;
+    int size;
+    int ok;
+} MergeWorker;
 
-    LoadTimes times = {0.0, 0.0, 0.0};
-    int line_num = 0;
+// Construção de uma das estruturas a partir do vetor. Cada estrutura usa sua própria
+// slab da arena (a tabela hash usa malloc), então as três podem ser construídas juntas.
+typedef enum TreeKind { TREE_BST, TREE_AVL, TREE_HASH, TREE_KIND_COUNT } TreeKind;
 
-    printf("Carregando os dados do arquivo '%s'...\n", filename);
+typedef struct TreeBuildTask {
+    TreeKind kind;
+    const WordVector *vec;
+    IndexArena *arena;
+    BSTNode **bst_root;
+    AVLNode **avl_root;
+    HashIndex *hash_index;
+    double elapsed_ms;
+} TreeBuildTask;
 
-    while (fgets(line, sizeof(line), file)) {
-        line_num++;
-        line[strcspn(line, "\r\n")] = 0;
+// Executa fn sobre 'count' itens: o primeiro na thread atual, os demais em threads novas.
+// Se uma thread não puder ser criada, o item é processado na thread atual.
+static void run_in_parallel(void *(*fn)(void *), void *items, size_t item_size, int count) {
+    pthread_t threads[MAX_LOAD_THREADS];
+    int started[MAX_LOAD_THREADS] = {0};
 
-        char *first_quote = strchr(line, '"');
+    for (int i = 1; i < count; i++) {
+        started[i] = pthread_create(&threads[i], NULL, fn, (char *)items + i * item_size) == 0;
+    }
+    fn(items);
+    for (int i = 1; i < count; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            fn((char *)items + i * item_size);
+        }
+    }
+}
+
+static void add_year_warning(LoadWorker *worker, int line, const char *text) {
+    if (worker->warning_count >= worker->warning_capacity) {
+        int new_capacity = worker->warning_capacity ? worker->warning_capacity * 2 : 16;
+        YearWarning *new_warnings = (YearWarning *)realloc(worker->warnings, new_capacity * sizeof(YearWarning));
+        if (!new_warnings) return; // O aviso é perdido, mas o ano já foi tratado
+        worker->warnings = new_warnings;
+        worker->warning_capacity = new_capacity;
+    }
+    YearWarning *warning = &worker->warnings[worker->warning_count++];
+    warning->line = line;
+    strcpy(warning->text, text);
+}
+
+// Fase 1: separa as linhas do pedaço, registra frases e filmes no pool local e tokeniza as frases
+static void* parse_chunk(void *arg) {
+    LoadWorker *worker = (LoadWorker *)arg;
+    const char *line = worker->start;
+
+    while (line < worker->end) {
+        const char *newline = find_in_line(line, worker->end, '\n');
+        const char *next_line = newline ? newline + 1 : worker->end;
+        const char *line_end = newline ? newline : worker->end;
+        const char *carriage_return = find_in_line(line, line_end, '\r');
+        if (carriage_return) line_end = carriage_return;
+        int line_num = ++worker->line_count;
+
+        const char *first_quote = find_in_line(line, line_end, '"');
+        line = next_line;
         if (!first_quote) continue;
 
-        char *end_first_quote = strchr(first_quote + 1, '"');
+        const char *end_first_quote = find_in_line(first_quote + 1, line_end, '"');
         if (!end_first_quote) continue;
 
-        char *comma1 = strchr(end_first_quote, ',');
+        const char *comma1 = find_in_line(end_first_quote, line_end, ',');
         if (!comma1) continue;
 
-        char *second_quote = strchr(comma1, '"');
+        const char *second_quote = find_in_line(comma1, line_end, '"');
         if (!second_quote) continue;
 
-        char *end_second_quote = strchr(second_quote + 1, '"');
+        const char *end_second_quote = find_in_line(second_quote + 1, line_end, '"');
         if (!end_second_quote) continue;
 
-        char *comma2 = strchr(end_second_quote, ',');
+        const char *comma2 = find_in_line(end_second_quote, line_end, ',');
         if (!comma2) continue;
 
-        char *third_quote = strchr(comma2, '"');
+        const char *third_quote = find_in_line(comma2, line_end, '"');
         if (!third_quote) continue;
 
-        char *end_third_quote = strchr(third_quote + 1, '"');
+        const char *end_third_quote = find_in_line(third_quote + 1, line_end, '"');
         if (!end_third_quote) continue;
 
-        strncpy(quote_buffer, first_quote + 1, end_first_quote - first_quote - 1);
-        quote_buffer[end_first_quote - first_quote - 1] = '\0';
-
-        strncpy(movie_buffer, second_quote + 1, end_second_quote - second_quote - 1);
-        movie_buffer[end_second_quote - second_quote - 1] = '\0';
+        const char *quote = first_quote + 1;
+        int quote_length = (int)(end_first_quote - quote);
+        const char *movie = second_quote + 1;
+        int movie_length = (int)(end_second_quote - movie);
 
-        strncpy(year_str, third_quote + 1, end_third_quote - third_quote - 1);
-        year_str[end_third_quote - third_quote - 1] = '\0';
+        char year_str[MAX_YEAR_LENGTH + 1];
+        size_t year_length = (size_t)(end_third_quote - third_quote - 1);
+        if (year_length > MAX_YEAR_LENGTH) year_length = MAX_YEAR_LENGTH;
+        memcpy(year_str, third_quote + 1, year_length);
+        year_str[year_length] = '\0';
 
         int year = atoi(year_str);
         if (year == 0 && strcmp(year_str, "0") != 0) {
-            fprintf(stderr, "Aviso: Formato do ano inválido na linha %d: '%s'. Usando 0.\n", line_num, year_str);
+            add_year_warning(worker, line_num, year_str);
             year = 0;
         }
 
-        // --- Processa as palavras da frase ---
-        char *quote_copy = strdup(quote_buffer);
-        if (!quote_copy) {
-            perror("Falha ao copiar a frase");
+        // --- Registra a frase (sem cópia) e o filme (uma cópia por título) no pool local ---
+        int movie_id = intern_movie(&worker->pool, movie, movie_length);
+        int quote_id = movie_id >= 0 ? add_quote(&worker->pool, quote, quote_length, movie_id, year) : -1;
+        if (quote_id < 0) {
+            fprintf(stderr, "Aviso: falha ao armazenar uma frase, pulando.\n");
             continue;
         }
-        char *token = strtok(quote_copy, " .,!?;:()[]{}-_\t\n\r");
-
-        while (token != NULL) {
-            char *normalized = normalize_word(token);
-            if (normalized) {
-                clock_t start_vec = timer_start();
-                WordInfo *word_in_vector = insert_sorted_vector(vec, normalized, quote_buffer, movie_buffer, year);
-                times.vector_time_ms += timer_stop(start_vec);
-
-                if (word_in_vector) {
-                    clock_t start_bst = timer_start();
-                    *bst_root = insert_bst(*bst_root, word_in_vector, quote_buffer, movie_buffer, year);
-                    times.bst_time_ms += timer_stop(start_bst);
-
-                    clock_t start_avl = timer_start();
-                    *avl_root = insert_avl(*avl_root, word_in_vector, quote_buffer, movie_buffer, year);
-                    times.avl_time_ms += timer_stop(start_avl);
-                } else {
-                    fprintf(stderr, "Aviso: falha ao processar a palavra '%s' por completo, pulando inserção na "
-                                    "árvore.\n", normalized);
+
+        // --- Processa as palavras da frase ---
+        collect_quote_words(quote, quote_length, quote_id, worker);
+    }
+    worker->ok = 1;
+    return NULL;
+}
+
+// Fase 2: ordena as ocorrências do pedaço e agrupa as repetidas no vocabulário local
+static void* build_chunk_vocabulary(void *arg) {
+    LoadWorker *worker = (LoadWorker *)arg;
+    size_t count = worker->occurrences.count;
+
+    if (worker->compare_incremental) {
+        worker->token_entries = (int *)mem_alloc(MEM_LOAD_SCRATCH, (count ? count : 1) * sizeof(int));
+        if (!worker->token_entries) {
+            perror("Falha ao alocar a lista de palavras por ocorrência");
+            worker->ok = 0;
+            return NULL;
+        }
+    }
+    worker->ok = collapse_occurrences(&worker->occurrences, worker->quote_base, worker->positions, &worker->arena,
+                                      worker->vocabulary, worker->token_entries);
+    return NULL;
+}
+
+// Fase 3: junta um intervalo de palavras de todos os vocabulários locais
+static void* merge_vocabulary_range(void *arg) {
+    MergeWorker *worker = (MergeWorker *)arg;
+    worker->ok = merge_local_vocabularies(worker->vocabularies, worker->vocabulary_count, worker->low, worker->high,
+                                          &worker->arena, &worker->words, &worker->size);
+    return NULL;
+}
+
+// Fase 4: constrói uma das estruturas de busca a partir do vetor ordenado
+static void* build_structure(void *arg) {
+    TreeBuildTask *task = (TreeBuildTask *)arg;
+    double start = wall_clock_ms();
+    switch (task->kind) {
+        case TREE_BST:
+            *task->bst_root = build_bst_from_sorted_vector(task->vec, task->arena);
+            break;
+        case TREE_AVL:
+            *task->avl_root = build_avl_from_sorted_vector(task->vec, task->arena);
+            break;
+        default:
+            if (!build_hash_index_from_vector(task->hash_index, task->vec)) {
+                fprintf(stderr, "Aviso: falha ao construir a tabela hash.\n");
+            }
+            break;
+    }
+    task->elapsed_ms = wall_clock_ms() - start;
+    return NULL;
+}
+
+// Número de threads a usar: o pedido nas opções, ou um por processador (0) limitado pelo tamanho do arquivo
+static int resolve_thread_count(const LoadOptions *options, size_t input_size) {
+    int threads = options ? options->threads : 0;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+        size_t by_size = input_size / MIN_AUTO_CHUNK_SIZE + 1;
+        if ((size_t)threads > by_size) threads = (int)by_size;
+    }
+    return threads > MAX_LOAD_THREADS ? MAX_LOAD_THREADS : threads;
+}
+
+// Divide o arquivo em 'count' pedaços de tamanho parecido, sempre em fim de linha
+static void split_into_chunks(const char *data, size_t size, LoadWorker *workers, int count) {
+    const char *data_end = data + size;
+    const char *chunk_start = data;
+    for (int i = 0; i < count; i++) {
+        const char *chunk_end = (i == count - 1) ? data_end : data + size * (size_t)(i + 1) / (size_t)count;
+        if (chunk_end <= chunk_start) {
+            chunk_end = chunk_start;
+        } else if (chunk_end < data_end) {
+            const char *newline = (const char *)memchr(chunk_end, '\n', data_end - chunk_end);
+            chunk_end = newline ? newline + 1 : data_end;
+        }
+        workers[i].start = chunk_start;
+        workers[i].end = chunk_end;
+        chunk_start = chunk_end;
+    }
+}
+
+static void free_load_worker(LoadWorker *worker) {
+    free_occurrence_list(&worker->occurrences);
+    free_quote_pool(&worker->pool);
+    free(worker->warnings);
+    free(worker->movie_map);
+    mem_free(worker->token_entries);
+    free(worker->token_text);
+    free(worker->tokens);
+    arena_release(&worker->scratch);
+    index_arena_release(&worker->arena); // Vazia se já foi incorporada ao índice
+}
+
+// Threads das fases 1 a 3 de uma leitura: pedaços do arquivo, vocabulários locais e junção
+typedef struct LoadJob {
+    LoadWorker *workers;
+    LocalVocabulary *vocabularies;
+    MergeWorker *mergers;
+    int thread_count;
+    int merge_count;
+} LoadJob;
+
+static int init_load_job(LoadJob *job, int thread_count) {
+    job->thread_count = thread_count;
+    job->merge_count = 0;
+    job->workers = (LoadWorker *)calloc(thread_count, sizeof(LoadWorker));
+    job->vocabularies = (LocalVocabulary *)calloc(thread_count, sizeof(LocalVocabulary));
+    job->mergers = (MergeWorker *)calloc(thread_count, sizeof(MergeWorker));
+    if (!job->workers || !job->vocabularies || !job->mergers) {
+        perror("Falha ao alocar as threads de carregamento");
+        free(job->workers);
+        free(job->vocabularies);
+        free(job->mergers);
+        return 0;
+    }
+    return 1;
+}
+
+// Tudo o que as threads alocaram passa a pertencer ao índice
+static void adopt_load_job(LoadJob *job, IndexArena *arena) {
+    for (int i = 0; i < job->thread_count; i++) {
+        index_arena_adopt(arena, &job->workers[i].arena);
+    }
+    for (int i = 0; i < job->merge_count; i++) {
+        index_arena_adopt(arena, &job->mergers[i].arena);
+    }
+}
+
+// Libera as threads; as arenas que não foram incorporadas ao índice são liberadas junto
+static void free_load_job(LoadJob *job) {
+    for (int i = 0; i < job->thread_count; i++) {
+        free_load_worker(&job->workers[i]);
+        free_local_vocabulary(&job->vocabularies[i]);
+    }
+    for (int i = 0; i < job->merge_count; i++) {
+        mem_free(job->mergers[i].words);
+        index_arena_release(&job->mergers[i].arena);
+    }
+    free(job->workers);
+    free(job->vocabularies);
+    free(job->mergers);
+}
+
+// Fases 1 a 3 sobre o arquivo mapeado: as frases entram no pool depois das que ele já tem,
+// e as palavras do arquivo saem ordenadas em 'vec', com as citações já nos IDs do pool.
+// Preenche os tempos de leitura (a partir de start_parse), vocabulários locais e junção.
+// Retorna 1 em caso de sucesso, 0 em falha de memória.
+static int build_file_vocabulary(LoadJob *job, const MappedFile *source, const LoadOptions *options, QuotePool *pool,
+                                 WordVector *vec, LoadTimes *times, double start_parse, PerfCounters *perf) {
+    const int thread_count = job->thread_count;
+    LoadWorker *workers = job->workers;
+    LocalVocabulary *vocabularies = job->vocabularies;
+    MergeWorker *mergers = job->mergers;
+    int ok = 1;
+
+    vec->words = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+
+    // --- Fase 1: leitura e tokenização de cada pedaço ---
+    if (perf) perf_start(perf);
+    split_into_chunks(source->data, source->size, workers, thread_count);
+    for (int i = 0; i < thread_count; i++) {
+        LoadWorker *worker = &workers[i];
+        worker->compare_incremental = options && options->compare_incremental_trees;
+        worker->positions = options && options->positions;
+        worker->vocabulary = &vocabularies[i];
+        index_arena_init(&worker->arena);
+        arena_init(&worker->scratch);
+        init_quote_pool(&worker->pool, &worker->arena.slabs[SLAB_STRINGS]);
+    }
+    run_in_parallel(parse_chunk, workers, sizeof(LoadWorker), thread_count);
+
+    // Os pools locais são anexados em ordem, então os IDs globais são os de uma leitura sequencial
+    int line_base = 0;
+    for (int i = 0; i < thread_count && ok; i++) {
+        LoadWorker *worker = &workers[i];
+        for (int w = 0; w < worker->warning_count; w++) {
+            fprintf(stderr, "Aviso: Formato do ano inválido na linha %d: '%s'. Usando 0.\n",
+                    line_base + worker->warnings[w].line, worker->warnings[w].text);
+        }
+        line_base += worker->line_count;
+
+        worker->movie_map = (int *)malloc((worker->pool.movie_count ? worker->pool.movie_count : 1) * sizeof(int));
+        ok = worker->movie_map && merge_quote_pool(pool, &worker->pool, worker->movie_map, &worker->quote_base);
+    }
+    times->parse_time_ms = wall_clock_ms() - start_parse;
+    if (perf) perf_stop(perf, &times->perf[LOAD_PHASE_PARSE]);
+
+    // --- Fase 2: vocabulário local de cada pedaço ---
+    double start_local = wall_clock_ms();
+    if (perf) perf_start(perf);
+    if (ok) {
+        run_in_parallel(build_chunk_vocabulary, workers, sizeof(LoadWorker), thread_count);
+        for (int i = 0; i < thread_count; i++) {
+            ok = ok && workers[i].ok;
+        }
+    }
+    times->local_build_time_ms = wall_clock_ms() - start_local;
+    if (perf) perf_stop(perf, &times->perf[LOAD_PHASE_LOCAL]);
+
+    // --- Fase 3: junção dos vocabulários, dividida por intervalos de palavras ---
+    double start_merge = wall_clock_ms();
+    if (perf) perf_start(perf);
+    if (ok) {
+        // Os limites dos intervalos são tirados do maior vocabulário local
+        const LocalVocabulary *largest = &vocabularies[0];
+        for (int i = 1; i < thread_count; i++) {
+            if (vocabularies[i].size > largest->size) largest = &vocabularies[i];
+        }
+        const LocalWord *low = NULL;
+        int last_split = 0;
+        for (int i = 1; i <= thread_count; i++) {
+            int split = (int)((long long)largest->size * i / thread_count);
+            if (i < thread_count && (split <= last_split || split >= largest->size)) continue;
+            MergeWorker *merger = &mergers[job->merge_count++];
+            merger->vocabularies = vocabularies;
+            merger->vocabulary_count = thread_count;
+            merger->low = low;
+            merger->high = i < thread_count ? &largest->words[split] : NULL;
+            index_arena_init(&merger->arena);
+            low = merger->high;
+            last_split = split;
+        }
+        run_in_parallel(merge_vocabulary_range, mergers, sizeof(MergeWorker), job->merge_count);
+
+        int total = 0;
+        for (int i = 0; i < job->merge_count; i++) {
+            ok = ok && mergers[i].ok;
+            total += mergers[i].size;
+        }
+        if (ok) {
+            vec->words = (WordInfo **)mem_alloc(MEM_VECTOR, (total ? total : 1) * sizeof(WordInfo *));
+            if (vec->words) {
+                vec->capacity = total ? total : 1;
+                for (int i = 0; i < job->merge_count; i++) {
+                    memcpy(vec->words + vec->size, mergers[i].words, mergers[i].size * sizeof(WordInfo *));
+                    vec->size += mergers[i].size;
                 }
+            } else {
+                perror("Falha ao alocar o vetor de palavras");
+                ok = 0;
+            }
+        }
+    }
+    times->merge_time_ms = wall_clock_ms() - start_merge;
+    if (perf) perf_stop(perf, &times->perf[LOAD_PHASE_MERGE]);
+    times->vector_time_ms = times->local_build_time_ms + times->merge_time_ms;
+    return ok;
+}
+
+LoadTimes load_data_from_file(const char *filename, const LoadOptions *options, IndexArena *arena, QuotePool *pool,
+                              WordVector *vec, BSTNode **bst_root, AVLNode **avl_root, HashIndex *hash_index) {
+    double start_parse = wall_clock_ms();
+
+    // As frases do índice apontam para o arquivo mapeado, que passa a pertencer ao pool
+    index_arena_init(arena);
+    init_quote_pool(pool, &arena->slabs[SLAB_STRINGS]);
+    if (!map_file(filename, &pool->source)) {
+        return failed_load_times();
+    }
+
+    vec->words = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+    *bst_root = NULL;
+    *avl_root = NULL;
+    hash_index->slots = NULL;
+    hash_index->capacity = 0;
+    hash_index->size = 0;
 
-                free(normalized);
+    const int thread_count = resolve_thread_count(options, pool->source.size);
+    LoadTimes times = { .bst_time_ms = -1.0, .avl_time_ms = -1.0, .input_bytes = pool->source.size,
+                        .threads = thread_count };
+    const int compare_incremental = options && options->compare_incremental_trees;
+
+    LoadJob job;
+    if (!init_load_job(&job, thread_count)) {
+        free_quote_pool(pool);
+        return failed_load_times();
+    }
+
+    const int quiet = options && options->quiet;
+    if (!quiet) {
+        printf("Carregando os dados do arquivo '%s' (%d thread%s)...\n", filename, thread_count,
+               thread_count > 1 ? "s" : "");
+    }
+
+    // Os contadores seguem também as threads da carga, somadas quando elas terminam
+    PerfCounters perf_counters;
+    PerfCounters *perf = NULL;
+    if (options && options->perf_counters && open_perf_counters(&perf_counters, 1) > 0) {
+        perf = &perf_counters;
+        times.perf_recorded = 1;
+    }
+
+    // --- Fases 1 a 3: leitura, vocabulários locais e junção no vetor ---
+    int ok = build_file_vocabulary(&job, &pool->source, options, pool, vec, &times, start_parse, perf);
+    adopt_load_job(&job, arena);
+
+    // --- Fase 4: ABB, AVL e tabela hash a partir do vetor ordenado, em paralelo ---
+    if (ok) {
+        double start_trees = wall_clock_ms();
+        if (perf) perf_start(perf);
+        TreeBuildTask tasks[TREE_KIND_COUNT];
+        for (int k = 0; k < TREE_KIND_COUNT; k++) {
+            tasks[k] = (TreeBuildTask){ (TreeKind)k, vec, arena, bst_root, avl_root, hash_index, 0.0 };
+        }
+        if (thread_count > 1) {
+            run_in_parallel(build_structure, tasks, sizeof(TreeBuildTask), TREE_KIND_COUNT);
+        } else {
+            for (int k = 0; k < TREE_KIND_COUNT; k++) {
+                build_structure(&tasks[k]);
             }
-            token = strtok(NULL, " .,!?;:()[]{}-_\t\n\r");
         }
-        free(quote_copy);
+        times.bst_bulk_time_ms = tasks[TREE_BST].elapsed_ms;
+        times.avl_bulk_time_ms = tasks[TREE_AVL].elapsed_ms;
+        times.hash_time_ms = tasks[TREE_HASH].elapsed_ms;
+        times.tree_build_time_ms = wall_clock_ms() - start_trees;
+        if (perf) perf_stop(perf, &times.perf[LOAD_PHASE_TREES]);
     }
 
-    fclose(file);
-    printf("Carregamento dos dados completo. Foram processadas %d palavras únicas.\n", vec->size);
+    if (ok && compare_incremental) {
+        // --- Apenas para comparação: inserção palavra a palavra, na ordem do arquivo ---
+        IndexArena comparison_arena;
+        index_arena_init(&comparison_arena);
+        BSTNode *incremental_bst = NULL;
+        AVLNode *incremental_avl = NULL;
+
+        double start_bst = wall_clock_ms();
+        if (perf) perf_start(perf);
+        for (int c = 0; c < thread_count; c++) {
+            for (size_t i = 0; i < job.workers[c].occurrences.count; i++) {
+                WordInfo *info = job.vocabularies[c].merged[job.workers[c].token_entries[i]];
+                incremental_bst = insert_bst(incremental_bst, info, &comparison_arena);
+            }
+        }
+        times.bst_time_ms = wall_clock_ms() - start_bst;
+        if (perf) perf_stop(perf, &times.perf[LOAD_PHASE_BST_INCREMENTAL]);
+
+        double start_avl = wall_clock_ms();
+        if (perf) perf_start(perf);
+        for (int c = 0; c < thread_count; c++) {
+            for (size_t i = 0; i < job.workers[c].occurrences.count; i++) {
+                WordInfo *info = job.vocabularies[c].merged[job.workers[c].token_entries[i]];
+                incremental_avl = insert_avl(incremental_avl, info, &comparison_arena);
+            }
+        }
+        times.avl_time_ms = wall_clock_ms() - start_avl;
+        if (perf) perf_stop(perf, &times.perf[LOAD_PHASE_AVL_INCREMENTAL]);
+
+        index_arena_release(&comparison_arena);
+    }
+
+    free_load_job(&job);
+    if (perf) close_perf_counters(perf);
+
+    if (!ok) {
+        fprintf(stderr, "Erro: falha de memória ao montar o índice.\n");
+        free_vector(vec);
+        free_hash_index(hash_index);
+        free_quote_pool(pool);
+        index_arena_release(arena);
+        *bst_root = NULL;
+        *avl_root = NULL;
+        return failed_load_times();
+    }
+
+    if (!quiet) {
+        printf("Carregamento dos dados completo. Foram processadas %d palavras únicas.\n", vec->size);
+    }
+    return times;
+}
+
+// --- Anexação a um índice carregado ---
+
+// Insere as palavras novas de words[low..high] começando pela do meio, para que uma sequência
+// ordenada não vire uma lista na ABB
+static void insert_new_words(WordInfo **words, int low, int high, IndexArena *arena, BSTNode **bst_root,
+                             AVLNode **avl_root) {
+    if (low > high) return;
+    int mid = low + (high - low) / 2;
+    *bst_root = insert_bst(*bst_root, words[mid], arena);
+    *avl_root = insert_avl(*avl_root, words[mid], arena);
+    insert_new_words(words, low, mid - 1, arena, bst_root, avl_root);
+    insert_new_words(words, mid + 1, high, arena, bst_root, avl_root);
+}
+
+// Junta ao vetor as palavras novas, ordenadas e ausentes dele, de trás para frente:
+// só as palavras depois da primeira nova são deslocadas
+static int merge_new_words(WordVector *vec, WordInfo **words, int count) {
+    if (count == 0) return 1;
+    if (vec->size + count > vec->capacity) {
+        int new_capacity = vec->capacity ? vec->capacity : 1;
+        while (new_capacity < vec->size + count) {
+            new_capacity *= 2;
+        }
+        WordInfo **new_words = (WordInfo **)mem_realloc(MEM_VECTOR, vec->words, new_capacity * sizeof(WordInfo *));
+        if (!new_words) {
+            perror("Falha ao aumentar o vetor de palavras");
+            return 0;
+        }
+        vec->words = new_words;
+        vec->capacity = new_capacity;
+    }
+
+    int i = vec->size - 1, j = count - 1, k = vec->size + count - 1;
+    while (j >= 0) {
+        if (i >= 0 && strcmp(vec->words[i]->word, words[j]->word) > 0) {
+            vec->words[k--] = vec->words[i--];
+        } else {
+            vec->words[k--] = words[j--];
+        }
+    }
+    vec->size += count;
+    return 1;
+}
+
+AppendTimes append_data_from_file(const char *filename, const LoadOptions *options, IndexArena *arena,
+                                  QuotePool *pool, WordVector *vec, BSTNode **bst_root, AVLNode **avl_root,
+                                  HashIndex *hash_index, FreqAVLNode **freq_avl_root, RadixNode **radix_root) {
+    const double start = wall_clock_ms();
+    AppendTimes times;
+    memset(&times, 0, sizeof(times));
+    times.total_time_ms = -1.0;
+    times.index_kept = 1;
+
+    MappedFile file;
+    if (!map_file(filename, &file)) {
+        return times;
+    }
+
+    const int thread_count = resolve_thread_count(options, file.size);
+    times.input_bytes = file.size;
+    times.threads = thread_count;
+    const int old_quote_count = pool->quote_count;
+
+    LoadJob job;
+    if (!init_load_job(&job, thread_count)) {
+        unmap_file(&file);
+        return times;
+    }
+
+    const int quiet = options && options->quiet;
+    if (!quiet) {
+        printf("Anexando os dados do arquivo '%s' (%d thread%s)...\n", filename, thread_count,
+               thread_count > 1 ? "s" : "");
+    }
+
+    // --- Fases 1 a 3 só sobre o arquivo novo: as frases continuam a numeração do pool ---
+    LoadTimes file_times;
+    WordVector added;
+    LoadOptions file_options = options ? *options : (LoadOptions){0};
+    file_options.compare_incremental_trees = 0;
+    int ok = build_file_vocabulary(&job, &file, &file_options, pool, &added, &file_times, start, NULL);
+    times.parse_time_ms = file_times.parse_time_ms;
+    times.vocabulary_time_ms = file_times.vector_time_ms;
+
+    // Tudo o que pode faltar é reservado antes de mexer no índice, que fica intacto se falhar aqui
+    WordInfo **known = NULL;        // known[i]: WordInfo do índice com a palavra added.words[i], ou NULL
+    WordInfo **new_words = NULL;
+    FreqAVLNode **detached = NULL;  // Nós retirados da árvore de frequência, para reinserção
+    if (ok) {
+        const size_t count = added.size ? (size_t)added.size : 1;
+        known = (WordInfo **)malloc(count * sizeof(WordInfo *));
+        new_words = (WordInfo **)malloc(count * sizeof(WordInfo *));
+        detached = (FreqAVLNode **)malloc(count * sizeof(FreqAVLNode *));
+        if (!known || !new_words || !detached) perror("Falha ao alocar a anexação");
+        ok = known && new_words && detached && attach_source_file(pool, &file);
+    }
+    if (!ok) {
+        fprintf(stderr, "Erro: falha de memória ao anexar o arquivo; o índice não foi alterado.\n");
+        pool->quote_count = old_quote_count; // Títulos novos podem ficar sem frases, o que não muda as consultas
+        free(known);
+        free(new_words);
+        free(detached);
+        free_vector(&added);
+        free_load_job(&job);
+        unmap_file(&file);
+        return times;
+    }
+    // As palavras novas passam a pertencer ao índice. As entradas das palavras já indexadas
+    // ficam sem uso na arena depois de copiadas, ocupando memória proporcional ao arquivo novo.
+    adopt_load_job(&job, arena);
+    free_load_job(&job);
+    times.quote_count = pool->quote_count - old_quote_count;
+
+    // --- Separa as palavras já indexadas das novas ---
+    double phase_start = wall_clock_ms();
+    for (int i = 0; i < added.size; i++) {
+        known[i] = search_hash_index(hash_index, added.words[i]->word);
+        if (known[i]) {
+            times.updated_words++;
+        } else {
+            new_words[times.new_words++] = added.words[i];
+        }
+    }
+    times.postings_time_ms = wall_clock_ms() - phase_start;
+
+    // --- Árvore de frequência: retira as palavras que vão mudar, pela chave antiga ---
+    phase_start = wall_clock_ms();
+    int detached_count = 0;
+    for (int i = 0; i < added.size; i++) {
+        if (!known[i]) continue;
+        detached[detached_count] = NULL;
+        *freq_avl_root = remove_freq_avl(*freq_avl_root, known[i], &detached[detached_count]);
+        detached_count++;
+    }
+    times.freq_avl_time_ms = wall_clock_ms() - phase_start;
+
+    // --- Citações e frequências das palavras já indexadas: as frases novas vêm depois de todas ---
+    phase_start = wall_clock_ms();
+    for (int i = 0; i < added.size; i++) {
+        if (!known[i]) continue;
+        if (!append_posting_list(&known[i]->postings, &added.words[i]->postings, &arena->slabs[SLAB_POSTINGS]) ||
+            !append_position_list(&known[i]->positions, &added.words[i]->positions, &arena->slabs[SLAB_POSITIONS])) {
+            ok = 0;
+        }
+        known[i]->frequency += added.words[i]->frequency;
+        update_radix_frequency(*radix_root, known[i]);
+    }
+    times.postings_time_ms += wall_clock_ms() - phase_start;
+
+    // --- Árvore de frequência: reinsere os mesmos nós pela chave nova e insere as palavras novas ---
+    phase_start = wall_clock_ms();
+    detached_count = 0;
+    for (int i = 0; i < added.size; i++) {
+        if (!known[i]) continue;
+        FreqAVLNode *node = detached[detached_count++];
+        *freq_avl_root = node ? insert_freq_avl_node(*freq_avl_root, node)
+                              : insert_freq_avl(*freq_avl_root, known[i], arena);
+    }
+    for (int i = 0; i < times.new_words; i++) {
+        *freq_avl_root = insert_freq_avl(*freq_avl_root, new_words[i], arena);
+    }
+    times.freq_avl_time_ms += wall_clock_ms() - phase_start;
+
+    // --- Vetor ordenado ---
+    phase_start = wall_clock_ms();
+    ok = merge_new_words(vec, new_words, times.new_words) && ok;
+    times.vector_time_ms = wall_clock_ms() - phase_start;
+
+    // --- ABB, AVL, tabela hash e árvore radix: só as palavras novas ---
+    phase_start = wall_clock_ms();
+    insert_new_words(new_words, 0, times.new_words - 1, arena, bst_root, avl_root);
+    for (int i = 0; i < times.new_words && ok; i++) {
+        ok = insert_hash_index(hash_index, new_words[i]) && insert_radix(radix_root, new_words[i], arena);
+    }
+    times.tree_time_ms = wall_clock_ms() - phase_start;
+
+    free(known);
+    free(new_words);
+    free(detached);
+    free_vector(&added);
+
+    if (!ok) {
+        // O índice já foi alterado e não tem como voltar atrás
+        fprintf(stderr, "Erro: falha de memória ao anexar o arquivo; o índice foi descartado.\n");
+        free_vector(vec);
+        free_hash_index(hash_index);
+        free_quote_pool(pool);
+        index_arena_release(arena);
+        *bst_root = NULL;
+        *avl_root = NULL;
+        *freq_avl_root = NULL;
+        *radix_root = NULL;
+        times.index_kept = 0;
+        return times;
+    }
+
+    times.total_time_ms = wall_clock_ms() - start;
+    if (!quiet) {
+        printf("Anexação completa: %d frases, %d palavras novas e %d palavras atualizadas.\n", times.quote_count,
+               times.new_words, times.updated_words);
+    }
     return times;
 }
@@ -2,18 +2,98 @@
 #define FILE_PARSER_H
 
 #include "structures.h" // Needs struct definitions
+#include "arena.h"
+#include "perf_counters.h"
+#include <stddef.h>     // For size_t
 #include <time.h>       // For clock_t
 
+// Load phases measured with hardware counters (LoadOptions.perf_counters)
+typedef enum LoadPhase {
+  LOAD_PHASE_PARSE,           // Reading and tokenizing the chunks, merging their quote pools
+  LOAD_PHASE_LOCAL,           // Local vocabulary of each chunk
+  LOAD_PHASE_MERGE,           // Merging the vocabularies into the vector
+  LOAD_PHASE_TREES,           // BST, AVL and hash index from the vector
+  LOAD_PHASE_BST_INCREMENTAL, // Token-by-token BST inserts (compare_incremental_trees only)
+  LOAD_PHASE_AVL_INCREMENTAL, // Token-by-token AVL inserts (compare_incremental_trees only)
+  LOAD_PHASE_COUNT
+} LoadPhase;
+
 // Structure to hold timing results for loading
 typedef struct LoadTimes {
   double vector_time_ms;
-  double bst_time_ms;
-  double avl_time_ms;
+  double bst_time_ms;       // Incremental insertion, one call per token (-1 if not measured)
+  double avl_time_ms;       // Incremental insertion, one call per token (-1 if not measured)
+  double bst_bulk_time_ms;  // Balanced build from the sorted vector
+  double avl_bulk_time_ms;  // Balanced build from the sorted vector
+  double hash_time_ms;
+  double parse_time_ms;     // Mapping the file, splitting lines and tokenizing the quotes
+  size_t input_bytes;       // Size of the input file, to report parse throughput
+  int threads;              // Number of chunks the file was split into
+  double local_build_time_ms; // Sorting and collapsing each chunk into its own vocabulary
+  double merge_time_ms;     // Merging the chunk vocabularies into the WordVector
+  double tree_build_time_ms; // Building the BST, AVL and hash index from the vector
+  int perf_recorded;        // 1 if the phases below were measured
+  PerfSample perf[LOAD_PHASE_COUNT]; // Hardware counters of each phase, all load threads included
 } LoadTimes;
 
+// Structure to hold timing results for appending a file to a loaded index
+typedef struct AppendTimes {
+  double total_time_ms;      // -1 if the append failed
+  double parse_time_ms;      // Mapping the new file, splitting lines and tokenizing the quotes
+  double vocabulary_time_ms; // Local vocabularies and merge of the new file on its own
+  double postings_time_ms;   // Finding the words already indexed and extending their postings
+  double freq_avl_time_ms;   // Removing and reinserting changed words, inserting new ones
+  double vector_time_ms;     // Merging the new words into the sorted vector
+  double tree_time_ms;       // Inserting the new words into the BST, AVL, hash index and radix tree
+  size_t input_bytes;        // Size of the new file
+  int threads;
+  int quote_count;           // Quotes added to the pool
+  int new_words;             // Words the index did not have
+  int updated_words;         // Words already indexed whose frequency changed
+  int index_kept;            // On failure: 1 if the index is untouched, 0 if it had to be released
+} AppendTimes;
+
+// Options that change how the index is built
+typedef struct LoadOptions {
+  // Also builds the BST and AVL one token at a time, only to time it against the
+  // bulk build. Those trees are discarded; the index keeps the bulk-built ones.
+  int compare_incremental_trees;
+  // Threads used to load the file; 0 picks one per processor, fewer for small files.
+  // The resulting index is the same for every thread count.
+  int threads;
+  // Skips the progress messages on stdout, e.g. when stdout carries batch results.
+  int quiet;
+  // Records the position of every token in its quote, for phrase queries. Positions take
+  // their own slab of the arena, so an index loaded without them pays nothing for them.
+  // An append must use the same setting as the load.
+  int positions;
+  // Counts cycles, instructions, cache and branch misses of each load phase (LoadTimes.perf).
+  int perf_counters;
+} LoadOptions;
+
 // Parses the movie quotes file and populates the data structures.
-// Returns timings for each structure's loading process.
+// The file is split at line boundaries into one chunk per thread. Each thread tokenizes
+// its chunk and builds a local vocabulary, the vocabularies are merged into the vector,
+// and the trees are then built from the vector.
+// The file is memory-mapped and handed over to the pool: quotes are views into it and
+// words are tokenized in place, so lines of any length are accepted.
+// Each movie title is stored once in the pool; citations refer to quotes and movies by ID.
+// Returns timings for each load phase and each structure (wall-clock time).
 // Takes pointers to the data structure roots/vector to modify them.
-LoadTimes load_data_from_file(const char *filename, WordVector *vec, BSTNode **bst_root, AVLNode **avl_root);
+// Every object created during the load is allocated from the index arena, which it initializes.
+LoadTimes load_data_from_file(const char *filename, const LoadOptions *options, IndexArena *arena, QuotePool *pool,
+                              WordVector *vec, BSTNode **bst_root, AVLNode **avl_root, HashIndex *hash_index);
+
+// Merges the quotes of another file into a loaded index without rebuilding it.
+// The new file goes through the same chunked load on its own; its quotes are numbered
+// after the pool's, so the postings of known words are extended in place. Only the words
+// whose frequency changed are removed from the frequency tree and reinserted, and have the
+// cached maxima on their radix path raised; new words are inserted into the BST, AVL, hash
+// index, radix tree and frequency tree and merged into the vector.
+// Apart from that vector merge, the cost depends on the new file, not on the index.
+// The Eytzinger layout and other views derived from the vector must be refreshed by the caller.
+AppendTimes append_data_from_file(const char *filename, const LoadOptions *options, IndexArena *arena,
+                                  QuotePool *pool, WordVector *vec, BSTNode **bst_root, AVLNode **avl_root,
+                                  HashIndex *hash_index, FreqAVLNode **freq_avl_root, RadixNode **radix_root);
 
 #endif // FILE_PARSER_H
\ No newline at end of file
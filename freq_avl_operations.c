@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "freq_avl_operations.h"
+#include "mem_accounting.h"
 
 // --- Freq AVL Utility Functions (Similar to word AVL, but compare frequency) ---
 
@@ -14,8 +15,25 @@ static int max_freq_avl(int a, int b) {
     return (a > b) ? a : b;
 }
 
-static FreqAVLNode* create_freq_avl_node(WordInfo *wordInfo) {
-    FreqAVLNode* node = (FreqAVLNode*)malloc(sizeof(FreqAVLNode));
+static int size_freq_avl(const FreqAVLNode *N) {
+    if (N == NULL) return 0;
+    return N->size;
+}
+
+// Recomputes height and subtree size from the children
+static void update_freq_avl(FreqAVLNode *N) {
+    N->height = 1 + max_freq_avl(height_freq_avl(N->left), height_freq_avl(N->right));
+    N->size = 1 + size_freq_avl(N->left) + size_freq_avl(N->right);
+}
+
+// Orders words by frequency, then alphabetically, so every word has a single place in the tree
+static int compare_freq_key(const WordInfo *a, const WordInfo *b) {
+    if (a->frequency != b->frequency) return a->frequency < b->frequency ? -1 : 1;
+    return strcmp(a->word, b->word);
+}
+
+static FreqAVLNode* create_freq_avl_node(WordInfo *wordInfo, IndexArena *arena) {
+    FreqAVLNode* node = (FreqAVLNode*)arena_alloc(&arena->slabs[SLAB_FREQ_AVL], sizeof(FreqAVLNode));
      if (!node) {
         perror("Failed to allocate Freq AVL node");
         return NULL;
@@ -24,6 +42,7 @@ static FreqAVLNode* create_freq_avl_node(WordInfo *wordInfo) {
     node->left = NULL;
     node->right = NULL;
     node->height = 1;
+    node->size = 1;
     return node;
 }
 
@@ -32,8 +51,8 @@ static FreqAVLNode *right_rotate_freq_avl(FreqAVLNode *y) {
     FreqAVLNode *T2 = x->right;
     x->right = y;
     y->left = T2;
-    y->height = max_freq_avl(height_freq_avl(y->left), height_freq_avl(y->right)) + 1;
-    x->height = max_freq_avl(height_freq_avl(x->left), height_freq_avl(x->right)) + 1;
+    update_freq_avl(y);
+    update_freq_avl(x);
     return x;
 }
 
@@ -42,8 +61,8 @@ static FreqAVLNode *left_rotate_freq_avl(FreqAVLNode *x) {
     FreqAVLNode *T2 = y->left;
     y->left = x;
     x->right = T2;
-    x->height = max_freq_avl(height_freq_avl(x->left), height_freq_avl(x->right)) + 1;
-    y->height = max_freq_avl(height_freq_avl(y->left), height_freq_avl(y->right)) + 1;
+    update_freq_avl(x);
+    update_freq_avl(y);
     return y;
 }
 
@@ -54,50 +73,41 @@ static int get_balance_freq_avl(FreqAVLNode *N) {
 
 // --- Freq AVL Insertion ---
 
-// Inserts WordInfo pointer based on frequency.
-// Handles ties by inserting into the right subtree (arbitrary but consistent).
-FreqAVLNode* insert_freq_avl(FreqAVLNode *node, WordInfo *wordInfo) {
+// Inserts WordInfo pointer by (frequency, word). A word that is already in the tree is kept once.
+FreqAVLNode* insert_freq_avl(FreqAVLNode *node, WordInfo *wordInfo, IndexArena *arena) {
     if (node == NULL)
-        return(create_freq_avl_node(wordInfo));
+        return(create_freq_avl_node(wordInfo, arena));
 
-    // Compare frequencies
-    if (wordInfo->frequency < node->data->frequency)
-        node->left = insert_freq_avl(node->left, wordInfo);
-    else if (wordInfo->frequency > node->data->frequency)
-        node->right = insert_freq_avl(node->right, wordInfo);
-    else {
-        // Tie in frequency - insert into right subtree for simplicity
-        // A secondary comparison (e.g., alphabetical by word) could be added here.
-        node->right = insert_freq_avl(node->right, wordInfo);
-        // Note: If we allow multiple nodes for same frequency,
-        // the structure needs modification (e.g., list at node).
-        // For this simple approach, we just place it somewhere consistently.
-    }
+    int cmp = compare_freq_key(wordInfo, node->data);
+    if (cmp < 0)
+        node->left = insert_freq_avl(node->left, wordInfo, arena);
+    else if (cmp > 0)
+        node->right = insert_freq_avl(node->right, wordInfo, arena);
+    else
+        return node; // Same word
 
-
-    // Update height
-    node->height = 1 + max_freq_avl(height_freq_avl(node->left), height_freq_avl(node->right));
+    update_freq_avl(node);
 
     // Get balance factor
     int balance = get_balance_freq_avl(node);
 
     // Balance the tree (4 cases)
     // Left Left Case
-    if (balance > 1 && wordInfo->frequency < node->left->data->frequency)
+    if (balance > 1 && compare_freq_key(wordInfo, node->left->data) < 0)
         return right_rotate_freq_avl(node);
 
     // Right Right Case
-    if (balance < -1 && wordInfo->frequency >= node->right->data->frequency) // >= due to tie handling
+    if (balance < -1 && compare_freq_key(wordInfo, node->right->data) > 0)
         return left_rotate_freq_avl(node);
 
     // Left Right Case
-    if (balance > 1 && wordInfo->frequency >= node->left->data->frequency) { // >= due to tie handling
+    if (balance > 1 && compare_freq_key(wordInfo, node->left->data) > 0) {
         node->left = left_rotate_freq_avl(node->left);
         return right_rotate_freq_avl(node);
     }
 
     // Right Left Case
-    if (balance < -1 && wordInfo->frequency < node->right->data->frequency) {
+    if (balance < -1 && compare_freq_key(wordInfo, node->right->data) < 0) {
         node->right = right_rotate_freq_avl(node->right);
         return left_rotate_freq_avl(node);
     }
@@ -105,54 +115,237 @@ FreqAVLNode* insert_freq_avl(FreqAVLNode *node, WordInfo *wordInfo) {
     return node;
 }
 
+// Restores the AVL property at N after one of its subtrees changed height by one
+static FreqAVLNode* rebalance_freq_avl(FreqAVLNode *N) {
+    update_freq_avl(N);
+    int balance = get_balance_freq_avl(N);
+    if (balance > 1) {
+        if (get_balance_freq_avl(N->left) < 0)
+            N->left = left_rotate_freq_avl(N->left);
+        return right_rotate_freq_avl(N);
+    }
+    if (balance < -1) {
+        if (get_balance_freq_avl(N->right) > 0)
+            N->right = right_rotate_freq_avl(N->right);
+        return left_rotate_freq_avl(N);
+    }
+    return N;
+}
+
+// --- Freq AVL Update ---
+
+// Unlinks the leftmost node of the subtree into *min and returns the rebalanced subtree
+static FreqAVLNode* detach_min_freq_avl(FreqAVLNode *node, FreqAVLNode **min) {
+    if (node->left == NULL) {
+        *min = node;
+        return node->right;
+    }
+    node->left = detach_min_freq_avl(node->left, min);
+    return rebalance_freq_avl(node);
+}
+
+// The node is found by the key it was inserted with, so the frequency must not have changed yet
+FreqAVLNode* remove_freq_avl(FreqAVLNode *root, const WordInfo *wordInfo, FreqAVLNode **removed) {
+    if (root == NULL)
+        return NULL;
+
+    int cmp = compare_freq_key(wordInfo, root->data);
+    if (cmp < 0) {
+        root->left = remove_freq_avl(root->left, wordInfo, removed);
+    } else if (cmp > 0) {
+        root->right = remove_freq_avl(root->right, wordInfo, removed);
+    } else {
+        *removed = root;
+        if (root->left == NULL) return root->right;
+        if (root->right == NULL) return root->left;
+
+        // Two children: the in-order successor takes the node's place
+        FreqAVLNode *successor;
+        FreqAVLNode *right = detach_min_freq_avl(root->right, &successor);
+        successor->left = root->left;
+        successor->right = right;
+        return rebalance_freq_avl(successor);
+    }
+    return rebalance_freq_avl(root);
+}
+
+FreqAVLNode* insert_freq_avl_node(FreqAVLNode *root, FreqAVLNode *node) {
+    if (root == NULL) {
+        node->left = NULL;
+        node->right = NULL;
+        update_freq_avl(node);
+        return node;
+    }
+
+    int cmp = compare_freq_key(node->data, root->data);
+    if (cmp < 0)
+        root->left = insert_freq_avl_node(root->left, node);
+    else if (cmp > 0)
+        root->right = insert_freq_avl_node(root->right, node);
+    else
+        return root; // Same word, already in the tree
+
+    return rebalance_freq_avl(root);
+}
+
 // --- Build Freq AVL ---
 
-// Builds the Frequency AVL tree by iterating through the WordVector
-FreqAVLNode* build_freq_avl_from_vector(const WordVector *vec) {
-    FreqAVLNode *freq_root = NULL;
-    if (!vec) return NULL;
+static int compare_freq_sort_keys(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+    return (x > y) - (x < y);
+}
+
+static FreqAVLNode* build_freq_avl_range(WordInfo **words, int low, int high, IndexArena *arena) {
+    if (low > high) return NULL;
+
+    int mid = low + (high - low) / 2;
+    FreqAVLNode *node = create_freq_avl_node(words[mid], arena);
+    if (!node) return NULL;
+    node->left = build_freq_avl_range(words, low, mid - 1, arena);
+    node->right = build_freq_avl_range(words, mid + 1, high, arena);
+    update_freq_avl(node);
+    return node;
+}
+
+// The vector is in word order, so sorting on (frequency, vector index) gives the tie order
+int build_freq_order(FreqOrder *order, const WordVector *vec) {
+    order->words = NULL;
+    order->size = 0;
+    if (!vec || vec->size == 0) return 1;
 
+    unsigned long long *keys = (unsigned long long *)malloc(vec->size * sizeof(unsigned long long));
+    order->words = (WordInfo **)mem_alloc(MEM_FREQ_ORDER, vec->size * sizeof(WordInfo *));
+    if (!keys || !order->words) {
+        perror("Failed to allocate frequency order");
+        free(keys);
+        mem_free(order->words);
+        order->words = NULL;
+        return 0;
+    }
     for (int i = 0; i < vec->size; i++) {
-        if (vec->words[i]) {
-             freq_root = insert_freq_avl(freq_root, vec->words[i]);
-        }
+        keys[i] = ((unsigned long long)(unsigned int)vec->words[i]->frequency << 32) | (unsigned int)i;
+    }
+    qsort(keys, vec->size, sizeof(unsigned long long), compare_freq_sort_keys);
+    for (int i = 0; i < vec->size; i++) {
+        order->words[i] = vec->words[(unsigned int)keys[i]];
+    }
+    order->size = vec->size;
+    free(keys);
+    return 1;
+}
+
+void free_freq_order(FreqOrder *order) {
+    mem_free(order->words);
+    order->words = NULL;
+    order->size = 0;
+}
+
+// In-order walk of the subtree into out[*count...]
+static void collect_freq_avl(const FreqAVLNode *node, WordInfo **out, int *count) {
+    if (node == NULL) return;
+    collect_freq_avl(node->left, out, count);
+    out[(*count)++] = node->data;
+    collect_freq_avl(node->right, out, count);
+}
+
+int build_freq_order_from_avl(FreqOrder *order, const FreqAVLNode *root) {
+    int size = size_freq_avl(root);
+    WordInfo **words = (WordInfo **)mem_realloc(MEM_FREQ_ORDER, order->words, (size ? size : 1) * sizeof(WordInfo *));
+    if (!words) {
+        perror("Failed to resize frequency order");
+        return 0;
     }
-    return freq_root;
+    order->words = words;
+    order->size = 0;
+    collect_freq_avl(root, order->words, &order->size);
+    return 1;
+}
+
+FreqAVLNode* build_freq_avl_from_order(const FreqOrder *order, IndexArena *arena) {
+    if (!order || order->size == 0) return NULL;
+    return build_freq_avl_range(order->words, 0, order->size - 1, arena);
 }
 
 // --- Search Freq Range ---
 
 // In-order traversal to find words within the frequency range.
-void search_freq_range_avl(FreqAVLNode *root, int min_freq, int max_freq) {
+// Ties on frequency are split by word, so equal frequencies sit on both sides of a node:
+// a subtree is skipped only when every frequency in it is out of range.
+void visit_freq_range_avl(const FreqAVLNode *root, int min_freq, int max_freq, WordVisitor visit, void *context) {
     if (root == NULL) {
         return;
     }
 
-    // If current node's frequency is greater than min, check left subtree
-    if (root->data->frequency > min_freq) {
-        search_freq_range_avl(root->left, min_freq, max_freq);
+    if (root->data->frequency >= min_freq) {
+        visit_freq_range_avl(root->left, min_freq, max_freq, visit, context);
     }
 
-    // Check if current node's frequency is within the range
     if (root->data->frequency >= min_freq && root->data->frequency <= max_freq) {
-        printf("  - Word: '%s', Frequency: %d\n", root->data->word, root->data->frequency);
+        visit(root->data, context);
     }
 
-     // If current node's frequency is less than max, check right subtree
-    if (root->data->frequency < max_freq) {
-         search_freq_range_avl(root->right, min_freq, max_freq);
+    if (root->data->frequency <= max_freq) {
+        visit_freq_range_avl(root->right, min_freq, max_freq, visit, context);
     }
 }
 
+// --- Order Statistics ---
+
+// Number of words with frequency below 'frequency' (or at most 'frequency' when inclusive)
+static int count_below_freq_avl(const FreqAVLNode *node, int frequency, int inclusive) {
+    int count = 0;
+    while (node) {
+        int freq = node->data->frequency;
+        if (freq < frequency || (inclusive && freq == frequency)) {
+            count += size_freq_avl(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return count;
+}
 
-// --- Free Freq AVL ---
+int count_freq_range_avl(const FreqAVLNode *root, int min_freq, int max_freq) {
+    if (min_freq > max_freq) return 0;
+    return count_below_freq_avl(root, max_freq, 1) - count_below_freq_avl(root, min_freq, 0);
+}
 
-// Frees the memory allocated for the Frequency AVL tree nodes (not WordInfo).
-void free_freq_avl(FreqAVLNode *root) {
-    if (root != NULL) {
-        free_freq_avl(root->left);
-        free_freq_avl(root->right);
-        // IMPORTANT: Only free the node, not root->data (WordInfo)
-        free(root);
+const WordInfo* select_freq_avl(const FreqAVLNode *root, int k) {
+    const FreqAVLNode *node = root;
+    while (node) {
+        int left = size_freq_avl(node->left);
+        if (k < left) {
+            node = node->left;
+        } else if (k == left) {
+            return node->data;
+        } else {
+            k -= left + 1;
+            node = node->right;
+        }
     }
-}
\ No newline at end of file
+    return NULL;
+}
+
+// In-order copy starting at rank 'skip' of the subtree, until 'wanted' words are copied
+static void copy_from_rank_freq_avl(const FreqAVLNode *node, int skip, WordInfo *out, int wanted, int *written) {
+    if (node == NULL || *written == wanted) return;
+    int left = size_freq_avl(node->left);
+    if (skip < left) copy_from_rank_freq_avl(node->left, skip, out, wanted, written);
+    if (*written == wanted) return;
+    if (skip <= left) out[(*written)++] = *node->data;
+    copy_from_rank_freq_avl(node->right, skip > left ? skip - left - 1 : 0, out, wanted, written);
+}
+
+int page_freq_range_avl(const FreqAVLNode *root, int min_freq, int max_freq, int offset, WordInfo *out,
+                        int capacity) {
+    if (min_freq > max_freq || offset < 0 || capacity <= 0) return 0;
+    int first = count_below_freq_avl(root, min_freq, 0) + offset;
+    int end = count_below_freq_avl(root, max_freq, 1);
+    int wanted = end - first < capacity ? end - first : capacity;
+    if (wanted <= 0) return 0;
+
+    int written = 0;
+    copy_from_rank_freq_avl(root, first, out, wanted, &written);
+    return written;
+}
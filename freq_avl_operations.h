@@ -2,18 +2,48 @@
 #define FREQ_AVL_OPERATIONS_H
 
 #include "structures.h"
+#include "arena.h"
 
-// Inserts a WordInfo pointer into the Frequency AVL Tree based on frequency.
-// Handles ties arbitrarily (or could use word as secondary key).
-FreqAVLNode* insert_freq_avl(FreqAVLNode *node, WordInfo *wordInfo);
+// Inserts a WordInfo pointer into the Frequency AVL Tree, ordered by (frequency, word):
+// ties on frequency are ordered alphabetically.
+// New nodes are allocated from the Freq AVL slab of the index arena.
+FreqAVLNode* insert_freq_avl(FreqAVLNode *node, WordInfo *wordInfo, IndexArena *arena);
 
-// Builds the Frequency AVL tree by traversing the WordVector.
-FreqAVLNode* build_freq_avl_from_vector(const WordVector *vec);
+// Unlinks the node of 'wordInfo' from the tree and returns it in *removed (NULL if absent),
+// so it can be reinserted once the word's frequency changes. Call it before the frequency
+// changes: the node is found by its (frequency, word) key. Rebalances as needed.
+FreqAVLNode* remove_freq_avl(FreqAVLNode *root, const WordInfo *wordInfo, FreqAVLNode **removed);
 
-// Searches for and prints words within a given frequency range (inclusive).
-void search_freq_range_avl(FreqAVLNode *root, int min_freq, int max_freq);
+// Links a node detached by remove_freq_avl back into the tree under its current key.
+FreqAVLNode* insert_freq_avl_node(FreqAVLNode *root, FreqAVLNode *node);
 
-// Frees the memory allocated for the Frequency AVL tree nodes (not WordInfo).
-void free_freq_avl(FreqAVLNode *root);
+// Sorts every word of the vector by (frequency, word). Does NOT duplicate WordInfo.
+// Returns 1 on success, 0 on allocation failure.
+int build_freq_order(FreqOrder *order, const WordVector *vec);
+
+// Frees the pointer array (not the WordInfo structs).
+void free_freq_order(FreqOrder *order);
+
+// Refills the order with an in-order walk of the tree, in O(n) and without sorting.
+// Returns 1 on success, 0 on allocation failure (the old order is kept).
+int build_freq_order_from_avl(FreqOrder *order, const FreqAVLNode *root);
+
+// Builds a perfectly balanced Frequency AVL tree over the frequency order in O(n).
+FreqAVLNode* build_freq_avl_from_order(const FreqOrder *order, IndexArena *arena);
+
+// Calls 'visit' for every word within the frequency range (inclusive), in (frequency, word) order.
+void visit_freq_range_avl(const FreqAVLNode *root, int min_freq, int max_freq, WordVisitor visit, void *context);
+
+// Counts the words within the frequency range (inclusive) in O(log n), without visiting them.
+int count_freq_range_avl(const FreqAVLNode *root, int min_freq, int max_freq);
+
+// Returns the word of rank k (0-based) in (frequency, word) order, or NULL if k is out of range.
+const WordInfo* select_freq_avl(const FreqAVLNode *root, int k);
+
+// Copies results offset..offset+capacity-1 of the frequency range into 'out', in (frequency, word)
+// order, in O(log n + capacity). The copies share the word and postings of the index.
+// Returns the number of words copied.
+int page_freq_range_avl(const FreqAVLNode *root, int min_freq, int max_freq, int offset, WordInfo *out,
+                        int capacity);
 
 #endif // FREQ_AVL_OPERATIONS_H
\ No newline at end of file
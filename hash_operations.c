@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash_operations.h"
+#include "mem_accounting.h"
+
+#define HASH_MIN_CAPACITY 16
+
+// Hashes a NUL-terminated string (FNV-1a)
+unsigned int hash_string(const char *str) {
+    unsigned int hash = 2166136261u;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1; // 0 is reserved for empty slots
+}
+
+unsigned int hash_bytes(const char *str, size_t length) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+// Distance of a stored entry from the slot its hash points to
+static int probe_distance(const HashIndex *index, unsigned int hash, int slot) {
+    return (slot - (int)(hash & (unsigned int)(index->capacity - 1))) & (index->capacity - 1);
+}
+
+// Smallest power of two keeping 'count' words under a 3/4 load factor
+static int capacity_for(int count) {
+    int capacity = HASH_MIN_CAPACITY;
+    while (capacity - capacity / 4 <= count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static int allocate_slots(HashIndex *index, int capacity) {
+    index->slots = (HashSlot *)mem_calloc(MEM_HASH, capacity, sizeof(HashSlot));
+    if (!index->slots) {
+        perror("Failed to allocate hash index");
+        index->capacity = 0;
+        index->size = 0;
+        return 0;
+    }
+    index->capacity = capacity;
+    index->size = 0;
+    return 1;
+}
+
+// Places an entry known to be absent. Robin Hood: an entry that is closer to its
+// home slot than the one being placed gives up its slot and moves on instead.
+static void place_entry(HashIndex *index, WordInfo *wordInfo, unsigned int hash) {
+    int mask = index->capacity - 1;
+    int slot = (int)(hash & (unsigned int)mask);
+    int distance = 0;
+    HashSlot entry = { wordInfo, hash };
+
+    while (index->slots[slot].hash != 0) {
+        int existing = probe_distance(index, index->slots[slot].hash, slot);
+        if (existing < distance) {
+            HashSlot displaced = index->slots[slot];
+            index->slots[slot] = entry;
+            entry = displaced;
+            distance = existing;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+    index->slots[slot] = entry;
+    index->size++;
+}
+
+// Doubles the table and re-places every entry
+static int grow_hash_index(HashIndex *index) {
+    HashSlot *old_slots = index->slots;
+    int old_capacity = index->capacity;
+    int old_size = index->size;
+
+    if (!allocate_slots(index, old_capacity ? old_capacity * 2 : HASH_MIN_CAPACITY)) {
+        index->slots = old_slots;
+        index->capacity = old_capacity;
+        index->size = old_size;
+        return 0;
+    }
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_slots[i].hash != 0) {
+            place_entry(index, old_slots[i].data, old_slots[i].hash);
+        }
+    }
+    mem_free(old_slots);
+    return 1;
+}
+
+int init_hash_index(HashIndex *index, int expected) {
+    return allocate_slots(index, capacity_for(expected));
+}
+
+int insert_hash_index(HashIndex *index, WordInfo *wordInfo) {
+    if (search_hash_index(index, wordInfo->word)) {
+        return 1; // Already indexed; the WordInfo is shared, so nothing to update
+    }
+    if (index->size + 1 > index->capacity - index->capacity / 4 && !grow_hash_index(index)) {
+        return 0;
+    }
+    place_entry(index, wordInfo, hash_string(wordInfo->word));
+    return 1;
+}
+
+int build_hash_index_from_vector(HashIndex *index, const WordVector *vec) {
+    if (!init_hash_index(index, vec->size)) return 0;
+    // Vector words are unique, so they can be placed without a lookup
+    for (int i = 0; i < vec->size; i++) {
+        place_entry(index, vec->words[i], hash_string(vec->words[i]->word));
+    }
+    return 1;
+}
+
+// Probes from the home slot. The fingerprint check skips strcmp on almost every
+// mismatch, and the Robin Hood invariant ends a miss as soon as a resident entry
+// is closer to home than the probe.
+WordInfo* search_hash_index(const HashIndex *index, const char *word) {
+    if (!index->slots) return NULL;
+
+    unsigned int hash = hash_string(word);
+    int mask = index->capacity - 1;
+    int slot = (int)(hash & (unsigned int)mask);
+
+    for (int distance = 0; ; distance++) {
+        const HashSlot *current = &index->slots[slot];
+        if (current->hash == 0 || probe_distance(index, current->hash, slot) < distance) {
+            return NULL; // Not found
+        }
+        if (current->hash == hash && strcmp(current->data->word, word) == 0) {
+            return current->data; // Found
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+void free_hash_index(HashIndex *index) {
+    if (index) {
+        mem_free(index->slots);
+        index->slots = NULL;
+        index->capacity = 0;
+        index->size = 0;
+    }
+}
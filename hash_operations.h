@@ -0,0 +1,33 @@
+#ifndef HASH_OPERATIONS_H
+#define HASH_OPERATIONS_H
+
+#include <stddef.h>
+#include "structures.h"
+
+// Hashes a NUL-terminated string (FNV-1a). Never returns 0, which marks empty slots.
+unsigned int hash_string(const char *str);
+
+// Hashes 'length' bytes; equal to hash_string for the same characters.
+unsigned int hash_bytes(const char *str, size_t length);
+
+// Initializes a HashIndex with room for 'expected' words before it has to grow.
+// Returns 1 on success, 0 on allocation failure.
+int init_hash_index(HashIndex *index, int expected);
+
+// Inserts a WordInfo pointer into the hash index. Does NOT duplicate WordInfo.
+// Inserting a word that is already present is a no-op.
+// Returns 1 on success, 0 on allocation failure.
+int insert_hash_index(HashIndex *index, WordInfo *wordInfo);
+
+// Builds the hash index over every word of the vector.
+// Returns 1 on success, 0 on allocation failure.
+int build_hash_index_from_vector(HashIndex *index, const WordVector *vec);
+
+// Searches for a word in the hash index.
+// Returns a pointer to the WordInfo if found, NULL otherwise.
+WordInfo* search_hash_index(const HashIndex *index, const char *word);
+
+// Frees the slot array (not the WordInfo structs).
+void free_hash_index(HashIndex *index);
+
+#endif // HASH_OPERATIONS_H
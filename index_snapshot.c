@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "index_snapshot.h"
+#include "mapped_file.h"
+#include "quote_pool.h"
+
+#define SECTION_ALIGNMENT 8
+
+// 64-bit FNV-1a over 8-byte words, then the tail byte by byte
+static uint64_t snapshot_checksum(const unsigned char *data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static size_t align_section(size_t size) {
+    return (size + SECTION_ALIGNMENT - 1) & ~(size_t)(SECTION_ALIGNMENT - 1);
+}
+
+// Sort key of the frequency order: frequency in the high half, word index in the low half
+static int compare_freq_keys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+int save_index_snapshot(const char *filename, const WordVector *vec, const QuotePool *pool, double build_time_ms) {
+    size_t word_text = 0, movie_text = 0, quote_text = 0, postings_size = 0;
+    for (int i = 0; i < vec->size; i++) {
+        word_text += strlen(vec->words[i]->word) + 1;
+        postings_size += vec->words[i]->postings.length;
+    }
+    for (int i = 0; i < pool->movie_count; i++) movie_text += strlen(pool->movies[i]) + 1;
+    for (int i = 0; i < pool->quote_count; i++) quote_text += pool->quotes[i].length;
+    if (word_text > UINT32_MAX) {
+        fprintf(stderr, "Erro: vocabulário grande demais para o snapshot.\n");
+        return 0;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.word_count = (uint32_t)vec->size;
+    header.quote_count = (uint32_t)pool->quote_count;
+    header.movie_count = (uint32_t)pool->movie_count;
+    header.build_time_ms = build_time_ms;
+
+    size_t sizes[SNAPSHOT_SECTION_COUNT];
+    sizes[SECTION_WORDS] = (size_t)vec->size * sizeof(SnapshotWord);
+    sizes[SECTION_FREQ_ORDER] = (size_t)vec->size * sizeof(uint32_t);
+    sizes[SECTION_POSTINGS] = postings_size;
+    sizes[SECTION_QUOTES] = (size_t)pool->quote_count * sizeof(SnapshotQuote);
+    sizes[SECTION_MOVIES] = (size_t)pool->movie_count * sizeof(uint32_t);
+    sizes[SECTION_TEXT] = word_text + movie_text + quote_text + 1;
+
+    size_t offset = align_section(sizeof(SnapshotHeader));
+    for (int s = 0; s < SNAPSHOT_SECTION_COUNT; s++) {
+        header.sections[s].offset = offset;
+        header.sections[s].size = sizes[s];
+        offset = align_section(offset + sizes[s]);
+    }
+    header.file_size = offset;
+
+    unsigned char *image = (unsigned char *)calloc(1, offset);
+    uint64_t *freq_keys = (uint64_t *)malloc((vec->size ? vec->size : 1) * sizeof(uint64_t));
+    if (!image || !freq_keys) {
+        perror("Falha ao alocar o snapshot");
+        free(image);
+        free(freq_keys);
+        return 0;
+    }
+
+    SnapshotWord *words = (SnapshotWord *)(image + header.sections[SECTION_WORDS].offset);
+    uint32_t *freq_order = (uint32_t *)(image + header.sections[SECTION_FREQ_ORDER].offset);
+    unsigned char *postings = image + header.sections[SECTION_POSTINGS].offset;
+    SnapshotQuote *quotes = (SnapshotQuote *)(image + header.sections[SECTION_QUOTES].offset);
+    uint32_t *movies = (uint32_t *)(image + header.sections[SECTION_MOVIES].offset);
+    char *text = (char *)(image + header.sections[SECTION_TEXT].offset);
+
+    size_t text_used = 0, postings_used = 0;
+    for (int i = 0; i < vec->size; i++) {
+        const WordInfo *info = vec->words[i];
+        size_t length = strlen(info->word);
+        words[i].text = (uint32_t)text_used;
+        words[i].length = (uint32_t)length;
+        words[i].frequency = (uint32_t)info->frequency;
+        words[i].quote_count = (uint32_t)info->postings.quote_count;
+        words[i].postings = postings_used;
+        words[i].postings_length = (uint32_t)info->postings.length;
+        words[i].last_quote = info->postings.last_quote;
+        memcpy(text + text_used, info->word, length + 1);
+        text_used += length + 1;
+        if (info->postings.length) memcpy(postings + postings_used, info->postings.bytes, info->postings.length);
+        postings_used += info->postings.length;
+        freq_keys[i] = ((uint64_t)(uint32_t)info->frequency << 32) | (uint32_t)i;
+    }
+    for (int i = 0; i < pool->movie_count; i++) {
+        size_t length = strlen(pool->movies[i]);
+        movies[i] = (uint32_t)text_used;
+        memcpy(text + text_used, pool->movies[i], length + 1);
+        text_used += length + 1;
+    }
+    for (int i = 0; i < pool->quote_count; i++) {
+        const QuoteEntry *quote = &pool->quotes[i];
+        quotes[i].text = text_used;
+        quotes[i].length = (uint32_t)quote->length;
+        quotes[i].movie_id = (uint32_t)quote->movie_id;
+        quotes[i].year = quote->year;
+        quotes[i].word_count = (uint32_t)quote->word_count;
+        memcpy(text + text_used, quote->text, quote->length);
+        text_used += quote->length;
+    }
+    text[text_used] = '\0'; // Every string offset in the section ends at a NUL
+
+    // Vector order is word order, so ties on frequency stay sorted by word
+    qsort(freq_keys, vec->size, sizeof(uint64_t), compare_freq_keys);
+    for (int i = 0; i < vec->size; i++) {
+        freq_order[i] = (uint32_t)freq_keys[i];
+    }
+    free(freq_keys);
+
+    header.checksum = snapshot_checksum(image + sizeof(SnapshotHeader), offset - sizeof(SnapshotHeader));
+    memcpy(image, &header, sizeof(header));
+
+    char temp_name[1024];
+    snprintf(temp_name, sizeof(temp_name), "%s.tmp", filename);
+    FILE *file = fopen(temp_name, "wb");
+    if (!file) {
+        perror("Falha ao criar o snapshot");
+        free(image);
+        return 0;
+    }
+    int ok = fwrite(image, 1, offset, file) == offset;
+    ok = (fclose(file) == 0) && ok;
+    free(image);
+    if (!ok || rename(temp_name, filename) != 0) {
+        perror("Falha ao gravar o snapshot");
+        remove(temp_name);
+        return 0;
+    }
+    return 1;
+}
+
+// Checks that [offset, offset + size) lies inside a section of 'limit' bytes
+static int in_section(uint64_t offset, uint64_t size, uint64_t limit) {
+    return offset <= limit && size <= limit - offset;
+}
+
+int is_index_snapshot(const char *filename) {
+    char magic[8];
+    FILE *file = fopen(filename, "rb");
+    if (!file) return 0;
+    int is_snapshot = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                      memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return is_snapshot;
+}
+
+static int snapshot_invalid(IndexSnapshot *snapshot, const char *filename, const char *reason) {
+    fprintf(stderr, "Erro: snapshot '%s' inválido (%s).\n", filename, reason);
+    unmap_file(&snapshot->file);
+    memset(snapshot, 0, sizeof(*snapshot));
+    return 0;
+}
+
+int open_index_snapshot(const char *filename, IndexSnapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (!map_file(filename, &snapshot->file)) {
+        return 0;
+    }
+
+    const unsigned char *data = (const unsigned char *)snapshot->file.data;
+    const size_t size = snapshot->file.size;
+    if (size < sizeof(SnapshotHeader)) {
+        return snapshot_invalid(snapshot, filename, "arquivo curto demais");
+    }
+    const SnapshotHeader *header = (const SnapshotHeader *)data;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        return snapshot_invalid(snapshot, filename, "não é um snapshot");
+    }
+    if (header->byte_order != SNAPSHOT_BYTE_ORDER) {
+        return snapshot_invalid(snapshot, filename, "ordem de bytes diferente");
+    }
+    if (header->version != SNAPSHOT_VERSION) {
+        return snapshot_invalid(snapshot, filename, "versão não suportada");
+    }
+    if (header->file_size != size) {
+        return snapshot_invalid(snapshot, filename, "tamanho não confere");
+    }
+
+    const size_t expected[SNAPSHOT_SECTION_COUNT] = {
+        (size_t)header->word_count * sizeof(SnapshotWord),
+        (size_t)header->word_count * sizeof(uint32_t),
+        0,
+        (size_t)header->quote_count * sizeof(SnapshotQuote),
+        (size_t)header->movie_count * sizeof(uint32_t),
+        0
+    };
+    for (int s = 0; s < SNAPSHOT_SECTION_COUNT; s++) {
+        const SnapshotSection *section = &header->sections[s];
+        if (section->offset < sizeof(SnapshotHeader) || section->offset % SECTION_ALIGNMENT != 0 ||
+            !in_section(section->offset, section->size, size) ||
+            (expected[s] && section->size != expected[s])) {
+            return snapshot_invalid(snapshot, filename, "seção fora dos limites");
+        }
+    }
+    if (header->sections[SECTION_TEXT].size == 0 ||
+        data[header->sections[SECTION_TEXT].offset + header->sections[SECTION_TEXT].size - 1] != '\0') {
+        return snapshot_invalid(snapshot, filename, "seção de texto sem terminador");
+    }
+    if (snapshot_checksum(data + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader)) != header->checksum) {
+        return snapshot_invalid(snapshot, filename, "checksum não confere");
+    }
+
+    snapshot->header = header;
+    snapshot->words = (const SnapshotWord *)(data + header->sections[SECTION_WORDS].offset);
+    snapshot->freq_order = (const uint32_t *)(data + header->sections[SECTION_FREQ_ORDER].offset);
+    snapshot->postings = data + header->sections[SECTION_POSTINGS].offset;
+    snapshot->quotes = (const SnapshotQuote *)(data + header->sections[SECTION_QUOTES].offset);
+    snapshot->movies = (const uint32_t *)(data + header->sections[SECTION_MOVIES].offset);
+    snapshot->text = (const char *)(data + header->sections[SECTION_TEXT].offset);
+
+    // Offsets inside the records are checked once, so queries can trust them
+    const uint64_t text_size = header->sections[SECTION_TEXT].size;
+    const uint64_t postings_size = header->sections[SECTION_POSTINGS].size;
+    for (uint32_t i = 0; i < header->word_count; i++) {
+        const SnapshotWord *word = &snapshot->words[i];
+        if (!in_section(word->text, (uint64_t)word->length + 1, text_size) || snapshot->text[word->text + word->length] != '\0' ||
+            !in_section(word->postings, word->postings_length, postings_size) ||
+            snapshot->freq_order[i] >= header->word_count) {
+            return snapshot_invalid(snapshot, filename, "palavra fora dos limites");
+        }
+    }
+    for (uint32_t i = 0; i < header->quote_count; i++) {
+        const SnapshotQuote *quote = &snapshot->quotes[i];
+        if (!in_section(quote->text, quote->length, text_size) || quote->length > (uint32_t)INT32_MAX ||
+            quote->word_count > quote->length || quote->movie_id >= header->movie_count) {
+            return snapshot_invalid(snapshot, filename, "frase fora dos limites");
+        }
+    }
+    for (uint32_t i = 0; i < header->movie_count; i++) {
+        if (snapshot->movies[i] >= text_size) {
+            return snapshot_invalid(snapshot, filename, "filme fora dos limites");
+        }
+    }
+    return 1;
+}
+
+void close_index_snapshot(IndexSnapshot *snapshot) {
+    if (!snapshot) return;
+    unmap_file(&snapshot->file);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+// Read-only WordInfo over a mapped word; the postings can be walked but not appended to
+static void snapshot_word_view(const IndexSnapshot *snapshot, const SnapshotWord *word, WordInfo *out) {
+    out->word = (char *)(snapshot->text + word->text);
+    out->frequency = (int)word->frequency;
+    out->postings.bytes = (unsigned char *)(snapshot->postings + word->postings);
+    out->postings.length = (int)word->postings_length;
+    out->postings.capacity = (int)word->postings_length;
+    out->postings.quote_count = (int)word->quote_count;
+    out->postings.last_quote = word->last_quote;
+    out->postings.last_count = 0;
+    out->postings.last_count_offset = (int)word->postings_length;
+    out->positions.bytes = NULL; // Snapshots do not store positions
+    out->positions.length = 0;
+    out->positions.capacity = 0;
+}
+
+int search_snapshot(const IndexSnapshot *snapshot, const char *word, WordInfo *out) {
+    if (!snapshot->header) return 0;
+    int low = 0, high = (int)snapshot->header->word_count - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        int cmp = strcmp(word, snapshot->text + snapshot->words[mid].text);
+        if (cmp == 0) {
+            snapshot_word_view(snapshot, &snapshot->words[mid], out);
+            return 1;
+        } else if (cmp < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return 0;
+}
+
+// Same two binary searches as prefix_range_vector, over the mapped words
+int prefix_range_snapshot(const IndexSnapshot *snapshot, const char *prefix, int *first) {
+    *first = 0;
+    if (!snapshot->header) return 0;
+    size_t length = strlen(prefix);
+    int low = 0, high = (int)snapshot->header->word_count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strcmp(snapshot->text + snapshot->words[mid].text, prefix) < 0) low = mid + 1;
+        else high = mid;
+    }
+    *first = low;
+    high = (int)snapshot->header->word_count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strncmp(snapshot->text + snapshot->words[mid].text, prefix, length) <= 0) low = mid + 1;
+        else high = mid;
+    }
+    return low - *first;
+}
+
+int snapshot_word_at(const IndexSnapshot *snapshot, int index, WordInfo *out) {
+    if (!snapshot->header || index < 0 || (uint32_t)index >= snapshot->header->word_count) return 0;
+    snapshot_word_view(snapshot, &snapshot->words[index], out);
+    return 1;
+}
+
+// First entry of the frequency order with frequency >= 'frequency'
+static int freq_lower_bound(const IndexSnapshot *snapshot, long long frequency) {
+    int low = 0, high = (int)snapshot->header->word_count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if ((long long)snapshot->words[snapshot->freq_order[mid]].frequency < frequency) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void visit_freq_range_snapshot(const IndexSnapshot *snapshot, int min_freq, int max_freq, WordVisitor visit,
+                               void *context) {
+    if (!snapshot->header) return;
+    const int count = (int)snapshot->header->word_count;
+
+    WordInfo view;
+    for (int i = freq_lower_bound(snapshot, min_freq); i < count; i++) {
+        const SnapshotWord *word = &snapshot->words[snapshot->freq_order[i]];
+        if ((int)word->frequency > max_freq) break;
+        snapshot_word_view(snapshot, word, &view);
+        visit(&view, context);
+    }
+}
+
+int snapshot_freq_rank_view(const IndexSnapshot *snapshot, int rank, WordInfo *out) {
+    if (!snapshot->header || rank < 0 || rank >= (int)snapshot->header->word_count) return 0;
+    snapshot_word_view(snapshot, &snapshot->words[snapshot->freq_order[rank]], out);
+    return 1;
+}
+
+int count_freq_range_snapshot(const IndexSnapshot *snapshot, int min_freq, int max_freq) {
+    if (!snapshot->header || min_freq > max_freq) return 0;
+    return freq_lower_bound(snapshot, (long long)max_freq + 1) - freq_lower_bound(snapshot, min_freq);
+}
+
+int page_freq_range_snapshot(const IndexSnapshot *snapshot, int min_freq, int max_freq, int offset, WordInfo *out,
+                             int capacity) {
+    if (!snapshot->header || min_freq > max_freq || offset < 0 || capacity <= 0) return 0;
+    const int first = freq_lower_bound(snapshot, min_freq) + offset;
+    const int end = freq_lower_bound(snapshot, (long long)max_freq + 1);
+    int written = 0;
+    for (int i = first; i < end && written < capacity; i++) {
+        snapshot_word_view(snapshot, &snapshot->words[snapshot->freq_order[i]], &out[written++]);
+    }
+    return written;
+}
+
+int snapshot_quote_pool(const IndexSnapshot *snapshot, QuotePool *pool) {
+    if (!snapshot->header) return 0;
+    for (uint32_t i = 0; i < snapshot->header->movie_count; i++) {
+        const char *title = snapshot->text + snapshot->movies[i];
+        if (intern_movie(pool, title, (int)strlen(title)) != (int)i) {
+            fprintf(stderr, "Erro: filmes repetidos ou sem memória ao abrir o snapshot.\n");
+            return 0;
+        }
+    }
+    for (uint32_t i = 0; i < snapshot->header->quote_count; i++) {
+        const SnapshotQuote *quote = &snapshot->quotes[i];
+        const int id = add_quote(pool, snapshot->text + quote->text, (int)quote->length, (int)quote->movie_id,
+                                 quote->year);
+        if (id < 0) return 0;
+        pool->quotes[id].word_count = (int)quote->word_count;
+        pool->word_total += quote->word_count;
+    }
+    return 1;
+}
@@ -0,0 +1,126 @@
+#ifndef INDEX_SNAPSHOT_H
+#define INDEX_SNAPSHOT_H
+
+#include <stdint.h>
+#include "structures.h"
+
+// --- On-disk format ---
+// A header followed by 8-byte aligned sections. Every reference inside the file is an
+// offset into a section, so the mapped file is queried in place at any address.
+// Integers are stored in the byte order of the machine that wrote the file.
+
+#define SNAPSHOT_MAGIC "QASNAP\0\0"
+#define SNAPSHOT_VERSION 2  // 2: quotes carry their word count
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+typedef enum SnapshotSectionKind {
+  SECTION_WORDS,      // SnapshotWord[word_count], sorted by word
+  SECTION_FREQ_ORDER, // uint32_t[word_count]: word indices sorted by (frequency, word)
+  SECTION_POSTINGS,   // Posting list bytes, as in PostingList
+  SECTION_QUOTES,     // SnapshotQuote[quote_count]
+  SECTION_MOVIES,     // uint32_t[movie_count]: offsets of the NUL-terminated titles in the text section
+  SECTION_TEXT,       // Words (first, so their offsets fit 32 bits), titles, quotes; ends with NUL
+  SNAPSHOT_SECTION_COUNT
+} SnapshotSectionKind;
+
+typedef struct SnapshotSection {
+  uint64_t offset;    // From the start of the file
+  uint64_t size;
+} SnapshotSection;
+
+typedef struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;   // SNAPSHOT_BYTE_ORDER as written
+  uint64_t file_size;
+  uint64_t checksum;     // Of every byte after the header
+  uint32_t word_count;
+  uint32_t quote_count;
+  uint32_t movie_count;
+  uint32_t reserved;
+  double build_time_ms;  // Time the CSV load took when the snapshot was saved
+  SnapshotSection sections[SNAPSHOT_SECTION_COUNT];
+} SnapshotHeader;
+
+typedef struct SnapshotWord {
+  uint32_t text;            // Offset of the NUL-terminated word in the text section
+  uint32_t length;
+  uint32_t frequency;
+  uint32_t quote_count;
+  uint64_t postings;        // Offset of the posting list in the postings section
+  uint32_t postings_length;
+  int32_t last_quote;
+} SnapshotWord;
+
+typedef struct SnapshotQuote {
+  uint64_t text;            // Offset in the text section (not NUL-terminated)
+  uint32_t length;
+  uint32_t movie_id;
+  int32_t year;
+  uint32_t word_count;      // Indexed words, for ranked search
+} SnapshotQuote;
+
+// --- Open snapshot ---
+
+// A validated snapshot file and pointers to its sections
+typedef struct IndexSnapshot {
+  MappedFile file;
+  const SnapshotHeader *header;
+  const SnapshotWord *words;
+  const uint32_t *freq_order;
+  const unsigned char *postings;
+  const SnapshotQuote *quotes;
+  const uint32_t *movies;
+  const char *text;
+} IndexSnapshot;
+
+// Writes the index to 'filename' through a temporary file renamed at the end, so an
+// existing snapshot is never left half written. build_time_ms is stored for comparison.
+// Returns 1 on success.
+int save_index_snapshot(const char *filename, const WordVector *vec, const QuotePool *pool, double build_time_ms);
+
+// Returns 1 if the file starts with the snapshot magic.
+int is_index_snapshot(const char *filename);
+
+// Maps the snapshot and checks its header, section bounds, record offsets and checksum.
+// Nothing is copied. Returns 1 on success, 0 if the file is missing or invalid.
+int open_index_snapshot(const char *filename, IndexSnapshot *snapshot);
+
+// Unmaps the snapshot. Views returned by search_snapshot become invalid.
+void close_index_snapshot(IndexSnapshot *snapshot);
+
+// Binary search over the mapped words. On success fills *out with a read-only view whose
+// word and postings point into the file, and returns 1.
+int search_snapshot(const IndexSnapshot *snapshot, const char *word, WordInfo *out);
+
+// Finds the mapped words that start with 'prefix': word indices *first.. in word order.
+// Returns how many there are.
+int prefix_range_snapshot(const IndexSnapshot *snapshot, const char *prefix, int *first);
+
+// Fills *out with a view of the word at 'index' in word order. Returns 0 if out of range.
+int snapshot_word_at(const IndexSnapshot *snapshot, int index, WordInfo *out);
+
+// Calls 'visit' with a read-only view of every word whose frequency is in [min_freq, max_freq],
+// in (frequency, word) order. The view is only valid during the call.
+void visit_freq_range_snapshot(const IndexSnapshot *snapshot, int min_freq, int max_freq, WordVisitor visit,
+                               void *context);
+
+// Fills *out with a view of the word of rank 'rank' (0-based) in (frequency, word) order.
+// Returns 0 if the rank is out of range.
+int snapshot_freq_rank_view(const IndexSnapshot *snapshot, int rank, WordInfo *out);
+
+// Counts the words whose frequency is in [min_freq, max_freq] with two binary searches.
+int count_freq_range_snapshot(const IndexSnapshot *snapshot, int min_freq, int max_freq);
+
+// Fills 'out' with views of results offset..offset+capacity-1 of the frequency range, in
+// (frequency, word) order. The views stay valid while the snapshot is open.
+// Returns the number of words written.
+int page_freq_range_snapshot(const IndexSnapshot *snapshot, int min_freq, int max_freq, int offset, WordInfo *out,
+                             int capacity);
+
+// Fills an empty pool with views of the snapshot's quotes and with its movie titles
+// (copied into the pool's arena), keeping the snapshot's IDs. The pool's source stays
+// empty: the quotes live as long as the snapshot. Returns 1 on success.
+int snapshot_quote_pool(const IndexSnapshot *snapshot, QuotePool *pool);
+
+#endif // INDEX_SNAPSHOT_H
@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "load_generator.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+#define MIX_TOP_WORDS 1000         // Words asked from the server to build the default mix
+#define LOAD_READ_BUFFER (64 * 1024)
+#define MAX_LOAD_THREADS 256
+#define MAX_LOAD_DEPTH 4096
+
+// Query lines, each ending in '\n', back to back
+typedef struct QueryMix {
+    char *text;
+    size_t *offsets;           // Query q is text[offsets[q] .. offsets[q + 1])
+    int count;
+    int capacity;
+    size_t used;
+    size_t text_capacity;
+} QueryMix;
+
+// One client thread of a step, with its own connection
+typedef struct LoadClient {
+    const LoadTestOptions *options;
+    const QueryMix *mix;
+    int first;                 // Query the thread starts from, so the threads do not move in lockstep
+    double deadline_ms;
+    long completed;
+    long errors;               // Answers that were error lines
+    double *latencies;         // Milliseconds from sending a query to reading its answer
+    long latency_count;
+    long latency_capacity;
+    int failed;
+    pthread_t thread;
+} LoadClient;
+
+void init_load_test_options(LoadTestOptions *options) {
+    memset(options, 0, sizeof(*options));
+    options->thread_counts[0] = 1;
+    options->thread_counts[1] = 2;
+    options->thread_counts[2] = 4;
+    options->thread_counts[3] = 8;
+    options->step_count = 4;
+    options->seconds = 2.0;
+    options->depth = 16;
+}
+
+// Parses "1,2,4,8" into the thread counts of the steps
+static int parse_thread_counts(const char *text, LoadTestOptions *options) {
+    options->step_count = 0;
+    while (*text) {
+        char *end;
+        const long threads = strtol(text, &end, 10);
+        if (end == text || threads < 1 || threads > MAX_LOAD_THREADS || options->step_count == LOAD_MAX_STEPS) {
+            return 0;
+        }
+        options->thread_counts[options->step_count++] = (int)threads;
+        if (*end == ',') end++;
+        else if (*end != '\0') return 0;
+        text = end;
+    }
+    return options->step_count > 0;
+}
+
+int parse_load_test_option(int argc, char *argv[], int *i, LoadTestOptions *options) {
+    const char *option = argv[*i];
+    if (strncmp(option, "--load-", 7) != 0 || *i + 1 >= argc) return 0;
+
+    const char *value = argv[++*i];
+    int ok = 1;
+    if (strcmp(option, "--load-threads") == 0) {
+        ok = parse_thread_counts(value, options);
+    } else if (strcmp(option, "--load-seconds") == 0) {
+        options->seconds = atof(value);
+        ok = options->seconds > 0;
+    } else if (strcmp(option, "--load-depth") == 0) {
+        options->depth = atoi(value);
+        ok = options->depth > 0 && options->depth <= MAX_LOAD_DEPTH;
+    } else {
+        --*i;
+        return 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "Valor inválido para %s: '%s'.\n", option, value);
+        return -1;
+    }
+    return 1;
+}
+
+static int add_query(QueryMix *mix, const char *text, size_t length) {
+    if (mix->count + 1 >= mix->capacity) {
+        const int capacity = mix->capacity ? mix->capacity * 2 : 1024;
+        size_t *offsets = (size_t *)realloc(mix->offsets, capacity * sizeof(size_t));
+        if (!offsets) return 0;
+        mix->offsets = offsets;
+        mix->capacity = capacity;
+    }
+    if (mix->used + length + 1 > mix->text_capacity) {
+        size_t capacity = mix->text_capacity ? mix->text_capacity * 2 : 64 * 1024;
+        while (capacity < mix->used + length + 1) capacity *= 2;
+        char *grown = (char *)realloc(mix->text, capacity);
+        if (!grown) return 0;
+        mix->text = grown;
+        mix->text_capacity = capacity;
+    }
+    mix->offsets[mix->count++] = mix->used;
+    memcpy(mix->text + mix->used, text, length);
+    mix->used += length;
+    mix->text[mix->used++] = '\n';
+    mix->offsets[mix->count] = mix->used;
+    return 1;
+}
+
+static void free_query_mix(QueryMix *mix) {
+    free(mix->text);
+    free(mix->offsets);
+    memset(mix, 0, sizeof(*mix));
+}
+
+// The lines of the query file, without the blank ones and the comments
+static int read_query_mix(const char *filename, QueryMix *mix) {
+    MappedFile input;
+    if (!map_file(filename, &input)) return 0;
+    const char *line = input.data, *end = input.data + input.size;
+    int ok = 1;
+    while (ok && line < end) {
+        const char *newline = (const char *)memchr(line, '\n', end - line);
+        const char *line_end = newline ? newline : end;
+        const char *text = line;
+        while (text < line_end && (*text == ' ' || *text == '\t')) text++;
+        if (text < line_end && *text != '#') ok = add_query(mix, line, line_end - line);
+        line = newline ? newline + 1 : end;
+    }
+    unmap_file(&input);
+    if (!ok) perror("Falha ao ler as consultas");
+    return ok;
+}
+
+static int connect_to_server(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Caminho do socket longo demais: '%s'.\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Falha ao conectar em '%s': %s.\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int send_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        const ssize_t sent = send(fd, data, length, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return 0;
+        data += sent;
+        length -= sent;
+    }
+    return 1;
+}
+
+// Default mix, from the most frequent words of the index: a lookup of each word, a page of the
+// frequency range around every 8th word and a top-10 every 10th
+static int build_default_mix(const char *socket_path, QueryMix *mix) {
+    const int fd = connect_to_server(socket_path);
+    if (fd < 0) return 0;
+    char request[32];
+    snprintf(request, sizeof(request), "t %d\n", MIX_TOP_WORDS);
+    size_t capacity = 64 * 1024, used = 0;
+    char *answer = (char *)malloc(capacity);
+    int ok = answer && send_all(fd, request, strlen(request));
+    while (ok && (used == 0 || answer[used - 1] != '\n')) {
+        if (used == capacity) {
+            char *grown = (char *)realloc(answer, capacity * 2);
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            answer = grown;
+            capacity *= 2;
+        }
+        const ssize_t received = recv(fd, answer + used, capacity - used, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) ok = 0;
+        else used += received;
+    }
+    close(fd);
+    if (!ok) {
+        fprintf(stderr, "O servidor não respondeu ao pedido das palavras mais frequentes.\n");
+        free(answer);
+        return 0;
+    }
+    answer[used - 1] = '\0';
+
+    // t, K, number of words, word:frequency separated by commas
+    char *words = answer;
+    for (int tab = 0; tab < 3 && words; tab++) {
+        words = strchr(words, '\t');
+        if (words) words++;
+    }
+    char line[320];
+    int count = 0;
+    for (char *entry = words ? strtok(words, ",") : NULL; entry && ok; entry = strtok(NULL, ",")) {
+        char *colon = strrchr(entry, ':');
+        if (!colon) continue;
+        *colon = '\0';
+        const int frequency = atoi(colon + 1);
+        snprintf(line, sizeof(line), "w %s", entry);
+        ok = add_query(mix, line, strlen(line));
+        if (ok && count % 8 == 0) {
+            snprintf(line, sizeof(line), "f %d %d 0 20", frequency, frequency * 2);
+            ok = add_query(mix, line, strlen(line));
+        }
+        if (ok && count % 10 == 0) ok = add_query(mix, "t 10", 4);
+        count++;
+    }
+    free(answer);
+    if (!ok) perror("Falha ao montar as consultas");
+    if (ok && count == 0) {
+        fprintf(stderr, "O índice do servidor não tem palavras.\n");
+        ok = 0;
+    }
+    return ok;
+}
+
+static int record_latency(LoadClient *client, double latency) {
+    if (client->latency_count == client->latency_capacity) {
+        const long capacity = client->latency_capacity ? client->latency_capacity * 2 : 4096;
+        double *grown = (double *)realloc(client->latencies, capacity * sizeof(double));
+        if (!grown) return 0;
+        client->latencies = grown;
+        client->latency_capacity = capacity;
+    }
+    client->latencies[client->latency_count++] = latency;
+    return 1;
+}
+
+// Keeps 'depth' queries in flight until the deadline, then reads the answers still due.
+// Answers come back in order, one line each, so the n-th line answers the n-th query sent.
+static void* client_main(void *arg) {
+    LoadClient *client = (LoadClient *)arg;
+    const QueryMix *mix = client->mix;
+    const int depth = client->options->depth;
+    const int fd = connect_to_server(client->options->socket_path);
+    double *sent_at = (double *)malloc(depth * sizeof(double));
+    char *out = (char *)malloc(mix->used);
+    char *in = (char *)malloc(LOAD_READ_BUFFER);
+    if (fd < 0 || !sent_at || !out || !in) {
+        client->failed = 1;
+        if (fd >= 0) close(fd);
+        free(sent_at);
+        free(out);
+        free(in);
+        return NULL;
+    }
+
+    int next = client->first, oldest = 0, in_flight = 0, line_start = 1;
+    for (;;) {
+        double now = wall_clock_ms();
+        const int sending = now < client->deadline_ms;
+        if (!sending && in_flight == 0) break;
+
+        size_t out_used = 0;
+        while (sending && in_flight < depth) {
+            const size_t length = mix->offsets[next + 1] - mix->offsets[next];
+            if (out_used + length > mix->used) break;
+            memcpy(out + out_used, mix->text + mix->offsets[next], length);
+            out_used += length;
+            sent_at[(oldest + in_flight++) % depth] = now;
+            next = (next + 1) % mix->count;
+        }
+        if (out_used && !send_all(fd, out, out_used)) {
+            client->failed = 1;
+            break;
+        }
+
+        const ssize_t received = recv(fd, in, LOAD_READ_BUFFER, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) {
+            client->failed = 1;
+            break;
+        }
+        now = wall_clock_ms();
+        for (ssize_t b = 0; b < received; b++) {
+            if (line_start && in[b] == 'e') client->errors++;
+            line_start = in[b] == '\n';
+            if (!line_start) continue;
+            if (!record_latency(client, now - sent_at[oldest])) client->failed = 1;
+            oldest = (oldest + 1) % depth;
+            in_flight--;
+            client->completed++;
+        }
+        if (client->failed) break;
+    }
+    close(fd);
+    free(sent_at);
+    free(out);
+    free(in);
+    return NULL;
+}
+
+int run_load_test(const LoadTestOptions *options) {
+    QueryMix mix;
+    memset(&mix, 0, sizeof(mix));
+    const int mixed = options->query_file ? read_query_mix(options->query_file, &mix)
+                                          : build_default_mix(options->socket_path, &mix);
+    if (!mixed || mix.count == 0) {
+        if (mixed) fprintf(stderr, "O arquivo de consultas não tem consultas.\n");
+        free_query_mix(&mix);
+        return 0;
+    }
+    signal(SIGPIPE, SIG_IGN); // A server that goes away fails the step instead of killing the client
+
+    printf("\n--- Teste de carga em %s (%d consultas %s, %d em voo por conexão, %.1f s por etapa) ---\n",
+           options->socket_path, mix.count, options->query_file ? "do arquivo" : "geradas das palavras mais frequentes",
+           options->depth, options->seconds);
+    printf("%-8s %12s %14s %11s %10s %10s %10s\n", "Threads", "Consultas", "Consultas/s", "Aceleração", "p50 (us)",
+           "p99 (us)", "Erros");
+
+    int ok = 1;
+    double first_rate = 0.0;
+    for (int step = 0; step < options->step_count && ok; step++) {
+        const int threads = options->thread_counts[step];
+        LoadClient *clients = (LoadClient *)calloc(threads, sizeof(LoadClient));
+        if (!clients) {
+            perror("Falha ao alocar os clientes");
+            ok = 0;
+            break;
+        }
+        const double start = wall_clock_ms();
+        int started = 0;
+        for (int t = 0; t < threads; t++) {
+            clients[t].options = options;
+            clients[t].mix = &mix;
+            clients[t].first = (int)((long)mix.count * t / threads);
+            clients[t].deadline_ms = start + options->seconds * 1000.0;
+            if (pthread_create(&clients[t].thread, NULL, client_main, &clients[t]) != 0) break;
+            started++;
+        }
+        long completed = 0, errors = 0, latency_count = 0;
+        for (int t = 0; t < started; t++) {
+            pthread_join(clients[t].thread, NULL);
+            completed += clients[t].completed;
+            errors += clients[t].errors;
+            latency_count += clients[t].latency_count;
+            if (clients[t].failed) ok = 0;
+        }
+        const double elapsed = wall_clock_ms() - start;
+        if (started < threads) ok = 0;
+
+        double *latencies = (double *)malloc((latency_count ? latency_count : 1) * sizeof(double));
+        long merged = 0;
+        for (int t = 0; t < started && latencies; t++) {
+            memcpy(latencies + merged, clients[t].latencies, clients[t].latency_count * sizeof(double));
+            merged += clients[t].latency_count;
+        }
+        for (int t = 0; t < threads; t++) free(clients[t].latencies);
+        free(clients);
+        if (!ok || !latencies) {
+            fprintf(stderr, "Etapa com %d thread%s interrompida: conexão perdida ou falta de memória.\n", threads,
+                    threads > 1 ? "s" : "");
+            free(latencies);
+            ok = 0;
+            break;
+        }
+        qsort(latencies, merged, sizeof(double), compare_doubles);
+
+        const double rate = elapsed > 0 ? completed / (elapsed / 1000.0) : 0.0;
+        if (step == 0) first_rate = rate;
+        printf("%-8d %12ld %14.0f %10.2fx %10.1f %10.1f %10ld\n", threads, completed, rate,
+               first_rate > 0 ? rate / first_rate : 0.0, percentile(latencies, merged, 0.50) * 1000.0,
+               percentile(latencies, merged, 0.99) * 1000.0, errors);
+        free(latencies);
+    }
+    free_query_mix(&mix);
+    return ok;
+}
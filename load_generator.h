@@ -0,0 +1,28 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#define LOAD_MAX_STEPS 16
+
+// Settings of the load generator (--load-test)
+typedef struct LoadTestOptions {
+  const char *socket_path;          // Socket of a running server (--serve)
+  const char *query_file;           // Lines of the query language; NULL builds a mix from the server's top words
+  int thread_counts[LOAD_MAX_STEPS]; // Client threads of each step, one connection each
+  int step_count;
+  double seconds;                   // Duration of each step
+  int depth;                        // Requests each connection keeps in flight (1 = no pipelining)
+} LoadTestOptions;
+
+// Fills in the defaults: steps of 1, 2, 4 and 8 threads, 2 s each, 16 requests in flight.
+void init_load_test_options(LoadTestOptions *options);
+
+// Consumes the load test option at argv[*i] (and its value), advancing *i.
+// Returns 1 if it was one, 0 if not, -1 if its value is invalid.
+int parse_load_test_option(int argc, char *argv[], int *i, LoadTestOptions *options);
+
+// Drives the server with each thread count in turn, every thread cycling through the queries
+// on its own connection, and prints the queries per second, the speedup over the first step
+// and the p50/p99 latency of each step. Returns 1 on success.
+int run_load_test(const LoadTestOptions *options);
+
+#endif // LOAD_GENERATOR_H
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "structures.h"
 #include "file_parser.h"
 #include "word_processing.h"
@@ -7,29 +8,213 @@
 #include "bst_operations.h"
 #include "avl_operations.h"
 #include "freq_avl_operations.h"
+#include "hash_operations.h"
+#include "eytzinger_operations.h"
+#include "radix_operations.h"
+#include "boolean_operations.h"
+#include "phrase_operations.h"
+#include "ranking_operations.h"
+#include "quote_pool.h"
+#include "posting_operations.h"
+#include "arena.h"
 #include "utils.h"
+#include "tokenizer.h"
+#include "index_snapshot.h"
+#include "query_operations.h"
+#include "benchmark.h"
+#include "query_engine.h"
+#include "query_server.h"
+#include "load_generator.h"
+#include "reload_stress.h"
+#include "perf_counters.h"
 
+#define FREQ_PAGE_SIZE 20 // Palavras por página na busca por frequência
+#define MAX_TOP_K 1000    // Maior K aceito pelo menu
+#define MAX_COMPLETIONS 100 // Maior número de sugestões do autocompletar
+#define FUZZY_SUGGESTIONS 10 // Palavras mostradas pela busca aproximada
+#define MAX_RANKED 100      // Maior número de frases da busca ranqueada
+#define QUOTE_PAGE_SIZE 20  // Citações por página nas buscas booleana e por frase
 
-WordVector word_vector = {NULL, 0, 0};
-BSTNode *bst_root = NULL;
-AVLNode *avl_root = NULL;
-FreqAVLNode *freq_avl_root = NULL;
-int data_loaded = 0;
 
+EngineHandle engines; // Publica o índice atual; um novo só substitui o anterior depois de pronto
+Engine *engine = NULL; // Índice carregado (CSV ou snapshot); NULL enquanto não há dados
+int quiet_mode = 0; // Modo batch: a saída padrão recebe só os resultados das consultas
+double index_ready_time_ms = -1.0; // Carregamento do CSV ou abertura do snapshot, informado pelo modo batch
+LoadOptions load_options = { .compare_incremental_trees = 1, .threads = 0 };
+PerfCounters menu_perf_counters;
+PerfCounters *menu_perf = NULL; // --perf: contadores das buscas do menu; NULL se desligados ou indisponíveis
 
 void display_menu();
 void handle_load_file();
+int load_corpus(const char *filename);
+void handle_append_file();
+int append_corpus(const char *filename);
+QueryIndex current_query_index();
+int run_batch(const char *corpus, BatchOptions *options);
+int run_stats(const char *corpus);
+int run_server(const char *corpus, ServerOptions *options);
 void handle_search_word();
 void handle_search_frequency();
+void handle_top_words();
+void handle_complete_prefix();
+char* read_query_line();
+void handle_boolean_search();
+void handle_phrase_search();
+void handle_fuzzy_search();
+void handle_ranked_search();
+void handle_memory_stats();
+void display_quote_ids(const int *ids, int total);
+void handle_save_snapshot();
+int open_snapshot(const char *filename);
+void handle_open_snapshot();
+void install_engine(Engine *fresh);
+void discard_loaded_data();
 void cleanup_memory();
-void display_citations(CitationInfo *citations);
+void display_citations(const PostingList *postings, const QuotePool *pool);
 
 
-int main() {
+int main(int argc, char *argv[]) {
     int choice;
+    const char *snapshot_path = NULL;
+    const char *batch_corpus = NULL;
+    const char *stats_corpus = NULL;
+    const char *structure_name = NULL;
+    BatchOptions batch_options = { NULL, NULL, 1, QUERY_VECTOR, 0 };
+    const char *serve_corpus = NULL;
+    ServerOptions server_options = { DEFAULT_SERVER_SOCKET, 0, QUERY_VECTOR, NULL, NULL };
+    LoadTestOptions load_test_options;
+    int run_load = 0, load_status;
+    ReloadStressOptions stress_options;
+    int stress_status;
+    BenchmarkOptions bench_options;
+    int run_bench = 0, bench_status;
+    const char *corpus_path = NULL; // --generate-corpus só gera o corpus sintético
+    long corpus_lines = 0;
+    int corpus_vocabulary = 0;
+    init_benchmark_options(&bench_options);
+    init_load_test_options(&load_test_options);
+    init_reload_stress_options(&stress_options);
+    init_engine_handle(&engines);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            load_options.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--positions") == 0) {
+            load_options.positions = 1;
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            load_options.perf_counters = batch_options.perf_counters = 1;
+        } else if (strcmp(argv[i], "--bench-tokenizer") == 0 && i + 1 < argc) {
+            return run_tokenizer_benchmark(argv[i + 1]);
+        } else if (strcmp(argv[i], "--open-index") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--generate-corpus") == 0 && i + 3 < argc) {
+            corpus_path = argv[++i];
+            corpus_lines = atol(argv[++i]);
+            corpus_vocabulary = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            run_bench = 1;
+        } else if ((bench_status = parse_benchmark_option(argc, argv, &i, &bench_options)) != 0) {
+            if (bench_status < 0) return 1;
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_corpus = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            stats_corpus = argv[++i];
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            batch_options.query_file = argv[++i];
+        } else if (strcmp(argv[i], "--structure") == 0 && i + 1 < argc) {
+            structure_name = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            batch_options.output_file = argv[++i];
+            batch_options.write_results = strcmp(batch_options.output_file, "none") != 0;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            serve_corpus = argv[++i];
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            server_options.socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            server_options.workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--load-test") == 0) {
+            run_load = 1;
+        } else if ((load_status = parse_load_test_option(argc, argv, &i, &load_test_options)) != 0) {
+            if (load_status < 0) return 1;
+        } else if (strcmp(argv[i], "--stress-reload") == 0 && i + 1 < argc) {
+            stress_options.corpus = argv[++i];
+        } else if ((stress_status = parse_reload_stress_option(argc, argv, &i, &stress_options)) != 0) {
+            if (stress_status < 0) return 1;
+        } else {
+            fprintf(stderr, "Uso: %s [--threads N] [--positions] [--perf] [--open-index SNAPSHOT] [--bench-tokenizer ARQUIVO]\n"
+                            "       %s --batch CORPUS [--queries ARQUIVO|-] [--structure vector|eytzinger|bst|avl|hash|radix]\n"
+                            "          [--output ARQUIVO|none] [--threads N] [--positions] [--perf]\n"
+                            "       %s --stats CORPUS [--threads N] [--positions]\n"
+                            "       %s --serve CORPUS [--socket CAMINHO] [--workers N] [--structure ...] [--threads N]\n"
+                            "          [--positions]\n"
+                            "       %s --load-test [--socket CAMINHO] [--queries ARQUIVO] [--load-threads 1,2,4,8]\n"
+                            "          [--load-seconds S] [--load-depth N]\n"
+                            "       %s --stress-reload CORPUS [--stress-readers N] [--stress-reloads N] [--threads N]\n"
+                            "          [--positions]\n"
+                            "       %s --benchmark [--bench-sizes 10000,100000,1000000] [--bench-vocab N] [--bench-zipf S]\n"
+                            "          [--bench-reps N] [--bench-load-reps N] [--bench-lookups N] [--bench-seed N]\n"
+                            "          [--bench-dir DIR] [--bench-keep] [--bench-incremental]\n"
+                            "          [--bench-csv ARQUIVO|none] [--bench-json ARQUIVO|none] [--threads N]\n"
+                            "       %s --generate-corpus ARQUIVO LINHAS VOCABULÁRIO [--bench-zipf S] [--bench-seed N]\n",
+                    argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    if (corpus_path) {
+        return generate_zipf_corpus(corpus_path, corpus_lines, corpus_vocabulary, bench_options.zipf_exponent,
+                                    bench_options.seed) ? 0 : 1;
+    }
+
+    if (run_bench) {
+        bench_options.threads = load_options.threads;
+        return run_benchmark(&bench_options) ? 0 : 1;
+    }
+
+    if (run_load) {
+        load_test_options.socket_path = server_options.socket_path;
+        load_test_options.query_file = batch_options.query_file;
+        return run_load_test(&load_test_options) ? 0 : 1;
+    }
+
+    if (stress_options.corpus) {
+        load_options.compare_incremental_trees = 0;
+        load_options.quiet = 1;
+        return run_reload_stress(&stress_options, &load_options) ? 0 : 1;
+    }
+
+    if (structure_name) {
+        int structure = parse_query_structure(structure_name);
+        if (structure < 0) {
+            fprintf(stderr, "Estrutura desconhecida: '%s'.\n", structure_name);
+            return 1;
+        }
+        batch_options.structure = server_options.structure = (QueryStructure)structure;
+    }
+
+    if (batch_corpus) {
+        return run_batch(batch_corpus, &batch_options) ? 0 : 1;
+    }
+
+    if (stats_corpus) {
+        return run_stats(stats_corpus) ? 0 : 1;
+    }
+
+    if (serve_corpus) {
+        return run_server(serve_corpus, &server_options) ? 0 : 1;
+    }
 
     atexit(cleanup_memory);
 
+    // As buscas do menu rodam neste thread; a carga abre os seus próprios contadores
+    if (load_options.perf_counters && open_perf_counters(&menu_perf_counters, 0) > 0) {
+        menu_perf = &menu_perf_counters;
+    }
+
+    if (snapshot_path && !open_snapshot(snapshot_path)) {
+        return 1;
+    }
+
     do {
         display_menu();
         printf("Entre com a sua escolha: ");
@@ -46,19 +231,85 @@ int main() {
                 handle_load_file();
                 break;
             case 2:
-                if (!data_loaded) {
+                if (!engine) {
                     printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
                 } else {
                     handle_search_word();
                 }
                 break;
             case 3:
-                if (!data_loaded) {
+                if (!engine) {
                     printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
                 } else {
                     handle_search_frequency();
                 }
                 break;
+            case 4:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_save_snapshot();
+                }
+                break;
+            case 5:
+                handle_open_snapshot();
+                break;
+            case 6:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_top_words();
+                }
+                break;
+            case 7:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_append_file();
+                }
+                break;
+            case 8:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_complete_prefix();
+                }
+                break;
+            case 9:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_boolean_search();
+                }
+                break;
+            case 10:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_phrase_search();
+                }
+                break;
+            case 11:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_fuzzy_search();
+                }
+                break;
+            case 12:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_ranked_search();
+                }
+                break;
+            case 13:
+                if (!engine) {
+                    printf("Erro: dados não foram carregados. Por favor, carregue um arquivo primeiro (Opção 1).\n");
+                } else {
+                    handle_memory_stats();
+                }
+                break;
             case 0:
                 printf("Saindo do programa.\n");
                 break;
@@ -82,6 +333,16 @@ void display_menu() {
     "1. Carregar arquivo de citações\n"
     "2. Busca por palavra\n"
     "3. Busca por intervalo de frequência\n"
+    "4. Salvar índice (snapshot)\n"
+    "5. Abrir índice salvo (snapshot)\n"
+    "6. Palavras mais frequentes (top-K)\n"
+    "7. Anexar arquivo de citações ao índice\n"
+    "8. Autocompletar (busca por prefixo)\n"
+    "9. Busca booleana (AND, OR, NOT)\n"
+    "10. Busca por frase exata\n"
+    "11. Busca aproximada (erros de digitação)\n"
+    "12. Busca ranqueada (BM25)\n"
+    "13. Memória por estrutura (stats)\n"
     "0. Sair\n"
     "----------------------------------------\n");
 }
@@ -89,19 +350,121 @@ void display_menu() {
 void handle_load_file() {
     char filename[256];
 
-    if (data_loaded) {
-        printf("Eliminando dados existentes\n");
-        cleanup_memory();
+    printf("Entre com o nome do arquivo (ex.: movie_quotes.txt): ");
+    if (scanf("%255s", filename) != 1) {
+        printf("Erro ao ler o arquivo\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
 
-        word_vector.words = NULL; word_vector.size = 0; word_vector.capacity = 0;
-        bst_root = NULL;
-        avl_root = NULL;
-        freq_avl_root = NULL;
-        data_loaded = 0;
-        printf("Dados existentes foram eliminados\n");
+    load_corpus(filename);
+}
+
+// Carrega o CSV e monta todas as estruturas; o relatório não é impresso no modo batch.
+// O índice anterior continua consultável até o novo estar pronto, e sobrevive a uma falha
+int load_corpus(const char *filename) {
+    EngineLoadReport report;
+    Engine *fresh = load_engine(filename, &load_options, &report);
+    if (!fresh) {
+        if (!quiet_mode) {
+            printf("Falha ao carregar os dados do arquivo '%s'.%s\n", filename,
+                   engine ? " O índice anterior continua carregado." : "");
+        }
+        return 0;
     }
+    install_engine(fresh);
+    index_ready_time_ms = report.total_time_ms;
+    if (quiet_mode) return 1;
 
-    printf("Entre com o nome do arquivo (ex.: movie_quotes.txt): ");
+    const LoadTimes times = report.times;
+    printf("\n--- Tempo de carregamento dos dados (%d thread%s) ---\n", times.threads, times.threads > 1 ? "s" : "");
+    printf("Leitura e tokenização        : %.4f ms", times.parse_time_ms);
+    if (times.parse_time_ms > 0) {
+        printf(" (%.2f MB/s)", (times.input_bytes / (1024.0 * 1024.0)) / (times.parse_time_ms / 1000.0));
+    }
+    printf("\n");
+    printf("Vocabulários locais          : %.4f ms\n", times.local_build_time_ms);
+    printf("Junção dos vocabulários      : %.4f ms\n", times.merge_time_ms);
+    printf("Construção das estruturas    : %.4f ms\n", times.tree_build_time_ms);
+    printf("Vetor (busca binária)        : %.4f ms\n", times.vector_time_ms);
+    if (times.bst_time_ms >= 0) {
+        printf("Árvore de Busca Binária (ABB): %.4f ms (inserção por palavra)\n", times.bst_time_ms);
+        printf("Árvore AVL                   : %.4f ms (inserção por palavra)\n", times.avl_time_ms);
+    }
+    printf("ABB balanceada (em lote)     : %.4f ms\n", times.bst_bulk_time_ms);
+    printf("AVL balanceada (em lote)     : %.4f ms\n", times.avl_bulk_time_ms);
+    printf("Tabela hash                  : %.4f ms\n", times.hash_time_ms);
+    if (times.perf_recorded) {
+        static const char *phase_names[LOAD_PHASE_COUNT] = {
+            "Leitura e tokenização", "Vocabulários locais", "Junção", "ABB, AVL e hash", "ABB por palavra",
+            "AVL por palavra"
+        };
+        printf("\n--- Contadores de hardware das fases (todas as threads) ---\n");
+        print_perf_header(stdout, "Fase");
+        for (int p = 0; p < LOAD_PHASE_COUNT; p++) {
+            if (times.perf[p].runs > 0) print_perf_row(stdout, phase_names[p], &times.perf[p], 1.0);
+        }
+    }
+
+    printf("\nOrdenando as palavras por frequência\n");
+    if (report.freq_order_built) {
+        printf("Ordem construída com sucesso (%.4f ms).\n", report.freq_order_time_ms);
+    } else {
+        printf("Aviso: construção da ordem por frequência falhou.\n");
+    }
+
+    printf("\nConstruindo Árvore AVL de frequência\n");
+    if (engine->freq_avl) {
+        printf("Árvore construída com sucesso (%.4f ms).\n", report.freq_avl_time_ms);
+    } else {
+        printf("Aviso: construção da Árvore AVL falhou ou gerou uma árvore vazia.\n");
+    }
+
+    printf("\nConstruindo layout Eytzinger do vetor\n");
+    if (report.eytzinger_built) {
+        printf("Layout construído com sucesso (%.4f ms).\n", report.eytzinger_time_ms);
+    } else {
+        printf("Aviso: construção do layout Eytzinger falhou.\n");
+    }
+
+    printf("\nConstruindo árvore radix (autocompletar)\n");
+    if (engine->radix) {
+        printf("Árvore construída com sucesso (%.4f ms).\n", report.radix_time_ms);
+    } else {
+        printf("Aviso: construção da árvore radix falhou ou gerou uma árvore vazia.\n");
+    }
+
+    printf("\nDecodificando as listas de frases (buscas booleana e ranqueada)\n");
+    if (report.quote_ids_built) {
+        printf("Listas construídas com sucesso (%.4f ms, %.2f MB).\n", report.quote_ids_time_ms,
+               engine->quote_ids.offsets[engine->quote_ids.size] * 2 * sizeof(int) / (1024.0 * 1024.0));
+    } else {
+        printf("Aviso: listas não construídas; as buscas booleana e ranqueada vão decodificar as citações.\n");
+    }
+
+    printf("\nContando ocorrências por ano (top-K)\n");
+    if (report.year_counts_built) {
+        printf("Contagens construídas com sucesso (%.4f ms).\n", report.year_counts_time_ms);
+    } else {
+        printf("Aviso: contagens por ano não construídas; o filtro por ano vai ler as citações.\n");
+    }
+
+    printf("\nCarregamento completo: %.4f ms\n", report.total_time_ms);
+
+    print_index_arena_report(&engine->arena);
+    return 1;
+}
+
+void handle_append_file() {
+    char filename[256];
+
+    if (engine->snapshot_open) {
+        printf("Erro: um snapshot não recebe novas frases. Carregue um arquivo de citações (Opção 1).\n");
+        return;
+    }
+
+    printf("Entre com o nome do arquivo a anexar (ex.: more_quotes.txt): ");
     if (scanf("%255s", filename) != 1) {
         printf("Erro ao ler o arquivo\n");
         clear_input_buffer();
@@ -109,35 +472,143 @@ void handle_load_file() {
     }
     clear_input_buffer();
 
-    const LoadTimes times = load_data_from_file(filename, &word_vector, &bst_root, &avl_root);
-
-    if (times.vector_time_ms >= 0) {
-        printf("\n--- Tempo de carregamento dos dados ---\n");
-        printf("Vetor (busca binária)        : %.4f ms\n", times.vector_time_ms);
-        printf("Árvore de Busca Binária (ABB): %.4f ms\n", times.bst_time_ms);
-        printf("Árvore AVL                   : %.4f ms\n", times.avl_time_ms);
-        data_loaded = 1;
-
-        printf("\nConstruindo Árvore AVL de frequência\n");
-        const clock_t start_freq = timer_start();
-        freq_avl_root = build_freq_avl_from_vector(&word_vector);
-        const double freq_build_time = timer_stop(start_freq);
-        if (freq_avl_root) {
-            printf("Árvore construída com sucesso (%.4f ms).\n", freq_build_time);
-        } else {
-            printf("Aviso: construção da Árvore AVL falhou ou gerou uma árvore vazia.\n");
+    append_corpus(filename);
+}
+
+// Junta o CSV ao índice carregado sem descartá-lo; só as cópias do vetor e da árvore de
+// frequência são refeitas, com uma passada linear e sem ordenar
+int append_corpus(const char *filename) {
+    EngineAppendReport report;
+    if (!append_engine(engine, filename, &load_options, &report)) {
+        if (!report.times.index_kept) {
+            discard_loaded_data();
         }
+        printf("Falha ao anexar os dados do arquivo '%s'.\n", filename);
+        return 0;
+    }
+    // As contagens por ano seguem o rank de frequência, que mudou: são refeitas no próximo
+    // top-K com filtro de anos, e só se ele for pedido
 
+    const AppendTimes times = report.times;
+    printf("\n--- Tempo de anexação (%d thread%s) ---\n", times.threads, times.threads > 1 ? "s" : "");
+    printf("Leitura e tokenização        : %.4f ms", times.parse_time_ms);
+    if (times.parse_time_ms > 0) {
+        printf(" (%.2f MB/s)", (times.input_bytes / (1024.0 * 1024.0)) / (times.parse_time_ms / 1000.0));
+    }
+    printf("\n");
+    printf("Vocabulário do arquivo novo  : %.4f ms\n", times.vocabulary_time_ms);
+    printf("Citações das palavras antigas: %.4f ms (%d palavras)\n", times.postings_time_ms, times.updated_words);
+    printf("Árvore AVL de frequência     : %.4f ms (remoção e reinserção)\n", times.freq_avl_time_ms);
+    printf("Vetor (junção das novas)     : %.4f ms (%d palavras)\n", times.vector_time_ms, times.new_words);
+    printf("ABB, AVL, hash e radix       : %.4f ms (inserção das novas)\n", times.tree_time_ms);
+    if (report.eytzinger_built) {
+        printf("Layout Eytzinger             : %.4f ms\n", report.eytzinger_time_ms);
     } else {
-        printf("Falha ao carregar os dados do arquivo '%s'.\n", filename);
-        data_loaded = 0;
+        printf("Aviso: construção do layout Eytzinger falhou.\n");
+    }
+    if (report.freq_order_built) {
+        printf("Ordem por frequência         : %.4f ms\n", report.freq_order_time_ms);
+    } else {
+        printf("Aviso: construção da ordem por frequência falhou.\n");
+    }
+    if (report.quote_ids_built) {
+        printf("Listas de frases (booleana)  : %.4f ms\n", report.quote_ids_time_ms);
+    } else {
+        printf("Aviso: listas de frases não construídas; a busca booleana vai decodificar as citações.\n");
+    }
+
+    printf("\nAnexação completa: %.4f ms (%d frases; índice com %d palavras e %d frases)\n", report.total_time_ms,
+           times.quote_count, engine->vector.size, engine->pool.quote_count);
+
+    print_index_arena_report(&engine->arena);
+    return 1;
+}
+
+// Visão somente leitura do índice carregado, usada pelas consultas
+QueryIndex current_query_index() {
+    return engine_query_index(engine);
+}
+
+// Modo batch: carrega o CSV (ou abre o snapshot) e executa o arquivo de consultas
+int run_batch(const char *corpus, BatchOptions *options) {
+    quiet_mode = 1;
+    load_options.compare_incremental_trees = 0; // Só interessa o índice final
+    load_options.quiet = 1;
+
+    const int is_snapshot = is_index_snapshot(corpus);
+    if (!is_snapshot && options->structure == QUERY_SNAPSHOT) {
+        fprintf(stderr, "A estrutura 'snapshot' exige um arquivo de snapshot em --batch.\n");
+        return 0;
+    }
+    if (!(is_snapshot ? open_snapshot(corpus) : load_corpus(corpus))) {
+        fprintf(stderr, "Falha ao carregar '%s'.\n", corpus);
+        return 0;
+    }
+    fprintf(stderr, "Índice pronto em %.3f ms (%s).\n", index_ready_time_ms, is_snapshot ? "snapshot" : "CSV");
+    if (is_snapshot && options->structure != QUERY_SNAPSHOT) {
+        options->structure = QUERY_SNAPSHOT; // Um snapshot só é consultado no arquivo mapeado
+    }
+
+    const QueryIndex index = current_query_index();
+    const int ok = run_batch_queries(&index, options);
+    cleanup_memory();
+    return ok;
+}
+
+// Modo stats: carrega o CSV (ou abre o snapshot), mostra a memória de cada estrutura e sai
+int run_stats(const char *corpus) {
+    quiet_mode = 1;
+    load_options.compare_incremental_trees = 0; // A comparação não faz parte do índice
+    load_options.quiet = 1;
+
+    const int is_snapshot = is_index_snapshot(corpus);
+    if (!(is_snapshot ? open_snapshot(corpus) : load_corpus(corpus))) {
+        fprintf(stderr, "Falha ao carregar '%s'.\n", corpus);
+        return 0;
     }
+    printf("Índice de '%s' pronto em %.3f ms (%s).\n", corpus, index_ready_time_ms, is_snapshot ? "snapshot" : "CSV");
+    print_engine_memory_report(engine);
+    cleanup_memory();
+    return 1;
+}
+
+// Modo servidor: carrega o índice uma vez e atende consultas pelo socket até Ctrl+C
+int run_server(const char *corpus, ServerOptions *options) {
+    quiet_mode = 1;
+    load_options.compare_incremental_trees = 0;
+    load_options.quiet = 1;
+
+    const int is_snapshot = is_index_snapshot(corpus);
+    if (!(is_snapshot ? open_snapshot(corpus) : load_corpus(corpus))) {
+        fprintf(stderr, "Falha ao carregar '%s'.\n", corpus);
+        return 0;
+    }
+    fprintf(stderr, "Índice pronto em %.3f ms (%s, %d frases).\n", index_ready_time_ms,
+            is_snapshot ? "snapshot" : "CSV", engine->pool.quote_count);
+    if (is_snapshot) {
+        options->structure = QUERY_SNAPSHOT;
+    } else if (options->structure == QUERY_SNAPSHOT) {
+        fprintf(stderr, "A estrutura 'snapshot' exige um arquivo de snapshot em --serve.\n");
+        cleanup_memory();
+        return 0;
+    }
+
+    // Daqui em diante o índice só é lido: os workers o compartilham sem travas, e uma
+    // recarga (SIGHUP) publica um índice novo sem parar as consultas
+    options->reload_path = corpus;
+    options->load_options = &load_options;
+    const int ok = run_query_server(&engines, options);
+    engine = atomic_load(&engines.current); // As recargas já liberaram o primeiro índice
+    cleanup_memory();
+    return ok;
 }
 
 void handle_search_word() {
     char search_term[100];
     char *normalized_term = NULL;
     WordInfo *found_info = NULL;
+    PerfSample search_perf[5]; // Contadores de cada estrutura, com --perf
+    memset(search_perf, 0, sizeof(search_perf));
 
     printf("Entre com a palavra desejada para a busca: ");
     if (scanf("%99s", search_term) != 1) {
@@ -156,49 +627,112 @@ void handle_search_word() {
     printf("Procurando pela palavra: '%s'\n", normalized_term);
     printf("----------------------------------------\n");
 
+    if (engine->snapshot_open) {
+        // O snapshot é consultado direto no arquivo; as demais estruturas não são montadas
+        WordInfo view;
+        printf("1. Busca no snapshot mapeado (busca binária)\n");
+        uint64_t start_time = timer_start();
+        if (menu_perf) perf_start(menu_perf);
+        int found = search_snapshot(&engine->snapshot, normalized_term, &view);
+        if (menu_perf) perf_stop(menu_perf, &search_perf[0]);
+        double elapsed_time = timer_stop(start_time);
+        if (found) {
+            printf("   Palavra encontrada! Frequência: %d (Tempo de busca: %.6f ms)\n", view.frequency, elapsed_time);
+            display_citations(&view.postings, &engine->pool);
+        } else {
+            printf("   Palavra não encontrada no snapshot (Tempo de busca: %.6f ms)\n", elapsed_time);
+        }
+        printf("----------------------------------------\n");
+        if (menu_perf) {
+            print_perf_header(stdout, "Contadores da busca");
+            print_perf_row(stdout, "Snapshot", &search_perf[0], 1.0);
+        }
+        free(normalized_term);
+        return;
+    }
+
     printf("1. Busca no vetor (busca binária)\n");
-    clock_t start_time = timer_start();
-    found_info = search_vector(&word_vector, normalized_term);
+    uint64_t start_time = timer_start();
+    if (menu_perf) perf_start(menu_perf);
+    found_info = search_vector(&engine->vector, normalized_term);
+    if (menu_perf) perf_stop(menu_perf, &search_perf[0]);
     double elapsed_time = timer_stop(start_time);
     if (found_info) {
         printf("   Palavra encontrada! Frequência: %d (Tempo de busca: %.6f ms)\n", found_info->frequency, elapsed_time);
-        display_citations(found_info->citations);
+        display_citations(&found_info->postings, &engine->pool);
     } else {
         printf("   Palavra não encontrada no vetor (Tempo de busca: %.6f ms).\n", elapsed_time);
     }
     printf("----------------------------------------\n");
 
-    printf("2. Busca na Árvore de Busca Binária (ABB)\n");
+    printf("2. Busca no vetor (layout Eytzinger)\n");
     start_time = timer_start();
-    found_info = search_bst(bst_root, normalized_term);
+    if (menu_perf) perf_start(menu_perf);
+    found_info = search_eytzinger(&engine->eytzinger, normalized_term);
+    if (menu_perf) perf_stop(menu_perf, &search_perf[1]);
     elapsed_time = timer_stop(start_time);
     if (found_info) {
         printf("   Palavra encontrada! Frequência: %d (Tempo de busca: %.6f ms)\n", found_info->frequency, elapsed_time);
-        display_citations(found_info->citations);
+        display_citations(&found_info->postings, &engine->pool);
+    } else {
+        printf("   Palavra não encontrada no layout Eytzinger (Tempo de busca: %.6f ms)\n", elapsed_time);
+    }
+    printf("----------------------------------------\n");
+
+    printf("3. Busca na Árvore de Busca Binária (ABB)\n");
+    start_time = timer_start();
+    if (menu_perf) perf_start(menu_perf);
+    found_info = search_bst(engine->bst, normalized_term);
+    if (menu_perf) perf_stop(menu_perf, &search_perf[2]);
+    elapsed_time = timer_stop(start_time);
+    if (found_info) {
+        printf("   Palavra encontrada! Frequência: %d (Tempo de busca: %.6f ms)\n", found_info->frequency, elapsed_time);
+        display_citations(&found_info->postings, &engine->pool);
     } else {
         printf("   Palavra não encontrada na ABB (Tempo de busca: %.6f ms)\n", elapsed_time);
     }
     printf("----------------------------------------\n");
 
-    printf("3. Busca na Árvore AVL\n");
+    printf("4. Busca na Árvore AVL\n");
     start_time = timer_start();
-    found_info = search_avl(avl_root, normalized_term);
+    if (menu_perf) perf_start(menu_perf);
+    found_info = search_avl(engine->avl, normalized_term);
+    if (menu_perf) perf_stop(menu_perf, &search_perf[3]);
     elapsed_time = timer_stop(start_time);
     if (found_info) {
         printf("   Palavra encontrada! Frequência: %d (Tempo de busca: %.6f ms)\n", found_info->frequency, elapsed_time);
-        display_citations(found_info->citations);
+        display_citations(&found_info->postings, &engine->pool);
     } else {
         printf("   Palavra não encontrada na AVL (Tempo de busca: %.6f ms)\n", elapsed_time);
     }
     printf("----------------------------------------\n");
 
+    printf("5. Busca na Tabela hash\n");
+    start_time = timer_start();
+    if (menu_perf) perf_start(menu_perf);
+    found_info = search_hash_index(&engine->hash, normalized_term);
+    if (menu_perf) perf_stop(menu_perf, &search_perf[4]);
+    elapsed_time = timer_stop(start_time);
+    if (found_info) {
+        printf("   Palavra encontrada! Frequência: %d (Tempo de busca: %.6f ms)\n", found_info->frequency, elapsed_time);
+        display_citations(&found_info->postings, &engine->pool);
+    } else {
+        printf("   Palavra não encontrada na tabela hash (Tempo de busca: %.6f ms)\n", elapsed_time);
+    }
+    printf("----------------------------------------\n");
+
     free(normalized_term);
+    if (menu_perf) {
+        static const char *structure_names[5] = { "Vetor", "Vetor (Eytzinger)", "ABB", "AVL", "Tabela hash" };
+        print_perf_header(stdout, "Contadores da busca");
+        for (int s = 0; s < 5; s++) print_perf_row(stdout, structure_names[s], &search_perf[s], 1.0);
+    }
 }
 
 void handle_search_frequency() {
     int min_freq, max_freq;
 
-    if (!freq_avl_root) {
+    if (!engine->freq_avl && !engine->snapshot_open) {
         printf("Erro: Árvore AVL não construída ou vazia.\n");
         return;
     }
@@ -220,24 +754,552 @@ void handle_search_frequency() {
     clear_input_buffer();
 
     printf("\n--- Procurando por palavras com frequência entre %d e %d ---\n", min_freq, max_freq);
-    printf("(Usando Árvore AVL organizada por frequência)\n");
+    if (engine->snapshot_open) {
+        printf("(Usando a ordem por frequência do snapshot)\n");
+    } else {
+        printf("(Usando Árvore AVL organizada por frequência)\n");
+    }
+
+    // A contagem usa o tamanho das subárvores, sem percorrer as palavras
+    const QueryIndex index = current_query_index();
+    PerfSample count_perf, page_perf; // Com --perf
+    memset(&count_perf, 0, sizeof(count_perf));
+    memset(&page_perf, 0, sizeof(page_perf));
+    uint64_t start_time = timer_start();
+    if (menu_perf) perf_start(menu_perf);
+    const int total = count_freq_range(&index, min_freq, max_freq);
+    if (menu_perf) perf_stop(menu_perf, &count_perf);
+    double elapsed_time = timer_stop(start_time);
+    printf("%d palavra%s no intervalo (contagem em %.6f ms).\n", total, total == 1 ? "" : "s", elapsed_time);
+
+    WordInfo page[FREQ_PAGE_SIZE];
+    int offset = 0;
+    while (offset < total) {
+        start_time = timer_start();
+        if (menu_perf) perf_start(menu_perf);
+        const int found = page_freq_range(&index, min_freq, max_freq, offset, page, FREQ_PAGE_SIZE);
+        if (menu_perf) perf_stop(menu_perf, &page_perf);
+        elapsed_time = timer_stop(start_time);
+        if (found == 0) break;
+
+        for (int i = 0; i < found; i++) {
+            printf("  - Word: '%s', Frequency: %d\n", page[i].word, page[i].frequency);
+        }
+        printf("Resultados %d-%d de %d (página em %.6f ms).\n", offset + 1, offset + found, total, elapsed_time);
+        offset += found;
+
+        if (offset < total) {
+            printf("Enter para a próxima página, 'q' para voltar: ");
+            int c = getchar();
+            if (c != '\n' && c != EOF) clear_input_buffer();
+            if (c == 'q' || c == 'Q' || c == EOF) break;
+        }
+    }
+    printf("----------------------------------------\n");
+    if (menu_perf) {
+        print_perf_header(stdout, "Contadores do intervalo");
+        print_perf_row(stdout, "Contagem", &count_perf, 1.0);
+        if (page_perf.runs > 0) print_perf_row(stdout, "Página (média)", &page_perf, (double)page_perf.runs);
+    }
+}
 
-    clock_t start_time = timer_start();
-    search_freq_range_avl(freq_avl_root, min_freq, max_freq); // Realiza a busca
+void handle_top_words() {
+    int k, min_length, min_year, max_year;
+
+    printf("Quantas palavras (K, até %d): ", MAX_TOP_K);
+    if (scanf("%d", &k) != 1 || k < 1 || k > MAX_TOP_K) {
+        printf("K inválido.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    printf("Tamanho mínimo da palavra (0 = qualquer): ");
+    if (scanf("%d", &min_length) != 1 || min_length < 0) {
+        printf("Tamanho inválido.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    printf("Intervalo de anos (ex.: 1980 1989; 0 0 = todos): ");
+    if (scanf("%d %d", &min_year, &max_year) != 2 || min_year > max_year) {
+        printf("Intervalo de anos inválido.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    TopKEntry top[MAX_TOP_K];
+    const TopKFilter filter = { min_length, min_year, max_year };
+    const QueryIndex index = current_query_index();
+    if (max_year > 0 && engine->year_counts.size == 0 && engine->freq_order.size > 0) {
+        // Descartadas pela última anexação
+        const uint64_t start_years = timer_start();
+        if (build_year_counts(&engine->year_counts, &index)) {
+            printf("Contagens por ano refeitas em %.4f ms.\n", timer_stop(start_years));
+        }
+    }
+    uint64_t start_time = timer_start();
+    const int found = top_k_words(&index, k, &filter, top);
     double elapsed_time = timer_stop(start_time);
 
+    printf("\n--- %d palavras mais frequentes", k);
+    if (min_length > 0) printf(", com %d letras ou mais", min_length);
+    if (max_year > 0) printf(", em filmes de %d a %d", min_year, max_year);
+    printf(" ---\n");
+    for (int i = 0; i < found; i++) {
+        printf("%4d. %-24s %d\n", i + 1, top[i].word, top[i].frequency);
+    }
+    if (found == 0) {
+        printf("Nenhuma palavra passa pelos filtros.\n");
+    }
+    printf("----------------------------------------\n");
+    printf("Top-K concluído em %.6f ms.\n", elapsed_time);
+}
+
+void handle_complete_prefix() {
+    char prefix_text[100];
+    int limit;
+
+    printf("Entre com o começo da palavra (ex.: jed): ");
+    if (scanf("%99s", prefix_text) != 1) {
+        printf("Erro ao ler o prefixo.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    printf("Quantas sugestões (até %d): ", MAX_COMPLETIONS);
+    if (scanf("%d", &limit) != 1 || limit < 1 || limit > MAX_COMPLETIONS) {
+        printf("Número de sugestões inválido.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    char *prefix = normalize_prefix(prefix_text);
+    if (!prefix) {
+        printf("Prefixo inválido (ele deve possuir ao menos uma letra).\n");
+        return;
+    }
+
+    TopKEntry completions[MAX_COMPLETIONS];
+    TopKEntry baseline[MAX_COMPLETIONS];
+    const QueryIndex index = current_query_index();
+    int total = 0, baseline_total = 0;
+    int found = 0;
+    double elapsed_time = 0.0;
+    if (!engine->snapshot_open) {
+        uint64_t start_time = timer_start();
+        found = complete_prefix(&index, QUERY_RADIX, prefix, limit, completions, &total);
+        elapsed_time = timer_stop(start_time);
+    }
+    // O snapshot não tem árvore radix: só a varredura do intervalo de palavras com o prefixo
+    uint64_t start_time = timer_start();
+    const int baseline_found = complete_prefix(&index, engine->snapshot_open ? QUERY_SNAPSHOT : QUERY_VECTOR, prefix,
+                                               limit, baseline, &baseline_total);
+    const double baseline_time = timer_stop(start_time);
+    if (engine->snapshot_open) {
+        found = baseline_found;
+        total = baseline_total;
+        memcpy(completions, baseline, (found > 0 ? found : 0) * sizeof(TopKEntry));
+    }
+
+    printf("\n--- Palavras começando com '%s' (%d no total) ---\n", prefix, total);
+    for (int i = 0; i < found; i++) {
+        printf("%4d. %-24s %d\n", i + 1, completions[i].word, completions[i].frequency);
+    }
+    if (found <= 0) {
+        printf("Nenhuma palavra com esse prefixo.\n");
+    }
+    printf("----------------------------------------\n");
+    if (!engine->snapshot_open) {
+        printf("Árvore radix (máximo por subárvore): %.6f ms\n", elapsed_time);
+    }
+    printf("Varredura do intervalo no %s   : %.6f ms\n", engine->snapshot_open ? "snapshot" : "vetor", baseline_time);
+    free(prefix);
+}
+
+void handle_fuzzy_search() {
+    char word_text[100];
+    int max_distance;
+
+    printf("Entre com a palavra (ex.: jeddi): ");
+    if (scanf("%99s", word_text) != 1) {
+        printf("Erro ao ler a palavra.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    printf("Distância máxima de edição (1 ou 2): ");
+    if (scanf("%d", &max_distance) != 1 || max_distance < 1 || max_distance > 2) {
+        printf("Distância inválida.\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    // Um erro de digitação pode deixar a palavra curta demais para a busca exata
+    char *word = normalize_prefix(word_text);
+    if (!word) {
+        printf("Palavra inválida (ela deve possuir ao menos uma letra).\n");
+        return;
+    }
+
+    FuzzyEntry matches[FUZZY_SUGGESTIONS];
+    FuzzyEntry baseline[FUZZY_SUGGESTIONS];
+    const QueryIndex index = current_query_index();
+    int total = 0, baseline_total = 0;
+    int found = 0;
+    long examined = 0, baseline_examined = 0;
+    double elapsed_time = 0.0;
+    if (!engine->snapshot_open) {
+        uint64_t start_time = timer_start();
+        found = fuzzy_lookup(&index, QUERY_RADIX, word, max_distance, FUZZY_SUGGESTIONS, matches, &total, &examined);
+        elapsed_time = timer_stop(start_time);
+    }
+    // O snapshot não tem árvore radix: só a comparação com cada palavra
+    uint64_t start_time = timer_start();
+    const int baseline_found = fuzzy_lookup(&index, engine->snapshot_open ? QUERY_SNAPSHOT : QUERY_VECTOR, word,
+                                            max_distance, FUZZY_SUGGESTIONS, baseline, &baseline_total,
+                                            &baseline_examined);
+    const double baseline_time = timer_stop(start_time);
+    if (engine->snapshot_open) {
+        found = baseline_found;
+        total = baseline_total;
+        memcpy(matches, baseline, (found > 0 ? found : 0) * sizeof(FuzzyEntry));
+    }
+
+    printf("\n--- Palavras a até %d edição(ões) de '%s' (%d no total) ---\n", max_distance, word, total);
+    for (int i = 0; i < found; i++) {
+        printf("%4d. %-24s distância %d  frequência %d\n", i + 1, matches[i].word, matches[i].distance,
+               matches[i].frequency);
+    }
+    if (found <= 0) {
+        printf("Nenhuma palavra próxima.\n");
+    }
+    printf("----------------------------------------\n");
+    if (!engine->snapshot_open) {
+        printf("Árvore radix (poda por distância)   : %.6f ms, %ld nós examinados\n", elapsed_time, examined);
+    }
+    printf("Comparação com cada palavra do %s : %.6f ms, %ld palavras examinadas\n",
+           engine->snapshot_open ? "snapshot" : "vetor", baseline_time, baseline_examined);
+    free(word);
+}
+
+// Lê a linha inteira, sem o '\n', para que uma consulta longa não seja respondida cortada.
+// Retorna NULL no fim da entrada ou sem memória; o chamador libera a linha.
+char* read_query_line() {
+    char *line = NULL;
+    size_t capacity = 0;
+    const ssize_t length = getline(&line, &capacity, stdin);
+    if (length < 0) {
+        free(line);
+        return NULL;
+    }
+    if (length > 0 && line[length - 1] == '\n') line[length - 1] = '\0';
+    return line;
+}
+
+void handle_boolean_search() {
+    char error[320];
+
+    printf("Entre com a consulta (ex.: love AND (time OR NOT war)): ");
+    char *text = read_query_line();
+    if (!text) {
+        printf("Erro ao ler a consulta.\n");
+        return;
+    }
+
+    uint64_t start_time = timer_start();
+    BooleanNode *query = parse_boolean_query(text, error, sizeof(error));
+    const double parse_time = timer_stop(start_time);
+    if (!query) {
+        printf("Consulta inválida: %s\n", error);
+        free(text);
+        return;
+    }
+
+    // Um snapshot não tem as listas decodificadas: as citações das palavras são decodificadas na consulta
+    const QueryIndex index = current_query_index();
+    int *ids = NULL;
+    start_time = timer_start();
+    const int total = evaluate_boolean_query(&index, query, &ids);
+    const double elapsed_time = timer_stop(start_time);
+    free_boolean_query(query);
+    if (total < 0) {
+        printf("Falha ao avaliar a consulta (falta de memória).\n");
+        free(text);
+        return;
+    }
+
+    printf("\n--- Frases que atendem a '%s' ---\n", text);
+    printf("%d frase%s encontrada%s (análise em %.6f ms, avaliação em %.6f ms).\n", total, total == 1 ? "" : "s",
+           total == 1 ? "" : "s", parse_time, elapsed_time);
+    free(text);
+    display_quote_ids(ids, total);
+    free(ids);
+}
+
+void handle_phrase_search() {
+    char error[128];
+
+    if (!current_query_index().positions) {
+        printf("Erro: o índice não tem as posições das palavras. Inicie o programa com --positions e carregue um "
+               "arquivo de citações (Opção 1).\n");
+        return;
+    }
+
+    printf("Entre com a frase (ex.: children of the night): ");
+    char *text = read_query_line();
+    if (!text) {
+        printf("Erro ao ler a frase.\n");
+        return;
+    }
+
+    PhraseQuery *phrase = parse_phrase_query(text, error, sizeof(error));
+    if (!phrase) {
+        printf("Frase inválida: %s\n", error);
+        free(text);
+        return;
+    }
+
+    const QueryIndex index = current_query_index();
+    int *ids = NULL;
+    const uint64_t start_time = timer_start();
+    const int total = evaluate_phrase_query(&index, phrase, &ids);
+    const double elapsed_time = timer_stop(start_time);
+    free_phrase_query(phrase);
+    if (total < 0) {
+        printf("Falha ao avaliar a frase (falta de memória).\n");
+        free(text);
+        return;
+    }
+
+    printf("\n--- Frases que contêm \"%s\" ---\n", text);
+    printf("%d frase%s encontrada%s (avaliação em %.6f ms).\n", total, total == 1 ? "" : "s", total == 1 ? "" : "s",
+           elapsed_time);
+    free(text);
+    printf("Palavras de até 3 letras não são indexadas: no meio da frase cada uma vale por uma palavra qualquer, "
+           "nas pontas são ignoradas.\n");
+    display_quote_ids(ids, total);
+    free(ids);
+}
+
+void handle_ranked_search() {
+    char error[128];
+    int k;
+
+    printf("Entre com as palavras (ex.: love and war): ");
+    char *text = read_query_line();
+    if (!text) {
+        printf("Erro ao ler a consulta.\n");
+        return;
+    }
+
+    printf("Quantas frases (até %d): ", MAX_RANKED);
+    if (scanf("%d", &k) != 1 || k < 1 || k > MAX_RANKED) {
+        printf("Número de frases inválido.\n");
+        clear_input_buffer();
+        free(text);
+        return;
+    }
+    clear_input_buffer();
+
+    RankedQuery *query = parse_ranked_query(text, error, sizeof(error));
+    if (!query) {
+        printf("Consulta inválida: %s\n", error);
+        free(text);
+        return;
+    }
+
+    // Ranqueada com os limites MaxScore, ranqueada pontuando todas as citações e, como
+    // referência, a busca sem ranking: as frases com qualquer uma das palavras (OR)
+    const QueryIndex index = current_query_index();
+    RankedQuote ranked[MAX_RANKED];
+    RankedQuote exhaustive[MAX_RANKED];
+    long scored = 0, exhaustive_scored = 0;
+    uint64_t start_time = timer_start();
+    const int found = rank_quotes(&index, query, k, 1, ranked, &scored);
+    const double ranked_time = timer_stop(start_time);
+    start_time = timer_start();
+    rank_quotes(&index, query, k, 0, exhaustive, &exhaustive_scored);
+    const double exhaustive_time = timer_stop(start_time);
+
+    size_t joined_length = 1;
+    for (int w = 0; w < query->word_count; w++) joined_length += strlen(query->words[w]) + 4;
+    char *joined = (char *)malloc(joined_length);
+    int unranked = -1;
+    double unranked_time = 0.0;
+    if (joined) {
+        char *next = joined;
+        for (int w = 0; w < query->word_count; w++) {
+            next += sprintf(next, w ? " OR %s" : "%s", query->words[w]);
+        }
+        BooleanNode *any = parse_boolean_query(joined, error, sizeof(error));
+        if (any) {
+            int *ids = NULL;
+            start_time = timer_start();
+            unranked = evaluate_boolean_query(&index, any, &ids);
+            unranked_time = timer_stop(start_time);
+            free(ids);
+            free_boolean_query(any);
+        }
+        free(joined);
+    }
+    free_ranked_query(query);
+    if (found < 0) {
+        printf("Falha ao avaliar a consulta (falta de memória).\n");
+        free(text);
+        return;
+    }
+
+    printf("\n--- As %d frases mais relevantes para \"%s\" (BM25) ---\n", found, text);
+    free(text);
+    for (int i = 0; i < found; i++) {
+        const QuoteEntry *quote = &engine->pool.quotes[ranked[i].quote_id];
+        printf("%4d. [%.3f] \"%.*s%s\"\n", i + 1, ranked[i].score, quote->length < 70 ? quote->length : 70,
+               quote->text, quote->length > 70 ? "..." : "");
+        printf("      Filme: %s (%d)\n", engine->pool.movies[quote->movie_id], quote->year);
+    }
+    if (found == 0) {
+        printf("Nenhuma frase contém essas palavras.\n");
+    }
     printf("----------------------------------------\n");
-    printf("Busca por intervalo de frequência concluída em %.6f ms.\n", elapsed_time);
+    printf("Ranqueada (limites MaxScore)   : %.6f ms, %ld citações pontuadas\n", ranked_time, scored);
+    printf("Ranqueada (todas as citações)  : %.6f ms, %ld citações pontuadas\n", exhaustive_time, exhaustive_scored);
+    if (unranked >= 0) {
+        printf("Sem ranking (OR das palavras)  : %.6f ms, %d frases\n", unranked_time, unranked);
+    }
+}
+
+// Bytes vivos, blocos e bytes por palavra de cada estrutura, para dimensionar as máquinas pelo índice
+void handle_memory_stats() {
+    print_engine_memory_report(engine);
+    print_index_arena_report(&engine->arena);
 }
 
-void display_citations(CitationInfo *citations) {
-    CitationInfo *current = citations;
+// Mostra as citações de uma lista de IDs, QUOTE_PAGE_SIZE por página
+void display_quote_ids(const int *ids, int total) {
+    for (int offset = 0; offset < total; offset += QUOTE_PAGE_SIZE) {
+        const int end = offset + QUOTE_PAGE_SIZE < total ? offset + QUOTE_PAGE_SIZE : total;
+        for (int i = offset; i < end; i++) {
+            const QuoteEntry *quote = &engine->pool.quotes[ids[i]];
+            printf("    - Citação: \"%.*s...\"\n", quote->length < 50 ? quote->length : 50, quote->text);
+            printf("      Filme: %s (%d)\n", engine->pool.movies[quote->movie_id], quote->year);
+        }
+        printf("Resultados %d-%d de %d.\n", offset + 1, end, total);
+
+        if (end < total) {
+            printf("Enter para a próxima página, 'q' para voltar: ");
+            int c = getchar();
+            if (c != '\n' && c != EOF) clear_input_buffer();
+            if (c == 'q' || c == 'Q' || c == EOF) break;
+        }
+    }
+    printf("----------------------------------------\n");
+}
+
+void handle_save_snapshot() {
+    char filename[256];
+
+    if (engine->snapshot_open) {
+        printf("Erro: o índice aberto já é um snapshot.\n");
+        return;
+    }
+
+    printf("Entre com o nome do snapshot (ex.: movie_quotes.idx): ");
+    if (scanf("%255s", filename) != 1) {
+        printf("Erro ao ler o nome do arquivo\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+
+    const double start = wall_clock_ms();
+    if (save_index_snapshot(filename, &engine->vector, &engine->pool, engine->load_time_ms)) {
+        printf("Snapshot gravado em '%s' (%.4f ms).\n", filename, wall_clock_ms() - start);
+        if (engine->positions) {
+            printf("As posições das palavras não vão para o snapshot: a busca por frase exige o CSV.\n");
+        }
+    } else {
+        printf("Falha ao gravar o snapshot '%s'.\n", filename);
+    }
+}
+
+// Abre o snapshot no lugar dos dados atuais e compara o tempo com o do carregamento do CSV
+int open_snapshot(const char *filename) {
+    EngineLoadReport report;
+    Engine *fresh = open_engine_snapshot(filename, &report);
+    if (!fresh) {
+        if (!quiet_mode) {
+            printf("Falha ao abrir o snapshot '%s'.%s\n", filename,
+                   engine ? " O índice anterior continua carregado." : "");
+        }
+        return 0;
+    }
+    install_engine(fresh);
+    index_ready_time_ms = report.total_time_ms;
+    if (quiet_mode) return 1;
+
+    const double open_time = report.total_time_ms;
+    const SnapshotHeader *header = engine->snapshot.header;
+    printf("\nSnapshot '%s' aberto em %.4f ms (%u palavras, %u frases, %u filmes).\n", filename, open_time,
+           header->word_count, header->quote_count, header->movie_count);
+    if (header->build_time_ms > 0) {
+        printf("Carregamento do CSV que gerou o snapshot: %.4f ms (%.1fx mais lento).\n", header->build_time_ms,
+               open_time > 0 ? header->build_time_ms / open_time : 0.0);
+    }
+    if (report.year_counts_built) {
+        printf("Contagens por ano (top-K) montadas em %.4f ms.\n", report.year_counts_time_ms);
+    }
+    return 1;
+}
+
+void handle_open_snapshot() {
+    char filename[256];
+
+    printf("Entre com o nome do snapshot (ex.: movie_quotes.idx): ");
+    if (scanf("%255s", filename) != 1) {
+        printf("Erro ao ler o nome do arquivo\n");
+        clear_input_buffer();
+        return;
+    }
+    clear_input_buffer();
+    open_snapshot(filename);
+}
+
+// Troca o índice atual pelo novo (ou por nenhum, com NULL) e libera o anterior assim que
+// nenhum leitor o usa; no menu o único leitor é este thread, então é na hora
+void install_engine(Engine *fresh) {
+    const int replacing = engine != NULL;
+    if (replacing && fresh && !quiet_mode) printf("Substituindo o índice anterior pelo novo\n");
+    publish_engine(&engines, fresh);
+    reclaim_engines(&engines, 1);
+    engine = fresh;
+    if (replacing && fresh && !quiet_mode) printf("Índice anterior liberado\n");
+}
+
+void discard_loaded_data() {
+    if (engine) {
+        printf("Eliminando dados existentes\n");
+        cleanup_memory();
+        printf("Dados existentes foram eliminados\n");
+    }
+}
+
+void display_citations(const PostingList *postings, const QuotePool *pool) {
+    PostingIterator it;
     int count = 0;
     printf("   Citações:\n");
-    while (current != NULL) {
-        printf("    - Citação: \"%.50s...\"\n", current->quote);
-        printf("      Filme: %s (%d)\n", current->movie, current->year);
-        current = current->next;
+    posting_iterator_init(&it, postings);
+    while (posting_iterator_next(&it)) {
+        const QuoteEntry *quote = &pool->quotes[it.quote_id];
+        printf("    - Citação: \"%.*s...\"", quote->length < 50 ? quote->length : 50, quote->text);
+        if (it.term_count > 1) printf(" (%d vezes)", it.term_count);
+        printf("\n      Filme: %s (%d)\n", pool->movies[quote->movie_id], quote->year);
         count++;
     }
     if (count == 0) {
@@ -246,19 +1308,11 @@ void display_citations(CitationInfo *citations) {
 }
 
 void cleanup_memory() {
-    printf("\nLimpando memória alocada...\n");
-
-    // Libera os nós das árvores primeiro (eles apenas apontam para dados)
-    free_bst(bst_root);
-    bst_root = NULL; // Evita liberação dupla se chamada novamente
-    free_avl(avl_root);
-    avl_root = NULL;
-    free_freq_avl(freq_avl_root);
-    freq_avl_root = NULL;
+    if (!quiet_mode) printf("\nLimpando memória alocada...\n");
 
-    // Libera o vetor e os WordInfo que ele possui
-    free_vector(&word_vector);
+    // Os nós das árvores, os WordInfo, as citações e as strings vivem na arena do índice,
+    // liberada com poucas chamadas a free()
+    install_engine(NULL); // Evita acesso a memória liberada se chamada novamente
 
-    data_loaded = 0;
-    printf("Memória limpa.\n");
+    if (!quiet_mode) printf("Memória limpa.\n");
 }
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mapped_file.h"
+
+#define READ_CHUNK_SIZE (1024 * 1024)
+
+// Fallback for inputs mmap cannot handle: reads the descriptor to the end
+static int read_whole_file(int fd, MappedFile *file) {
+    size_t capacity = READ_CHUNK_SIZE;
+    size_t size = 0;
+    char *data = (char *)malloc(capacity);
+    if (!data) {
+        perror("Failed to allocate file buffer");
+        return 0;
+    }
+
+    for (;;) {
+        if (size == capacity) {
+            char *new_data = (char *)realloc(data, capacity * 2);
+            if (!new_data) {
+                perror("Failed to grow file buffer");
+                free(data);
+                return 0;
+            }
+            data = new_data;
+            capacity *= 2;
+        }
+        ssize_t n = read(fd, data + size, capacity - size);
+        if (n < 0) {
+            perror("Failed to read file");
+            free(data);
+            return 0;
+        }
+        if (n == 0) break;
+        size += (size_t)n;
+    }
+
+    file->data = data;
+    file->size = size;
+    file->is_mapped = 0;
+    return 1;
+}
+
+int map_file(const char *filename, MappedFile *file) {
+    file->data = NULL;
+    file->size = 0;
+    file->is_mapped = 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Falha ao abrir arquivo.");
+        return 0;
+    }
+
+    struct stat st;
+    int ok;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            // The file is read front to back exactly once
+            madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+            file->data = (char *)data;
+            file->size = (size_t)st.st_size;
+            file->is_mapped = 1;
+            ok = 1;
+        } else {
+            ok = read_whole_file(fd, file);
+        }
+    } else {
+        ok = read_whole_file(fd, file);
+    }
+
+    close(fd);
+    return ok;
+}
+
+void unmap_file(MappedFile *file) {
+    if (!file || !file->data) return;
+    if (file->is_mapped) {
+        munmap(file->data, file->size);
+    } else {
+        free(file->data);
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->is_mapped = 0;
+}
@@ -0,0 +1,13 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "structures.h"
+
+// Maps the whole file read-only. Files that cannot be mapped (pipes, empty files)
+// are read into a heap buffer instead. Returns 1 on success, 0 on failure.
+int map_file(const char *filename, MappedFile *file);
+
+// Unmaps or frees the file contents and resets the struct.
+void unmap_file(MappedFile *file);
+
+#endif // MAPPED_FILE_H
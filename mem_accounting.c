@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include "mem_accounting.h"
+#include "arena.h" // For slab_name
+
+// Sits right before every block handed out
+typedef struct MemHeader {
+    size_t size;      // Requested bytes
+    uint32_t tag;
+    uint32_t offset;  // From the start of the malloc'd block to the caller's pointer
+} MemHeader;
+
+// Rounded up so the caller's pointer keeps the alignment malloc guarantees
+#define MEM_HEADER_SIZE ((sizeof(MemHeader) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+typedef struct MemCounters {
+    atomic_size_t live_bytes;
+    atomic_size_t live_allocations;
+    atomic_size_t allocations;
+    atomic_size_t peak_bytes;
+} MemCounters;
+
+// The counters order no other memory, so every update is relaxed
+static MemCounters mem_counters[MEM_TAG_COUNT];
+static MemCounters mem_total;
+
+static void charge_counters(MemCounters *counters, size_t bytes, size_t blocks, int served) {
+    // Frees pass the negated amounts, which wrap back around in the unsigned sums
+    const size_t live = atomic_fetch_add_explicit(&counters->live_bytes, bytes, memory_order_relaxed) + bytes;
+    atomic_fetch_add_explicit(&counters->live_allocations, blocks, memory_order_relaxed);
+    if (served) atomic_fetch_add_explicit(&counters->allocations, 1, memory_order_relaxed);
+
+    size_t peak = atomic_load_explicit(&counters->peak_bytes, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&counters->peak_bytes, &peak, live,
+                                                                 memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static void charge(MemTag tag, size_t bytes, size_t blocks, int served) {
+    charge_counters(&mem_counters[tag], bytes, blocks, served);
+    charge_counters(&mem_total, bytes, blocks, served);
+}
+
+// Writes the header of a fresh block and counts it
+static void* track(unsigned char *block, size_t offset, size_t size, MemTag tag) {
+    if (!block) return NULL;
+    MemHeader *header = (MemHeader *)(block + offset) - 1;
+    header->size = size;
+    header->tag = (uint32_t)tag;
+    header->offset = (uint32_t)offset;
+    charge(tag, size, 1, 1);
+    return block + offset;
+}
+
+static int too_large(size_t count, size_t size, size_t extra) {
+    if (size != 0 && count > (SIZE_MAX - extra) / size) {
+        errno = ENOMEM;
+        return 1;
+    }
+    return 0;
+}
+
+void* mem_alloc(MemTag tag, size_t size) {
+    if (too_large(1, size, MEM_HEADER_SIZE)) return NULL;
+    return track((unsigned char *)malloc(MEM_HEADER_SIZE + size), MEM_HEADER_SIZE, size, tag);
+}
+
+void* mem_calloc(MemTag tag, size_t count, size_t size) {
+    if (too_large(count, size, MEM_HEADER_SIZE)) return NULL;
+    return track((unsigned char *)calloc(1, MEM_HEADER_SIZE + count * size), MEM_HEADER_SIZE, count * size, tag);
+}
+
+// The header takes a whole alignment unit (or more) in front of the block
+void* mem_aligned_alloc(MemTag tag, size_t alignment, size_t size) {
+    const size_t offset = (MEM_HEADER_SIZE + alignment - 1) & ~(alignment - 1);
+    if (too_large(1, size, offset + alignment)) return NULL;
+    const size_t total = (offset + size + alignment - 1) & ~(alignment - 1); // aligned_alloc wants a multiple
+    return track((unsigned char *)aligned_alloc(alignment, total), offset, size, tag);
+}
+
+void* mem_realloc(MemTag tag, void *ptr, size_t size) {
+    if (!ptr) return mem_alloc(tag, size);
+    if (too_large(1, size, MEM_HEADER_SIZE)) return NULL;
+
+    const MemHeader *header = (const MemHeader *)ptr - 1;
+    const size_t old_size = header->size;
+    const MemTag old_tag = (MemTag)header->tag;
+    unsigned char *block = (unsigned char *)realloc((unsigned char *)ptr - MEM_HEADER_SIZE, MEM_HEADER_SIZE + size);
+    if (!block) return NULL;
+
+    ((MemHeader *)(block + MEM_HEADER_SIZE) - 1)->size = size;
+    charge(old_tag, size - old_size, 0, 1);
+    return block + MEM_HEADER_SIZE;
+}
+
+void mem_free(void *ptr) {
+    if (!ptr) return;
+    const MemHeader *header = (const MemHeader *)ptr - 1;
+    charge((MemTag)header->tag, -header->size, (size_t)-1, 0);
+    free((unsigned char *)ptr - header->offset);
+}
+
+static void read_counters(MemCounters *counters, MemStats *stats) {
+    stats->live_bytes = atomic_load_explicit(&counters->live_bytes, memory_order_relaxed);
+    stats->live_allocations = atomic_load_explicit(&counters->live_allocations, memory_order_relaxed);
+    stats->allocations = atomic_load_explicit(&counters->allocations, memory_order_relaxed);
+    stats->peak_bytes = atomic_load_explicit(&counters->peak_bytes, memory_order_relaxed);
+}
+
+void mem_tag_stats(MemTag tag, MemStats *stats) {
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    read_counters(&mem_counters[tag], stats);
+}
+
+void mem_total_stats(MemStats *stats) {
+    read_counters(&mem_total, stats);
+}
+
+const char* mem_tag_name(MemTag tag) {
+    static const char *names[MEM_TAG_COUNT] = {
+        [MEM_LOAD_SCRATCH] = "Buffers da carga",
+        [MEM_VECTOR] = "Vetor",
+        [MEM_HASH] = "Tabela hash",
+        [MEM_EYTZINGER] = "Eytzinger",
+        [MEM_FREQ_ORDER] = "Ordem por freq.",
+        [MEM_QUOTE_IDS] = "IDs das frases",
+        [MEM_YEAR_COUNTS] = "Contagem por ano",
+        [MEM_QUOTE_POOL] = "Pool de frases",
+    };
+    if (tag >= MEM_SLAB_WORDS && tag <= MEM_SLAB_POSITIONS) return slab_name((SlabKind)(tag - MEM_SLAB_WORDS));
+    return (tag >= 0 && tag < MEM_TAG_COUNT && names[tag]) ? names[tag] : "?";
+}
@@ -0,0 +1,54 @@
+#ifndef MEM_ACCOUNTING_H
+#define MEM_ACCOUNTING_H
+
+#include <stddef.h>
+
+// What a counted allocation is charged to
+typedef enum MemTag {
+  MEM_LOAD_SCRATCH,     // Loader buffers and arenas outside the index; gone once it is built
+  MEM_SLAB_WORDS,       // Arena chunks of each slab, in SlabKind order
+  MEM_SLAB_POSTINGS,
+  MEM_SLAB_STRINGS,
+  MEM_SLAB_BST,
+  MEM_SLAB_AVL,
+  MEM_SLAB_FREQ_AVL,
+  MEM_SLAB_RADIX,
+  MEM_SLAB_POSITIONS,
+  MEM_VECTOR,           // Pointer array of the WordVector
+  MEM_HASH,             // Slots of the hash index
+  MEM_EYTZINGER,        // Prefix and pointer arrays of the Eytzinger layout
+  MEM_FREQ_ORDER,       // Words in frequency order
+  MEM_QUOTE_IDS,        // Decoded quote ID lists
+  MEM_YEAR_COUNTS,      // Occurrences per year for the top-K year filter
+  MEM_QUOTE_POOL,       // Quote, movie and movie lookup arrays of the pool
+  MEM_TAG_COUNT
+} MemTag;
+
+// Counters of one tag, or of all of them, for the whole process
+typedef struct MemStats {
+  size_t live_bytes;        // Requested bytes not yet freed
+  size_t live_allocations;  // Blocks not yet freed
+  size_t allocations;       // Allocations and reallocations served so far
+  size_t peak_bytes;        // Highest live_bytes seen
+} MemStats;
+
+// malloc, calloc, aligned_alloc and realloc that charge the block to 'tag'. Each block carries
+// a small header with its size and tag, so it must be freed with mem_free and never with free.
+// mem_realloc keeps the tag of the block ('tag' is used when ptr is NULL); blocks from
+// mem_aligned_alloc cannot be reallocated.
+void* mem_alloc(MemTag tag, size_t size);
+void* mem_calloc(MemTag tag, size_t count, size_t size);
+void* mem_aligned_alloc(MemTag tag, size_t alignment, size_t size);
+void* mem_realloc(MemTag tag, void *ptr, size_t size);
+
+// Frees a block from the functions above and discounts it from its tag. NULL is ignored.
+void mem_free(void *ptr);
+
+// Reads the counters of a tag, or the sum over every tag. Safe while other threads allocate.
+void mem_tag_stats(MemTag tag, MemStats *stats);
+void mem_total_stats(MemStats *stats);
+
+// Returns the display name of a tag.
+const char* mem_tag_name(MemTag tag);
+
+#endif // MEM_ACCOUNTING_H
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} perf_event_configs[PERF_EVENT_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+#endif
+
+static int perf_warned = 0;
+
+static void warn_unavailable(int error) {
+    if (perf_warned) return;
+    perf_warned = 1;
+    const char *hint = "";
+    if (error == EACCES || error == EPERM) hint = " Veja /proc/sys/kernel/perf_event_paranoid.";
+    else if (error == ENOENT || error == ENODEV || error == EOPNOTSUPP) {
+        hint = " O processador, a máquina virtual ou o contêiner não os expõe.";
+    }
+    fprintf(stderr, "Aviso: contadores de hardware indisponíveis (%s); as medições seguem só com os tempos.%s\n",
+            strerror(error), hint);
+}
+
+#ifdef __linux__
+// Opens one event; 'leader' is the group to join, -1 to start one (grouped) or to stand alone
+static int open_perf_event(PerfEvent event, int inherit, int grouped, int leader) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perf_event_configs[event].type;
+    attr.config = perf_event_configs[event].config;
+    attr.inherit = inherit ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    if (grouped) attr.read_format |= PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, grouped ? leader : -1, 0);
+}
+#endif
+
+int open_perf_counters(PerfCounters *counters, int inherit) {
+    memset(counters, 0, sizeof(*counters));
+    counters->leader = -1;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) counters->fds[e] = -1;
+
+#ifdef __linux__
+    int opened = 0, first_error = 0;
+    counters->grouped = 1;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        int fd = open_perf_event((PerfEvent)e, inherit, counters->grouped, counters->leader);
+        if (fd < 0 && errno == EINVAL && counters->grouped && counters->leader < 0) {
+            // Older kernels do not read inherited counters as a group
+            counters->grouped = 0;
+            fd = open_perf_event((PerfEvent)e, inherit, 0, -1);
+        }
+        if (fd < 0) {
+            if (!first_error) first_error = errno;
+            continue;
+        }
+        if (counters->leader < 0) counters->leader = fd;
+        counters->fds[e] = fd;
+        opened++;
+    }
+    if (opened == 0) warn_unavailable(first_error ? first_error : ENOENT);
+    return opened;
+#else
+    (void)inherit;
+    warn_unavailable(ENOSYS);
+    return 0;
+#endif
+}
+
+void close_perf_counters(PerfCounters *counters) {
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters->fds[e] >= 0) close(counters->fds[e]);
+        counters->fds[e] = -1;
+    }
+    counters->leader = -1;
+}
+
+// Value, time enabled and time running of every open event; 0 for the others
+static void read_perf_values(const PerfCounters *counters, uint64_t values[PERF_EVENT_COUNT][3]) {
+    memset(values, 0, PERF_EVENT_COUNT * sizeof(values[0]));
+    if (counters->grouped) {
+        // Number of events, times of the group, then the values in the order they were opened
+        uint64_t group[3 + PERF_EVENT_COUNT];
+        if (read(counters->leader, group, sizeof(group)) < (ssize_t)(3 * sizeof(uint64_t))) return;
+        uint64_t slot = 0;
+        for (int e = 0; e < PERF_EVENT_COUNT && slot < group[0]; e++) {
+            if (counters->fds[e] < 0) continue;
+            values[e][0] = group[3 + slot++];
+            values[e][1] = group[1];
+            values[e][2] = group[2];
+        }
+        return;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters->fds[e] >= 0 && read(counters->fds[e], values[e], sizeof(values[e])) != sizeof(values[e])) {
+            memset(values[e], 0, sizeof(values[e]));
+        }
+    }
+}
+
+void perf_start(PerfCounters *counters) {
+    if (counters->leader < 0) return;
+    read_perf_values(counters, counters->start);
+}
+
+void perf_stop(PerfCounters *counters, PerfSample *sample) {
+    if (counters->leader < 0) return;
+    uint64_t end[PERF_EVENT_COUNT][3];
+    read_perf_values(counters, end);
+
+    int valid = 0;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        const uint64_t running = end[e][2] - counters->start[e][2];
+        if (counters->fds[e] < 0 || running == 0) continue;
+        const uint64_t enabled = end[e][1] - counters->start[e][1];
+        sample->counts[e] += (double)(end[e][0] - counters->start[e][0]) * ((double)enabled / running);
+        valid |= 1 << e;
+    }
+    sample->valid = sample->runs == 0 ? valid : sample->valid & valid;
+    sample->runs++;
+}
+
+void print_perf_header(FILE *out, const char *label) {
+    fprintf(out, "%-24s %14s %14s %6s %12s %12s %12s\n", label, "Ciclos", "Instruções", "IPC", "Falhas L1d",
+            "Falhas LLC", "Desvios err.");
+}
+
+// One column of a row, or "n/d" if the event was not counted
+static void format_perf_count(char *buffer, size_t size, const PerfSample *sample, PerfEvent event, double per) {
+    if (!(sample->valid & (1 << event)) || sample->runs == 0) {
+        snprintf(buffer, size, "n/d");
+    } else {
+        snprintf(buffer, size, per > 1.0 ? "%.1f" : "%.0f", sample->counts[event] / per);
+    }
+}
+
+void print_perf_row(FILE *out, const char *label, const PerfSample *sample, double per) {
+    char columns[PERF_EVENT_COUNT][32];
+    char ipc[16] = "n/d";
+    if (per <= 0) per = 1.0;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        format_perf_count(columns[e], sizeof(columns[e]), sample, (PerfEvent)e, per);
+    }
+    const int both = (1 << PERF_CYCLES) | (1 << PERF_INSTRUCTIONS);
+    if (sample->runs > 0 && (sample->valid & both) == both && sample->counts[PERF_CYCLES] > 0) {
+        snprintf(ipc, sizeof(ipc), "%.2f", sample->counts[PERF_INSTRUCTIONS] / sample->counts[PERF_CYCLES]);
+    }
+    fprintf(out, "%-24s %14s %14s %6s %12s %12s %12s\n", label, columns[PERF_CYCLES], columns[PERF_INSTRUCTIONS], ipc,
+            columns[PERF_L1D_MISSES], columns[PERF_LLC_MISSES], columns[PERF_BRANCH_MISSES]);
+}
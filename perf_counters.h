@@ -0,0 +1,56 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Hardware events counted around a search or a load phase
+typedef enum PerfEvent {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_L1D_MISSES,      // L1 data cache read misses
+  PERF_LLC_MISSES,      // Last level cache misses
+  PERF_BRANCH_MISSES,
+  PERF_EVENT_COUNT
+} PerfEvent;
+
+// Counts added up over one or more measured intervals
+typedef struct PerfSample {
+  double counts[PERF_EVENT_COUNT]; // Scaled up when the kernel had to multiplex the counters
+  int valid;                       // Bit e set if event e was counted in every interval
+  long runs;                       // Intervals added
+} PerfSample;
+
+// Counters of the calling thread, opened as one group so they run over the same instructions.
+// They count from open to close; perf_start and perf_stop read the whole group at once, so
+// only the code in between (and part of the two read calls) is counted.
+typedef struct PerfCounters {
+  int fds[PERF_EVENT_COUNT];       // -1 for the events the processor, the kernel or the container does not offer
+  int leader;                      // First opened descriptor, -1 if none
+  int grouped;                     // 0 if the kernel refused a group and each event is read on its own
+  uint64_t start[PERF_EVENT_COUNT][3]; // Value, time enabled and time running at perf_start
+} PerfCounters;
+
+// Opens the counters for the calling thread, user space only. With 'inherit', threads it
+// creates afterwards are counted too once they exit (e.g. the load threads). Returns the number
+// of events opened; when none can be, warns once per process why and returns 0, and every
+// other function then does nothing.
+int open_perf_counters(PerfCounters *counters, int inherit);
+
+// Frees the descriptors.
+void close_perf_counters(PerfCounters *counters);
+
+// Starts an interval.
+void perf_start(PerfCounters *counters);
+
+// Ends the interval and adds its counts to 'sample'.
+void perf_stop(PerfCounters *counters, PerfSample *sample);
+
+// Prints the header of a counter table whose first column is titled 'label'.
+void print_perf_header(FILE *out, const char *label);
+
+// Prints one row: the counts divided by 'per' (e.g. the queries of the sample, 1 for totals)
+// and the instructions per cycle; "n/d" where an event was not counted.
+void print_perf_row(FILE *out, const char *label, const PerfSample *sample, double per);
+
+#endif // PERF_COUNTERS_H
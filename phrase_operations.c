@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phrase_operations.h"
+#include "boolean_operations.h"
+#include "array_operations.h"
+#include "posting_operations.h"
+#include "tokenizer.h"
+
+// --- Parsing ---
+
+PhraseQuery* parse_phrase_query(const char *text, char *error, int error_size) {
+    const int length = (int)strlen(text);
+    char *scratch = (char *)malloc(length + TOKENIZER_SCRATCH_SLACK);
+    Token *tokens = (Token *)malloc((length / 4 + 1) * sizeof(Token));
+    PhraseQuery *phrase = (PhraseQuery *)calloc(1, sizeof(PhraseQuery));
+    if (!scratch || !tokens || !phrase) {
+        snprintf(error, error_size, "falta de memória");
+        free(scratch);
+        free(tokens);
+        free(phrase);
+        return NULL;
+    }
+
+    const int count = tokenize_fold(text, length, scratch, tokens);
+    if (count == 0) {
+        snprintf(error, error_size, "a frase não tem palavras com mais de 3 letras, as únicas indexadas");
+        free(scratch);
+        free(tokens);
+        free(phrase);
+        return NULL;
+    }
+
+    phrase->terms = (PhraseTerm *)calloc(count, sizeof(PhraseTerm));
+    int ok = phrase->terms != NULL;
+    for (int t = 0; t < count && ok; t++) {
+        PhraseTerm *term = &phrase->terms[phrase->term_count];
+        term->word = (char *)malloc(tokens[t].length + 1);
+        if (!term->word) {
+            ok = 0;
+            break;
+        }
+        memcpy(term->word, tokens[t].text, tokens[t].length);
+        term->word[tokens[t].length] = '\0';
+        term->offset = tokens[t].position - tokens[0].position;
+        phrase->term_count++;
+    }
+    free(scratch);
+    free(tokens);
+    if (!ok) {
+        snprintf(error, error_size, "falta de memória");
+        free_phrase_query(phrase);
+        return NULL;
+    }
+    return phrase;
+}
+
+void free_phrase_query(PhraseQuery *phrase) {
+    if (!phrase) return;
+    for (int t = 0; t < phrase->term_count; t++) {
+        free(phrase->terms[t].word);
+    }
+    free(phrase->terms);
+    free(phrase);
+}
+
+// --- Evaluation ---
+
+// Quotes holding every word of the phrase. The words are already normalized, so they parse
+// back as themselves, and none is an operator (those have at most 3 letters).
+static int phrase_candidates(const QueryIndex *index, const PhraseQuery *phrase, int **ids) {
+    size_t length = 1;
+    for (int t = 0; t < phrase->term_count; t++) length += strlen(phrase->terms[t].word) + 1;
+    char *text = (char *)malloc(length);
+    if (!text) {
+        perror("Failed to evaluate phrase query");
+        return -1;
+    }
+    char *next = text;
+    for (int t = 0; t < phrase->term_count; t++) {
+        next += sprintf(next, t ? " %s" : "%s", phrase->terms[t].word);
+    }
+
+    char error[64];
+    BooleanNode *query = parse_boolean_query(text, error, sizeof(error));
+    free(text);
+    if (!query) return -1;
+    const int count = evaluate_boolean_query(index, query, ids);
+    free_boolean_query(query);
+    return count;
+}
+
+// Positions of one word in each candidate quote: those of candidates[c] are
+// positions[offsets[c] .. offsets[c + 1])
+typedef struct TermPositions {
+    int *positions;
+    int *offsets;
+    int capacity;
+    int shared;     // Arrays of an earlier term with the same word
+} TermPositions;
+
+// Walks the postings of the word and its position list together, decoding the positions of
+// the candidate quotes and skipping the others
+static int gather_positions(const WordInfo *info, const int *candidates, int count, TermPositions *out) {
+    out->offsets = (int *)malloc((count + 1) * sizeof(int));
+    out->capacity = 64;
+    out->positions = (int *)malloc(out->capacity * sizeof(int));
+    if (!out->offsets || !out->positions) {
+        perror("Failed to gather phrase positions");
+        return 0;
+    }
+
+    PostingIterator it;
+    posting_iterator_init(&it, &info->postings);
+    const unsigned char *cursor = info->positions.bytes;
+    const unsigned char *end = cursor + info->positions.length;
+    int c = 0, used = 0;
+    while (c < count && posting_iterator_next(&it)) {
+        while (c < count && candidates[c] < it.quote_id) out->offsets[c++] = used;
+        if (c == count || candidates[c] != it.quote_id) {
+            read_positions(&cursor, end, it.term_count, NULL);
+            continue;
+        }
+        if (used + it.term_count > out->capacity) {
+            int capacity = out->capacity * 2;
+            while (capacity < used + it.term_count) capacity *= 2;
+            int *positions = (int *)realloc(out->positions, capacity * sizeof(int));
+            if (!positions) {
+                perror("Failed to gather phrase positions");
+                return 0;
+            }
+            out->positions = positions;
+            out->capacity = capacity;
+        }
+        out->offsets[c++] = used;
+        read_positions(&cursor, end, it.term_count, out->positions + used);
+        used += it.term_count;
+    }
+    while (c <= count) out->offsets[c++] = used;
+    return 1;
+}
+
+static int contains_position(const int *positions, int count, int target) {
+    int low = 0, high = count - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (positions[mid] == target) return 1;
+        if (positions[mid] < target) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return 0;
+}
+
+// Tries each occurrence of the word with the fewest occurrences in the quote as the anchor of
+// the phrase and looks the other words up at their offsets from it
+static int matches_phrase(const PhraseQuery *phrase, const TermPositions *terms, int c) {
+    int anchor = 0;
+    for (int t = 1; t < phrase->term_count; t++) {
+        if (terms[t].offsets[c + 1] - terms[t].offsets[c] < terms[anchor].offsets[c + 1] - terms[anchor].offsets[c]) {
+            anchor = t;
+        }
+    }
+    const TermPositions *anchor_positions = &terms[anchor];
+    for (int p = anchor_positions->offsets[c]; p < anchor_positions->offsets[c + 1]; p++) {
+        const int start = anchor_positions->positions[p] - phrase->terms[anchor].offset;
+        if (start < 0) continue;
+        int t = 0;
+        while (t < phrase->term_count &&
+               (t == anchor || contains_position(terms[t].positions + terms[t].offsets[c],
+                                                 terms[t].offsets[c + 1] - terms[t].offsets[c],
+                                                 start + phrase->terms[t].offset))) {
+            t++;
+        }
+        if (t == phrase->term_count) return 1;
+    }
+    return 0;
+}
+
+int evaluate_phrase_query(const QueryIndex *index, const PhraseQuery *phrase, int **ids) {
+    *ids = NULL;
+    if (!index->positions || !index->vector) return -1;
+    int *candidates = NULL;
+    const int count = phrase_candidates(index, phrase, &candidates);
+    if (count <= 0 || phrase->term_count == 1) {
+        *ids = candidates;
+        return count;
+    }
+
+    TermPositions *terms = (TermPositions *)calloc(phrase->term_count, sizeof(TermPositions));
+    int ok = terms != NULL;
+    if (!ok) perror("Failed to evaluate phrase query");
+    for (int t = 0; t < phrase->term_count && ok; t++) {
+        int same = 0;
+        while (same < t && strcmp(phrase->terms[same].word, phrase->terms[t].word) != 0) same++;
+        if (same < t) {
+            terms[t] = terms[same];
+            terms[t].shared = 1;
+            continue;
+        }
+        const WordInfo *info = search_vector(index->vector, phrase->terms[t].word);
+        ok = info && gather_positions(info, candidates, count, &terms[t]);
+    }
+
+    int found = 0;
+    for (int c = 0; c < count && ok; c++) {
+        if (matches_phrase(phrase, terms, c)) candidates[found++] = candidates[c];
+    }
+
+    for (int t = 0; terms && t < phrase->term_count; t++) {
+        if (terms[t].shared) continue;
+        free(terms[t].positions);
+        free(terms[t].offsets);
+    }
+    free(terms);
+    if (!ok || found == 0) {
+        free(candidates);
+        return ok ? 0 : -1;
+    }
+    *ids = candidates;
+    return found;
+}
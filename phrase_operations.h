@@ -0,0 +1,36 @@
+#ifndef PHRASE_OPERATIONS_H
+#define PHRASE_OPERATIONS_H
+
+#include "structures.h"
+#include "query_operations.h"
+
+// A word of a phrase query
+typedef struct PhraseTerm {
+  char *word;     // Normalized
+  int offset;     // Tokens between the first word of the phrase and this one
+} PhraseTerm;
+
+// Words of a phrase query, in phrase order. Tokens too short to be indexed are not terms,
+// but they count in the offsets, so each one stands for exactly one token of the quote;
+// the ones before the first word or after the last are left out.
+typedef struct PhraseQuery {
+  PhraseTerm *terms;
+  int term_count;
+} PhraseQuery;
+
+// Tokenizes the phrase with the rules of the quotes. Returns the query, or NULL with a
+// message in 'error' if it has no word that the index keeps.
+PhraseQuery* parse_phrase_query(const char *text, char *error, int error_size);
+
+// Frees a parsed phrase.
+void free_phrase_query(PhraseQuery *phrase);
+
+// Evaluates the phrase into a malloc'd array of ascending quote IDs in *ids (NULL when there
+// are none), which the caller frees. The quotes holding every word come from a boolean AND;
+// the position list of each word is then read alongside its postings, decoding only those
+// quotes, and a quote matches if the words sit at the offsets of the phrase. The quote text is
+// never read. The index must have positions (QueryIndex.positions).
+// Returns the number of quotes, or -1 on allocation failure.
+int evaluate_phrase_query(const QueryIndex *index, const PhraseQuery *phrase, int **ids);
+
+#endif // PHRASE_OPERATIONS_H
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <string.h>
+#include "posting_operations.h"
+
+#define MIN_POSTING_CAPACITY 8
+
+int varint_size(unsigned int value) {
+    int size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Writes 'value' as a LEB128 varint and returns the number of bytes written
+static int put_varint(unsigned char *out, unsigned int value) {
+    int size = 0;
+    while (value >= 0x80) {
+        out[size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = (unsigned char)value;
+    return size;
+}
+
+// Reads a varint at *cursor and advances it; stops at 'end' on a truncated list
+static unsigned int get_varint(const unsigned char **cursor, const unsigned char *end) {
+    unsigned int value = 0;
+    int shift = 0;
+    while (*cursor < end) {
+        unsigned char byte = *(*cursor)++;
+        value |= (unsigned int)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+        shift += 7;
+    }
+    return value;
+}
+
+int init_posting_list(PostingList *list, int capacity, Arena *arena) {
+    list->bytes = NULL;
+    list->length = 0;
+    list->capacity = 0;
+    list->quote_count = 0;
+    list->last_quote = -1;
+    list->last_count = 0;
+    list->last_count_offset = 0;
+    if (capacity > 0) {
+        list->bytes = (unsigned char *)arena_alloc_bytes(arena, capacity);
+        if (!list->bytes) {
+            perror("Failed to allocate posting list");
+            return 0;
+        }
+        list->capacity = capacity;
+    }
+    return 1;
+}
+
+// Moves the list to a larger block of the arena; the old block is reclaimed with the arena
+static int grow_posting_list(PostingList *list, int needed, Arena *arena) {
+    if (needed <= list->capacity) return 1;
+    int capacity = list->capacity ? list->capacity * 2 : MIN_POSTING_CAPACITY;
+    if (capacity < needed) capacity = needed;
+    unsigned char *bytes = (unsigned char *)arena_alloc_bytes(arena, capacity);
+    if (!bytes) {
+        perror("Failed to grow posting list");
+        return 0;
+    }
+    if (list->length) memcpy(bytes, list->bytes, list->length);
+    list->bytes = bytes;
+    list->capacity = capacity;
+    return 1;
+}
+
+int add_posting(PostingList *list, int quote_id, Arena *arena) {
+    if (list->quote_count > 0 && quote_id == list->last_quote) {
+        // The count of the last quote is the tail of the list, so it is rewritten in place
+        int needed = list->last_count_offset + varint_size(list->last_count + 1);
+        if (!grow_posting_list(list, needed, arena)) return 0;
+        list->last_count++;
+        list->length = list->last_count_offset + put_varint(list->bytes + list->last_count_offset, list->last_count);
+        return 1;
+    }
+    if (quote_id < list->last_quote) {
+        fprintf(stderr, "Warning: quote %d added after quote %d, skipping.\n", quote_id, list->last_quote);
+        return 0;
+    }
+
+    unsigned int gap = list->quote_count > 0 ? (unsigned int)(quote_id - list->last_quote) : (unsigned int)quote_id;
+    if (!grow_posting_list(list, list->length + varint_size(gap) + 1, arena)) return 0;
+    list->length += put_varint(list->bytes + list->length, gap);
+    list->last_count_offset = list->length;
+    list->length += put_varint(list->bytes + list->length, 1);
+    list->last_count = 1;
+    list->last_quote = quote_id;
+    list->quote_count++;
+    return 1;
+}
+
+int append_posting_list(PostingList *dst, const PostingList *src, Arena *arena) {
+    if (src->quote_count == 0) return 1;
+
+    // The first entry of src holds an absolute quote ID; after dst it becomes a gap
+    const unsigned char *cursor = src->bytes;
+    unsigned int first_quote = get_varint(&cursor, src->bytes + src->length);
+    int first_size = (int)(cursor - src->bytes);
+    if (dst->quote_count > 0 && (int)first_quote <= dst->last_quote) {
+        fprintf(stderr, "Warning: posting lists out of order (%u after %d), skipping.\n", first_quote, dst->last_quote);
+        return 0;
+    }
+    unsigned int gap = dst->quote_count > 0 ? first_quote - (unsigned int)dst->last_quote : first_quote;
+
+    int gap_size = varint_size(gap);
+    int rest = src->length - first_size;
+    if (!grow_posting_list(dst, dst->length + gap_size + rest, arena)) return 0;
+
+    int base = dst->length + gap_size - first_size; // Where src byte offsets land in dst
+    put_varint(dst->bytes + dst->length, gap);
+    memcpy(dst->bytes + dst->length + gap_size, cursor, rest);
+    dst->length += gap_size + rest;
+    dst->quote_count += src->quote_count;
+    dst->last_quote = src->last_quote;
+    dst->last_count = src->last_count;
+    dst->last_count_offset = base + src->last_count_offset;
+    return 1;
+}
+
+void posting_iterator_init(PostingIterator *it, const PostingList *list) {
+    it->cursor = list->bytes;
+    it->end = list->bytes + list->length;
+    it->quote_id = -1;
+    it->term_count = 0;
+}
+
+void posting_iterator_init_tail(PostingIterator *it, const PostingList *list, int count, int previous_quote) {
+    // The last byte of a varint is the only one without the continuation bit, so the bytes
+    // in front of it that have the bit belong to the same varint. Each posting is two varints.
+    const unsigned char *start = list->bytes + list->length;
+    for (int v = 0; v < 2 * count && start > list->bytes; v++) {
+        start--;
+        while (start > list->bytes && (start[-1] & 0x80)) start--;
+    }
+    it->cursor = start;
+    it->end = list->bytes + list->length;
+    it->quote_id = previous_quote;
+    it->term_count = 0;
+}
+
+int posting_iterator_next(PostingIterator *it) {
+    if (it->cursor >= it->end) return 0;
+    unsigned int gap = get_varint(&it->cursor, it->end);
+    it->quote_id = it->quote_id < 0 ? (int)gap : it->quote_id + (int)gap;
+    it->term_count = (int)get_varint(&it->cursor, it->end);
+    return 1;
+}
+
+int posting_list_frequency(const PostingList *list) {
+    PostingIterator it;
+    int frequency = 0;
+    posting_iterator_init(&it, list);
+    while (posting_iterator_next(&it)) {
+        frequency += it.term_count;
+    }
+    return frequency;
+}
+
+int init_position_list(PositionList *list, int capacity, Arena *arena) {
+    list->bytes = NULL;
+    list->length = 0;
+    list->capacity = 0;
+    if (capacity > 0) {
+        list->bytes = (unsigned char *)arena_alloc_bytes(arena, capacity);
+        if (!list->bytes) {
+            perror("Failed to allocate position list");
+            return 0;
+        }
+        list->capacity = capacity;
+    }
+    return 1;
+}
+
+static int grow_position_list(PositionList *list, int needed, Arena *arena) {
+    if (needed <= list->capacity) return 1;
+    int capacity = list->capacity ? list->capacity * 2 : MIN_POSTING_CAPACITY;
+    if (capacity < needed) capacity = needed;
+    unsigned char *bytes = (unsigned char *)arena_alloc_bytes(arena, capacity);
+    if (!bytes) {
+        perror("Failed to grow position list");
+        return 0;
+    }
+    if (list->length) memcpy(bytes, list->bytes, list->length);
+    list->bytes = bytes;
+    list->capacity = capacity;
+    return 1;
+}
+
+int add_position(PositionList *list, int position, int previous, Arena *arena) {
+    unsigned int value = previous < 0 ? (unsigned int)position : (unsigned int)(position - previous);
+    if (!grow_position_list(list, list->length + varint_size(value), arena)) return 0;
+    list->length += put_varint(list->bytes + list->length, value);
+    return 1;
+}
+
+int append_position_list(PositionList *dst, const PositionList *src, Arena *arena) {
+    if (src->length == 0) return 1;
+    if (!grow_position_list(dst, dst->length + src->length, arena)) return 0;
+    memcpy(dst->bytes + dst->length, src->bytes, src->length);
+    dst->length += src->length;
+    return 1;
+}
+
+void read_positions(const unsigned char **cursor, const unsigned char *end, int count, int *out) {
+    if (!out) {
+        // Only the last byte of a varint has the high bit clear
+        while (count > 0 && *cursor < end) {
+            if (!(*(*cursor)++ & 0x80)) count--;
+        }
+        return;
+    }
+    int position = 0;
+    for (int i = 0; i < count; i++) {
+        position = i == 0 ? (int)get_varint(cursor, end) : position + (int)get_varint(cursor, end);
+        out[i] = position;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef POSTING_OPERATIONS_H
+#define POSTING_OPERATIONS_H
+
+#include "structures.h"
+#include "arena.h"
+
+// Number of bytes 'value' takes as a varint.
+int varint_size(unsigned int value);
+
+// Initializes an empty list with room for exactly 'capacity' bytes from the arena.
+// Returns 1 on success.
+int init_posting_list(PostingList *list, int capacity, Arena *arena);
+
+// Records one occurrence of the word in quote 'quote_id'. Quote IDs must not decrease;
+// a repeat of the last quote only increments its term count. Grows the list in the arena.
+// Returns 1 on success.
+int add_posting(PostingList *list, int quote_id, Arena *arena);
+
+// Appends 'src', whose quotes all come after those of 'dst', re-encoding its first gap.
+// Returns 1 on success.
+int append_posting_list(PostingList *dst, const PostingList *src, Arena *arena);
+
+// Starts a walk over the list; call posting_iterator_next to reach the first posting.
+void posting_iterator_init(PostingIterator *it, const PostingList *list);
+
+// Starts a walk over the last 'count' postings of the list, after the posting of quote
+// 'previous_quote' (-1 for a walk over the whole list). Steps back over the varints from the
+// end, so it costs O(count) whatever the length of the list.
+void posting_iterator_init_tail(PostingIterator *it, const PostingList *list, int count, int previous_quote);
+
+// Moves to the next posting. Returns 1 if there is one, 0 at the end of the list.
+int posting_iterator_next(PostingIterator *it);
+
+// Total occurrences in the list, decoded from the term counts.
+int posting_list_frequency(const PostingList *list);
+
+// Initializes an empty position list with room for exactly 'capacity' bytes from the arena.
+// Returns 1 on success.
+int init_position_list(PositionList *list, int capacity, Arena *arena);
+
+// Records the next position of the word: 'previous' is its last position in the same quote,
+// or -1 for its first occurrence there. Grows the list in the arena. Returns 1 on success.
+int add_position(PositionList *list, int position, int previous, Arena *arena);
+
+// Appends the positions of 'src', whose postings were appended after those of 'dst'.
+// Returns 1 on success.
+int append_position_list(PositionList *dst, const PositionList *src, Arena *arena);
+
+// Reads the 'count' positions of one posting at *cursor into 'out' (or skips them if 'out' is
+// NULL) and advances the cursor past them.
+void read_positions(const unsigned char **cursor, const unsigned char *end, int count, int *out);
+
+#endif // POSTING_OPERATIONS_H
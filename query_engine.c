@@ -0,0 +1,366 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "query_engine.h"
+#include "array_operations.h"
+#include "freq_avl_operations.h"
+#include "hash_operations.h"
+#include "eytzinger_operations.h"
+#include "radix_operations.h"
+#include "boolean_operations.h"
+#include "quote_pool.h"
+#include "mem_accounting.h"
+#include "utils.h"
+
+Engine* load_engine(const char *filename, const LoadOptions *options, EngineLoadReport *report) {
+    memset(report, 0, sizeof(*report));
+    Engine *engine = (Engine *)calloc(1, sizeof(Engine));
+    if (!engine) {
+        perror("Failed to allocate engine");
+        return NULL;
+    }
+
+    const double start_load = wall_clock_ms();
+    report->times = load_data_from_file(filename, options, &engine->arena, &engine->pool, &engine->vector,
+                                        &engine->bst, &engine->avl, &engine->hash);
+    if (report->times.vector_time_ms < 0) {
+        free(engine);
+        return NULL;
+    }
+    engine->positions = options && options->positions;
+
+    // The frequency order serves top-K and is what the frequency AVL is built from
+    const uint64_t start_freq = timer_start();
+    report->freq_order_built = build_freq_order(&engine->freq_order, &engine->vector);
+    report->freq_order_time_ms = timer_stop(start_freq);
+    engine->freq_avl = build_freq_avl_from_order(&engine->freq_order, &engine->arena);
+    report->freq_avl_time_ms = timer_stop(start_freq) - report->freq_order_time_ms;
+
+    const uint64_t start_eytzinger = timer_start();
+    report->eytzinger_built = build_eytzinger_from_vector(&engine->eytzinger, &engine->vector);
+    report->eytzinger_time_ms = timer_stop(start_eytzinger);
+
+    const uint64_t start_radix = timer_start();
+    engine->radix = build_radix_from_sorted_vector(&engine->vector, &engine->arena);
+    report->radix_time_ms = timer_stop(start_radix);
+
+    const uint64_t start_quote_ids = timer_start();
+    report->quote_ids_built = build_quote_id_lists(&engine->quote_ids, &engine->vector);
+    report->quote_ids_time_ms = timer_stop(start_quote_ids);
+
+    const uint64_t start_years = timer_start();
+    const QueryIndex index = engine_query_index(engine);
+    report->year_counts_built = build_year_counts(&engine->year_counts, &index);
+    report->year_counts_time_ms = timer_stop(start_years);
+
+    engine->load_time_ms = report->total_time_ms = wall_clock_ms() - start_load;
+    return engine;
+}
+
+Engine* open_engine_snapshot(const char *filename, EngineLoadReport *report) {
+    memset(report, 0, sizeof(*report));
+    Engine *engine = (Engine *)calloc(1, sizeof(Engine));
+    if (!engine) {
+        perror("Failed to allocate engine");
+        return NULL;
+    }
+
+    const double start = wall_clock_ms();
+    index_arena_init(&engine->arena);
+    if (!open_index_snapshot(filename, &engine->snapshot)) {
+        free(engine);
+        return NULL;
+    }
+    init_quote_pool(&engine->pool, &engine->arena.slabs[SLAB_STRINGS]);
+    if (!snapshot_quote_pool(&engine->snapshot, &engine->pool)) {
+        free_quote_pool(&engine->pool);
+        index_arena_release(&engine->arena);
+        close_index_snapshot(&engine->snapshot);
+        free(engine);
+        return NULL;
+    }
+    report->total_time_ms = wall_clock_ms() - start;
+    engine->snapshot_open = 1;
+    engine->load_time_ms = -1.0;
+
+    // The year counts of top-K are built in memory; they are not part of the file
+    const uint64_t start_years = timer_start();
+    const QueryIndex index = engine_query_index(engine);
+    report->year_counts_built = build_year_counts(&engine->year_counts, &index);
+    report->year_counts_time_ms = timer_stop(start_years);
+    return engine;
+}
+
+int append_engine(Engine *engine, const char *filename, const LoadOptions *options, EngineAppendReport *report) {
+    memset(report, 0, sizeof(*report));
+    const int first_new_quote = engine->pool.quote_count;
+    report->times = append_data_from_file(filename, options, &engine->arena, &engine->pool, &engine->vector,
+                                          &engine->bst, &engine->avl, &engine->hash, &engine->freq_avl,
+                                          &engine->radix);
+    if (report->times.total_time_ms < 0) return 0;
+
+    const uint64_t start_eytzinger = timer_start();
+    free_eytzinger(&engine->eytzinger);
+    report->eytzinger_built = build_eytzinger_from_vector(&engine->eytzinger, &engine->vector);
+    report->eytzinger_time_ms = timer_stop(start_eytzinger);
+
+    const uint64_t start_freq = timer_start();
+    report->freq_order_built = build_freq_order_from_avl(&engine->freq_order, engine->freq_avl);
+    if (!report->freq_order_built) free_freq_order(&engine->freq_order);
+    report->freq_order_time_ms = timer_stop(start_freq);
+
+    // The lists follow the positions in the vector, which moved with the new words; only the
+    // postings of the new file are decoded
+    const uint64_t start_quote_ids = timer_start();
+    report->quote_ids_built = extend_quote_id_lists(&engine->quote_ids, &engine->vector, first_new_quote);
+    report->quote_ids_time_ms = timer_stop(start_quote_ids);
+
+    free_year_counts(&engine->year_counts);
+
+    report->total_time_ms = report->times.total_time_ms + report->eytzinger_time_ms + report->freq_order_time_ms +
+                            report->quote_ids_time_ms;
+    return 1;
+}
+
+Engine* open_engine(const char *filename, const LoadOptions *options, EngineLoadReport *report) {
+    if (is_index_snapshot(filename)) return open_engine_snapshot(filename, report);
+    return load_engine(filename, options, report);
+}
+
+QueryIndex engine_query_index(const Engine *engine) {
+    QueryIndex index;
+    memset(&index, 0, sizeof(index));
+    index.pool = &engine->pool;
+    if (engine->snapshot_open) {
+        index.snapshot = &engine->snapshot;
+    } else {
+        index.vector = &engine->vector;
+        index.eytzinger = &engine->eytzinger;
+        index.bst = engine->bst;
+        index.avl = engine->avl;
+        index.hash = &engine->hash;
+        index.radix = engine->radix;
+        index.freq_avl = engine->freq_avl;
+        index.freq_order = &engine->freq_order;
+        index.quote_ids = &engine->quote_ids;
+        index.positions = engine->positions;
+    }
+    index.year_counts = &engine->year_counts;
+    return index;
+}
+
+void free_engine(Engine *engine) {
+    if (!engine) return;
+    // The tree nodes, WordInfo, citations and strings live in the arena; these are the
+    // pointer arrays built over them
+    free_vector(&engine->vector);
+    free_hash_index(&engine->hash);
+    free_eytzinger(&engine->eytzinger);
+    free_freq_order(&engine->freq_order);
+    free_year_counts(&engine->year_counts);
+    free_quote_id_lists(&engine->quote_ids);
+    free_quote_pool(&engine->pool);
+    close_index_snapshot(&engine->snapshot);
+    index_arena_release(&engine->arena);
+    free(engine);
+}
+
+// --- Memory report ---
+
+// Objects of the engine behind a tag: slab objects, vector or hash entries, IDs, quotes.
+// -1 where there is no such count.
+static long engine_tag_objects(const Engine *engine, MemTag tag) {
+    if (tag >= MEM_SLAB_WORDS && tag <= MEM_SLAB_POSITIONS) {
+        return (long)engine->arena.slabs[tag - MEM_SLAB_WORDS].count;
+    }
+    switch (tag) {
+        case MEM_VECTOR: return engine->vector.size;
+        case MEM_HASH: return engine->hash.size;
+        case MEM_EYTZINGER: return engine->eytzinger.size;
+        case MEM_FREQ_ORDER: return engine->freq_order.size;
+        case MEM_QUOTE_IDS: return engine->quote_ids.size ? engine->quote_ids.offsets[engine->quote_ids.size] : 0;
+        case MEM_YEAR_COUNTS:
+            return engine->year_counts.size ? engine->year_counts.offsets[engine->year_counts.size] : 0;
+        case MEM_QUOTE_POOL: return engine->pool.quote_count;
+        default: return -1;
+    }
+}
+
+static void print_memory_row(const char *label, const MemStats *stats, long objects, long words) {
+    char objects_text[24] = "-";
+    if (objects >= 0) snprintf(objects_text, sizeof(objects_text), "%ld", objects);
+    printf("%-18s %14zu %8zu %10zu %12s %10.1f\n", label, stats->live_bytes, stats->live_allocations,
+           stats->allocations, objects_text, words > 0 ? (double)stats->live_bytes / words : 0.0);
+}
+
+void print_engine_memory_report(const Engine *engine) {
+    const long words = engine->snapshot_open ? (long)engine->snapshot.header->word_count : engine->vector.size;
+    printf("\n--- Memória por estrutura (%ld palavras únicas, %d frases) ---\n", words, engine->pool.quote_count);
+    printf("%-18s %14s %8s %10s %12s %10s\n", "Estrutura", "Bytes vivos", "Blocos", "Chamadas", "Objetos",
+           "B/palavra");
+    MemStats shown = { 0, 0, 0, 0 };
+    for (int t = 0; t < MEM_TAG_COUNT; t++) {
+        MemStats stats;
+        mem_tag_stats((MemTag)t, &stats);
+        // Tags with nothing alive are not part of this engine (the loader buffers only show up
+        // while another load is running)
+        if (stats.live_allocations == 0) continue;
+        print_memory_row(mem_tag_name((MemTag)t), &stats, engine_tag_objects(engine, (MemTag)t), words);
+        shown.live_bytes += stats.live_bytes;
+        shown.live_allocations += stats.live_allocations;
+        shown.allocations += stats.allocations;
+    }
+    print_memory_row("Total", &shown, -1, words);
+    printf("(Blocos: alocações vivas; Chamadas: alocações e realocações desde o início do processo)\n");
+
+    // What the structures hold in reserve for growing
+    if (!engine->snapshot_open) {
+        const WordVector *vec = &engine->vector;
+        printf("\nVetor: %d de %d posições ocupadas (%zu B sem uso)\n", vec->size, vec->capacity,
+               (size_t)(vec->capacity - vec->size) * sizeof(WordInfo *));
+        if (engine->hash.capacity > 0) {
+            printf("Tabela hash: %d de %d slots ocupados (%.0f%%)\n", engine->hash.size, engine->hash.capacity,
+                   100.0 * engine->hash.size / engine->hash.capacity);
+        }
+    }
+    size_t reserved = 0, used = 0;
+    for (int i = 0; i < SLAB_COUNT; i++) {
+        reserved += engine->arena.slabs[i].reserved;
+        used += engine->arena.slabs[i].used;
+    }
+    if (reserved > 0) {
+        printf("Arenas: %zu B entregues de %zu B reservados (%.1f%% livres no fim dos blocos)\n", used, reserved,
+               100.0 * (reserved - used) / reserved);
+    }
+
+    size_t mapped = engine->pool.source.size + engine->snapshot.file.size;
+    for (int i = 0; i < engine->pool.appended_count; i++) mapped += engine->pool.appended[i].size;
+    printf("Arquivos mapeados (fora do heap): %zu B\n", mapped);
+    MemStats total;
+    mem_total_stats(&total);
+    printf("Pico do heap contado: %zu B (buffers da carga incluídos)\n", total.peak_bytes);
+}
+
+// --- Publication ---
+
+void init_engine_handle(EngineHandle *handle) {
+    memset(handle, 0, sizeof(*handle));
+    atomic_init(&handle->current, NULL);
+    atomic_init(&handle->epoch, 1);
+    for (int r = 0; r < MAX_ENGINE_READERS; r++) {
+        atomic_init(&handle->readers[r].epoch, 0);
+        atomic_init(&handle->readers[r].used, 0);
+    }
+    pthread_mutex_init(&handle->writer_lock, NULL);
+}
+
+int register_engine_reader(EngineHandle *handle) {
+    for (int r = 0; r < MAX_ENGINE_READERS; r++) {
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&handle->readers[r].used, &expected, 1)) return r;
+    }
+    fprintf(stderr, "Aviso: mais de %d leitores do índice.\n", MAX_ENGINE_READERS);
+    return -1;
+}
+
+void unregister_engine_reader(EngineHandle *handle, int reader) {
+    if (reader < 0) return;
+    atomic_store(&handle->readers[reader].epoch, 0);
+    atomic_store(&handle->readers[reader].used, 0);
+}
+
+const Engine* enter_engine(EngineHandle *handle, int reader) {
+    // Sequentially consistent: the announcement is visible to a publisher that swaps the
+    // pointer after this thread loads it
+    atomic_store(&handle->readers[reader].epoch, atomic_load(&handle->epoch));
+    return atomic_load(&handle->current);
+}
+
+void leave_engine(EngineHandle *handle, int reader) {
+    atomic_store_explicit(&handle->readers[reader].epoch, 0, memory_order_release);
+}
+
+// Pause between two looks at the reader slots: a few yields for readers about to leave, then
+// sleeps from 50 us doubling up to 6.4 ms, so a reader that stays inside (a long query) does
+// not cost the waiting thread a whole processor
+static void back_off(int round) {
+    if (round < 16) {
+        sched_yield();
+        return;
+    }
+    const struct timespec pause = { 0, 50000L << (round - 16 < 7 ? round - 16 : 7) };
+    nanosleep(&pause, NULL);
+}
+
+long publish_engine(EngineHandle *handle, Engine *engine) {
+    RetiredEngine *retired = (RetiredEngine *)malloc(sizeof(RetiredEngine));
+    pthread_mutex_lock(&handle->writer_lock);
+    if (engine) engine->generation = handle->generation + 1;
+    Engine *previous = atomic_exchange(&handle->current, engine);
+    // Readers that announce the new epoch can only have loaded the new pointer
+    const uint64_t epoch = atomic_fetch_add(&handle->epoch, 1) + 1;
+    const long generation = ++handle->generation;
+    if (previous && retired) {
+        retired->engine = previous;
+        retired->epoch = epoch;
+        retired->next = handle->retired;
+        handle->retired = retired;
+        retired = NULL;
+    } else if (previous) {
+        // No room to defer it: wait here until it is safe
+        perror("Failed to retire engine");
+        for (int r = 0; r < MAX_ENGINE_READERS; r++) {
+            uint64_t seen;
+            for (int round = 0; (seen = atomic_load(&handle->readers[r].epoch)) != 0 && seen < epoch; round++) {
+                back_off(round);
+            }
+        }
+        free_engine(previous);
+        handle->reclaimed++;
+    }
+    pthread_mutex_unlock(&handle->writer_lock);
+    free(retired);
+    return generation;
+}
+
+// Oldest epoch still announced by a reader (UINT64_MAX if none)
+static uint64_t oldest_reader_epoch(EngineHandle *handle) {
+    uint64_t oldest = UINT64_MAX;
+    for (int r = 0; r < MAX_ENGINE_READERS; r++) {
+        const uint64_t seen = atomic_load(&handle->readers[r].epoch);
+        if (seen != 0 && seen < oldest) oldest = seen;
+    }
+    return oldest;
+}
+
+int reclaim_engines(EngineHandle *handle, int wait) {
+    for (int round = 0;; round++) {
+        pthread_mutex_lock(&handle->writer_lock);
+        const uint64_t oldest = oldest_reader_epoch(handle);
+        int left = 0;
+        RetiredEngine **link = &handle->retired;
+        while (*link) {
+            RetiredEngine *retired = *link;
+            if (retired->epoch <= oldest) {
+                *link = retired->next;
+                free_engine(retired->engine);
+                free(retired);
+                handle->reclaimed++;
+            } else {
+                link = &retired->next;
+                left++;
+            }
+        }
+        pthread_mutex_unlock(&handle->writer_lock);
+        if (left == 0 || !wait) return left;
+        back_off(round);
+    }
+}
+
+void destroy_engine_handle(EngineHandle *handle) {
+    publish_engine(handle, NULL);
+    reclaim_engines(handle, 1);
+    pthread_mutex_destroy(&handle->writer_lock);
+}
@@ -0,0 +1,160 @@
+#ifndef QUERY_ENGINE_H
+#define QUERY_ENGINE_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "structures.h"
+#include "arena.h"
+#include "file_parser.h"
+#include "index_snapshot.h"
+#include "query_operations.h"
+
+// Everything one loaded index owns: the arena, the quote pool and every structure built
+// over them, or the mapped snapshot. Once built, nothing writes to it, so any number of
+// threads may query it at the same time through engine_query_index. Only append_engine
+// changes it, and only while no one else holds it.
+typedef struct Engine {
+  IndexArena arena;           // Owns every WordInfo, citation, string and tree node
+  QuotePool pool;
+  WordVector vector;
+  BSTNode *bst;
+  AVLNode *avl;
+  FreqAVLNode *freq_avl;
+  RadixNode *radix;
+  FreqOrder freq_order;       // Words by (frequency, word), for top-K
+  YearCounts year_counts;     // Occurrences per year, for the year filter of top-K
+  QuoteIdLists quote_ids;     // Quote IDs of every word, for boolean and ranked queries
+  HashIndex hash;
+  EytzingerIndex eytzinger;
+  IndexSnapshot snapshot;     // Queried in place when the index was opened from a snapshot
+  int snapshot_open;
+  int positions;              // 1 if the words carry token positions
+  double load_time_ms;        // Full load of the CSV, saved with the snapshot (-1 for a snapshot)
+  long generation;            // Number of the publication that made it current (0 if never published)
+} Engine;
+
+// Timings of a load or of a snapshot open, for the reports of the caller
+typedef struct EngineLoadReport {
+  LoadTimes times;            // Load of the CSV (unset for a snapshot)
+  double freq_order_time_ms;
+  double freq_avl_time_ms;
+  double eytzinger_time_ms;
+  double radix_time_ms;
+  double quote_ids_time_ms;
+  double year_counts_time_ms;
+  int freq_order_built;
+  int eytzinger_built;
+  int quote_ids_built;
+  int year_counts_built;
+  double total_time_ms;       // Whole load, or the open of the snapshot without the year counts
+} EngineLoadReport;
+
+// Timings of an append
+typedef struct EngineAppendReport {
+  AppendTimes times;
+  double eytzinger_time_ms;
+  double freq_order_time_ms;
+  double quote_ids_time_ms;
+  int eytzinger_built;
+  int freq_order_built;
+  int quote_ids_built;
+  double total_time_ms;
+} EngineAppendReport;
+
+// Loads the CSV and builds every structure of the index, year counts included, so the
+// engine is complete before anyone reads it. Returns NULL if the file cannot be loaded.
+Engine* load_engine(const char *filename, const LoadOptions *options, EngineLoadReport *report);
+
+// Opens a snapshot as an engine; only the year counts are built in memory.
+// Returns NULL if the file is not a valid snapshot.
+Engine* open_engine_snapshot(const char *filename, EngineLoadReport *report);
+
+// Merges another CSV into a loaded engine and refreshes the views derived from the vector.
+// The year counts follow the frequency ranks, which change, so they are dropped; the caller
+// rebuilds them when it needs them. Returns 1 on success, 0 on failure, with
+// report->times.index_kept telling whether the engine survived (if not, free it).
+int append_engine(Engine *engine, const char *filename, const LoadOptions *options, EngineAppendReport *report);
+
+// Loads a CSV or opens a snapshot, whichever the file is.
+Engine* open_engine(const char *filename, const LoadOptions *options, EngineLoadReport *report);
+
+// Read-only view of the engine for the query functions.
+QueryIndex engine_query_index(const Engine *engine);
+
+// Frees everything the engine owns and the engine itself.
+void free_engine(Engine *engine);
+
+// Prints, for each allocation tag, the live bytes and blocks, the allocation calls, the
+// engine's objects behind it and the bytes per unique word; then the unused part of the vector,
+// hash and arenas, the mapped files and the peak. The counters cover the whole process, so
+// they describe this engine alone only when no other engine or load is alive.
+void print_engine_memory_report(const Engine *engine);
+
+// --- Publication ---
+
+#define MAX_ENGINE_READERS 256
+
+#define ENGINE_CACHE_LINE 64
+
+// Epoch a reader thread entered, 0 while it holds no engine; aligned to a cache line of its
+// own so the readers do not slow each other down
+typedef struct EngineReaderSlot {
+  _Alignas(ENGINE_CACHE_LINE) _Atomic uint64_t epoch;
+  atomic_int used;
+} EngineReaderSlot;
+
+// An engine replaced by a newer one, freed once no reader can still be using it
+typedef struct RetiredEngine {
+  Engine *engine;
+  uint64_t epoch;             // Global epoch right after it was replaced
+  struct RetiredEngine *next;
+} RetiredEngine;
+
+// The current engine of a process, replaced without stopping its readers.
+// A reader announces the global epoch in its slot before loading the pointer and clears it
+// when done. Publishing swaps the pointer atomically and advances the epoch; the old engine
+// is retired and freed only when every slot is clear or shows a newer epoch, because a
+// reader that got the old pointer announced itself before the swap.
+// The handle is aligned like its slots, so a handle on the heap needs aligned_alloc.
+typedef struct EngineHandle {
+  // Read by every reader and written once per publication: a line of their own
+  _Alignas(ENGINE_CACHE_LINE) _Atomic(Engine *) current;
+  _Atomic uint64_t epoch;
+  EngineReaderSlot readers[MAX_ENGINE_READERS];
+  pthread_mutex_t writer_lock; // Serializes the publishers and guards the retired list
+  RetiredEngine *retired;
+  long generation;            // Publications so far
+  long reclaimed;             // Retired engines freed so far
+} EngineHandle;
+
+// Starts a handle with no engine.
+void init_engine_handle(EngineHandle *handle);
+
+// Claims a reader slot for the calling thread. Returns its number, or -1 if all are taken.
+int register_engine_reader(EngineHandle *handle);
+
+// Gives the slot back; the reader must not hold an engine.
+void unregister_engine_reader(EngineHandle *handle, int reader);
+
+// Enters the current epoch and returns the current engine (NULL if none), which stays valid
+// until leave_engine. Never blocks.
+const Engine* enter_engine(EngineHandle *handle, int reader);
+
+// Leaves the epoch; the engine returned by enter_engine may be freed from now on.
+void leave_engine(EngineHandle *handle, int reader);
+
+// Makes 'engine' (may be NULL) the current one and retires the previous. Readers already
+// inside keep the old one; the next enter_engine gets the new one. Returns the new generation.
+long publish_engine(EngineHandle *handle, Engine *engine);
+
+// Frees the retired engines no reader can still see. With 'wait' it waits, without ever
+// blocking the readers and sleeping longer the longer they stay, until every retired engine
+// is freed. Returns how many are left.
+int reclaim_engines(EngineHandle *handle, int wait);
+
+// Publishes NULL, waits for the readers to leave and frees everything. No reader may enter
+// afterwards.
+void destroy_engine_handle(EngineHandle *handle);
+
+#endif // QUERY_ENGINE_H
@@ -0,0 +1,996 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "query_operations.h"
+#include "array_operations.h"
+#include "eytzinger_operations.h"
+#include "bst_operations.h"
+#include "avl_operations.h"
+#include "hash_operations.h"
+#include "freq_avl_operations.h"
+#include "radix_operations.h"
+#include "boolean_operations.h"
+#include "phrase_operations.h"
+#include "ranking_operations.h"
+#include "posting_operations.h"
+#include "mem_accounting.h"
+#include "word_processing.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+#define BATCH_OUTPUT_BUFFER (1 << 20)
+#define MAX_QUERY_WORD 256
+#define DEFAULT_COMPLETIONS 10
+#define DEFAULT_FUZZY_DISTANCE 2
+#define MAX_FUZZY_DISTANCE 2
+
+static const char *structure_names[QUERY_STRUCTURE_COUNT] = {
+    "vector", "eytzinger", "bst", "avl", "hash", "radix", "snapshot"
+};
+
+int parse_query_structure(const char *name) {
+    for (int i = 0; i < QUERY_STRUCTURE_COUNT; i++) {
+        if (strcmp(name, structure_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char* query_structure_name(QueryStructure structure) {
+    return (structure >= 0 && structure < QUERY_STRUCTURE_COUNT) ? structure_names[structure] : "?";
+}
+
+const WordInfo* lookup_word(const QueryIndex *index, QueryStructure structure, const char *word, WordInfo *view) {
+    switch (structure) {
+        case QUERY_VECTOR:
+            return index->vector ? search_vector(index->vector, word) : NULL;
+        case QUERY_EYTZINGER:
+            return index->eytzinger ? search_eytzinger(index->eytzinger, word) : NULL;
+        case QUERY_BST:
+            return search_bst(index->bst, word);
+        case QUERY_AVL:
+            return search_avl(index->avl, word);
+        case QUERY_HASH:
+            return index->hash ? search_hash_index(index->hash, word) : NULL;
+        case QUERY_RADIX:
+            return search_radix(index->radix, word);
+        case QUERY_SNAPSHOT:
+            return index->snapshot && search_snapshot(index->snapshot, word, view) ? view : NULL;
+        default:
+            return NULL;
+    }
+}
+
+void visit_freq_range(const QueryIndex *index, int min_freq, int max_freq, WordVisitor visit, void *context) {
+    if (index->snapshot) {
+        visit_freq_range_snapshot(index->snapshot, min_freq, max_freq, visit, context);
+    } else {
+        visit_freq_range_avl(index->freq_avl, min_freq, max_freq, visit, context);
+    }
+}
+
+int count_freq_range(const QueryIndex *index, int min_freq, int max_freq) {
+    if (index->snapshot) return count_freq_range_snapshot(index->snapshot, min_freq, max_freq);
+    return count_freq_range_avl(index->freq_avl, min_freq, max_freq);
+}
+
+int page_freq_range(const QueryIndex *index, int min_freq, int max_freq, int offset, WordInfo *out, int capacity) {
+    if (index->snapshot) return page_freq_range_snapshot(index->snapshot, min_freq, max_freq, offset, out, capacity);
+    return page_freq_range_avl(index->freq_avl, min_freq, max_freq, offset, out, capacity);
+}
+
+// --- Top-K ---
+
+// Word of rank 'rank' in (frequency, word) order; snapshot words are returned through *view
+static const WordInfo* freq_order_at(const QueryIndex *index, int rank, WordInfo *view) {
+    if (index->snapshot) return snapshot_freq_rank_view(index->snapshot, rank, view) ? view : NULL;
+    return index->freq_order->words[rank];
+}
+
+static int freq_order_size(const QueryIndex *index) {
+    if (index->snapshot) return index->snapshot->header ? (int)index->snapshot->header->word_count : 0;
+    return index->freq_order ? index->freq_order->size : 0;
+}
+
+// Occurrences of the word in quotes from [min_year, max_year]
+static int year_frequency(const WordInfo *info, const QuotePool *pool, int min_year, int max_year) {
+    PostingIterator it;
+    int frequency = 0;
+    posting_iterator_init(&it, &info->postings);
+    while (posting_iterator_next(&it)) {
+        const int year = pool->quotes[it.quote_id].year;
+        if (year >= min_year && year <= max_year) frequency += it.term_count;
+    }
+    return frequency;
+}
+
+#define MAX_YEAR_SPAN 100000 // Years further apart than this are treated as bad data
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int build_year_counts(YearCounts *counts, const QueryIndex *index) {
+    memset(counts, 0, sizeof(*counts));
+    const QuotePool *pool = index->pool;
+    const int size = freq_order_size(index);
+    if (!pool || pool->quote_count == 0 || size == 0) return 1;
+
+    int min_year = pool->quotes[0].year, max_year = pool->quotes[0].year;
+    for (int i = 1; i < pool->quote_count; i++) {
+        if (pool->quotes[i].year < min_year) min_year = pool->quotes[i].year;
+        if (pool->quotes[i].year > max_year) max_year = pool->quotes[i].year;
+    }
+    if ((long long)max_year - min_year >= MAX_YEAR_SPAN) {
+        fprintf(stderr, "Aviso: anos de %d a %d; o filtro por ano vai ler as citações.\n", min_year, max_year);
+        return 0;
+    }
+    const int span = max_year - min_year + 1;
+
+    int capacity = size * 2;
+    int *quote_slot = (int *)malloc(pool->quote_count * sizeof(int)); // Compact copy of the quote years
+    int *per_year = (int *)calloc(span, sizeof(int));
+    int *touched = (int *)malloc(span * sizeof(int));
+    counts->offsets = (int *)mem_alloc(MEM_YEAR_COUNTS, (size + 1) * sizeof(int));
+    counts->years = (int *)mem_alloc(MEM_YEAR_COUNTS, capacity * sizeof(int));
+    counts->cumulative = (int *)mem_alloc(MEM_YEAR_COUNTS, capacity * sizeof(int));
+    int ok = quote_slot && per_year && touched && counts->offsets && counts->years && counts->cumulative;
+    for (int i = 0; ok && i < pool->quote_count; i++) {
+        quote_slot[i] = pool->quotes[i].year - min_year;
+    }
+
+    int used = 0;
+    WordInfo view;
+    for (int rank = 0; rank < size && ok; rank++) {
+        // Occurrences per year of this word, then written out in year order with running totals
+        const WordInfo *info = freq_order_at(index, rank, &view);
+        PostingIterator it;
+        int touched_count = 0;
+        posting_iterator_init(&it, &info->postings);
+        while (posting_iterator_next(&it)) {
+            const int slot = quote_slot[it.quote_id];
+            if (per_year[slot] == 0) touched[touched_count++] = slot;
+            per_year[slot] += it.term_count;
+        }
+        qsort(touched, touched_count, sizeof(int), compare_ints);
+
+        if (used + touched_count > capacity) {
+            while (used + touched_count > capacity) capacity *= 2;
+            int *years = (int *)mem_realloc(MEM_YEAR_COUNTS, counts->years, capacity * sizeof(int));
+            if (years) counts->years = years;
+            int *cumulative = (int *)mem_realloc(MEM_YEAR_COUNTS, counts->cumulative, capacity * sizeof(int));
+            if (cumulative) counts->cumulative = cumulative;
+            if (!years || !cumulative) {
+                ok = 0;
+                break;
+            }
+        }
+        counts->offsets[rank] = used;
+        int running = 0;
+        for (int t = 0; t < touched_count; t++) {
+            running += per_year[touched[t]];
+            per_year[touched[t]] = 0;
+            counts->years[used] = touched[t] + min_year;
+            counts->cumulative[used++] = running;
+        }
+    }
+    free(quote_slot);
+    free(per_year);
+    free(touched);
+    if (!ok) {
+        perror("Falha ao alocar as contagens por ano");
+        free_year_counts(counts);
+        return 0;
+    }
+    counts->offsets[size] = used;
+    counts->size = size;
+    return 1;
+}
+
+void free_year_counts(YearCounts *counts) {
+    mem_free(counts->offsets);
+    mem_free(counts->years);
+    mem_free(counts->cumulative);
+    memset(counts, 0, sizeof(*counts));
+}
+
+// Occurrences of the word of this rank in years up to 'year'
+static int occurrences_up_to(const YearCounts *counts, int rank, long long year) {
+    int low = counts->offsets[rank], high = counts->offsets[rank + 1];
+    const int first = low;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (counts->years[mid] <= year) low = mid + 1;
+        else high = mid;
+    }
+    return low > first ? counts->cumulative[low - 1] : 0;
+}
+
+// Result order: higher frequency first, then word order
+static int ranks_before(const TopKEntry *a, const TopKEntry *b) {
+    if (a->frequency != b->frequency) return a->frequency > b->frequency;
+    return strcmp(a->word, b->word) < 0;
+}
+
+static int compare_top_k_entries(const void *a, const void *b) {
+    const TopKEntry *x = (const TopKEntry *)a, *y = (const TopKEntry *)b;
+    return ranks_before(x, y) ? -1 : ranks_before(y, x);
+}
+
+// The heap keeps the entry that ranks last at the root, so it is the one replaced
+static void sift_up_top_k(TopKEntry *heap, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!ranks_before(&heap[parent], &heap[i])) break;
+        TopKEntry tmp = heap[parent]; heap[parent] = heap[i]; heap[i] = tmp;
+        i = parent;
+    }
+}
+
+static void sift_down_top_k(TopKEntry *heap, int count) {
+    int i = 0;
+    for (;;) {
+        int last = i, left = 2 * i + 1, right = left + 1;
+        if (left < count && ranks_before(&heap[last], &heap[left])) last = left;
+        if (right < count && ranks_before(&heap[last], &heap[right])) last = right;
+        if (last == i) break;
+        TopKEntry tmp = heap[last]; heap[last] = heap[i]; heap[i] = tmp;
+        i = last;
+    }
+}
+
+int top_k_words(const QueryIndex *index, int k, const TopKFilter *filter, TopKEntry *out) {
+    const int min_length = filter ? filter->min_length : 0;
+    const int by_year = filter && filter->max_year > 0 && index->pool;
+    int count = 0;
+    WordInfo view;
+
+    // Walks the frequency order from the end one frequency at a time, each in word order
+    int end = freq_order_size(index);
+    while (end > 0 && k > 0) {
+        const int frequency = freq_order_at(index, end - 1, &view)->frequency;
+        // Filtered frequencies never exceed the total, so nothing below can enter a full heap
+        if (count == k && frequency < out[0].frequency) break;
+
+        int start = end - 1;
+        while (start > 0 && freq_order_at(index, start - 1, &view)->frequency == frequency) start--;
+        for (int rank = start; rank < end; rank++) {
+            const WordInfo *info = freq_order_at(index, rank, &view);
+            if (min_length > 0 && (int)strlen(info->word) < min_length) continue;
+            TopKEntry entry = { info->word, frequency };
+            if (by_year) {
+                entry.frequency = index->year_counts && index->year_counts->size == freq_order_size(index)
+                    ? occurrences_up_to(index->year_counts, rank, filter->max_year) -
+                      occurrences_up_to(index->year_counts, rank, (long long)filter->min_year - 1)
+                    : year_frequency(info, index->pool, filter->min_year, filter->max_year);
+                if (entry.frequency == 0) continue;
+            }
+            if (count < k) {
+                out[count] = entry;
+                sift_up_top_k(out, count++);
+            } else if (ranks_before(&entry, &out[0])) {
+                out[0] = entry;
+                sift_down_top_k(out, count);
+            }
+        }
+        end = start;
+    }
+
+    qsort(out, count, sizeof(TopKEntry), compare_top_k_entries);
+    return count;
+}
+
+// --- Prefix Completion ---
+
+int complete_prefix(const QueryIndex *index, QueryStructure structure, const char *prefix, int limit,
+                    TopKEntry *out, int *total) {
+    if (structure == QUERY_RADIX && !index->snapshot) {
+        const WordInfo **words = (const WordInfo **)malloc((limit > 0 ? limit : 1) * sizeof(const WordInfo *));
+        if (!words) {
+            perror("Falha ao alocar o autocompletar");
+            return -1;
+        }
+        const int found = complete_radix(index->radix, prefix, limit, words, total);
+        for (int i = 0; i < found; i++) {
+            out[i].word = words[i]->word;
+            out[i].frequency = words[i]->frequency;
+        }
+        free(words);
+        return found;
+    }
+
+    // Baseline: every word of the prefix range goes through a bounded heap
+    int first = 0, count = 0;
+    const int range = index->snapshot ? prefix_range_snapshot(index->snapshot, prefix, &first)
+                                      : index->vector ? prefix_range_vector(index->vector, prefix, &first) : 0;
+    if (total) *total = range;
+    WordInfo view;
+    for (int i = first; i < first + range && limit > 0; i++) {
+        const WordInfo *info = index->snapshot ? (snapshot_word_at(index->snapshot, i, &view) ? &view : NULL)
+                                               : index->vector->words[i];
+        if (!info) continue;
+        TopKEntry entry = { info->word, info->frequency };
+        if (count < limit) {
+            out[count] = entry;
+            sift_up_top_k(out, count++);
+        } else if (ranks_before(&entry, &out[0])) {
+            out[0] = entry;
+            sift_down_top_k(out, count);
+        }
+    }
+    qsort(out, count, sizeof(TopKEntry), compare_top_k_entries);
+    return count;
+}
+
+// --- Fuzzy Lookup ---
+
+// Words in range of a fuzzy lookup, gathered unordered and sorted at the end
+typedef struct FuzzyMatches {
+    FuzzyEntry *entries;
+    int count;
+    int capacity;
+    int failed;
+} FuzzyMatches;
+
+static void collect_fuzzy_match(const WordInfo *info, int distance, void *context) {
+    FuzzyMatches *matches = (FuzzyMatches *)context;
+    if (matches->count == matches->capacity) {
+        int capacity = matches->capacity ? matches->capacity * 2 : 64;
+        FuzzyEntry *entries = (FuzzyEntry *)realloc(matches->entries, capacity * sizeof(FuzzyEntry));
+        if (!entries) {
+            matches->failed = 1;
+            return;
+        }
+        matches->entries = entries;
+        matches->capacity = capacity;
+    }
+    FuzzyEntry entry = { info->word, info->frequency, distance };
+    matches->entries[matches->count++] = entry;
+}
+
+// Nearest first, then most frequent, then word order
+static int compare_fuzzy_entries(const void *a, const void *b) {
+    const FuzzyEntry *x = (const FuzzyEntry *)a, *y = (const FuzzyEntry *)b;
+    if (x->distance != y->distance) return x->distance - y->distance;
+    if (x->frequency != y->frequency) return (x->frequency < y->frequency) - (x->frequency > y->frequency);
+    return strcmp(x->word, y->word);
+}
+
+int fuzzy_lookup(const QueryIndex *index, QueryStructure structure, const char *word, int max_distance, int limit,
+                 FuzzyEntry *out, int *total, long *examined) {
+    FuzzyMatches matches = { NULL, 0, 0, 0 };
+    long visited = 0;
+    if (structure == QUERY_RADIX && !index->snapshot) {
+        visited = fuzzy_radix(index->radix, word, max_distance, collect_fuzzy_match, &matches);
+        if (visited < 0) matches.failed = 1;
+    } else {
+        // Baseline: the distance to every word
+        const int length = (int)strlen(word);
+        int *rows = (int *)malloc(2 * (length + 1) * sizeof(int));
+        if (!rows) {
+            perror("Falha ao alocar a busca aproximada");
+            return -1;
+        }
+        const int size = index->snapshot ? (int)index->snapshot->header->word_count
+                                         : index->vector ? index->vector->size : 0;
+        WordInfo view;
+        for (int i = 0; i < size; i++) {
+            const WordInfo *info = index->snapshot ? (snapshot_word_at(index->snapshot, i, &view) ? &view : NULL)
+                                                   : index->vector->words[i];
+            if (!info) continue;
+            const int distance = bounded_edit_distance(info->word, word, length, max_distance, rows);
+            if (distance <= max_distance) collect_fuzzy_match(info, distance, &matches);
+        }
+        free(rows);
+        visited = size;
+    }
+    if (examined) *examined = visited;
+    if (total) *total = matches.count;
+    if (matches.failed) {
+        perror("Falha ao alocar a busca aproximada");
+        free(matches.entries);
+        return -1;
+    }
+
+    const int count = matches.count < limit ? matches.count : (limit > 0 ? limit : 0);
+    if (count > 0) {
+        qsort(matches.entries, matches.count, sizeof(FuzzyEntry), compare_fuzzy_entries);
+        memcpy(out, matches.entries, count * sizeof(FuzzyEntry));
+    }
+    free(matches.entries);
+    return count;
+}
+
+// --- Batch Mode ---
+
+typedef enum BatchQueryType {
+    QUERY_WORD, QUERY_FREQ_RANGE, QUERY_FREQ_COUNT, QUERY_TOP_K, QUERY_PREFIX, QUERY_BOOLEAN, QUERY_PHRASE,
+    QUERY_FUZZY, QUERY_RANKED, BATCH_QUERY_TYPE_COUNT
+} BatchQueryType;
+
+// A parsed line of the query file
+typedef struct BatchQuery {
+    BatchQueryType type;
+    char *word;        // Normalized word or prefix (NULL if normalization rejects it); any length for a fuzzy word
+    BooleanNode *boolean; // Parsed boolean query
+    PhraseQuery *phrase;  // Parsed phrase query
+    RankedQuery *ranked;  // Parsed ranked query
+    const char *raw;   // The word, boolean or ranked query or phrase as written, for the output (not NUL-terminated)
+    int raw_length;
+    int min_freq;
+    int max_freq;
+    int offset;        // First result of a paged range
+    int limit;         // Page size of a paged range (-1 returns the whole range), K of a top-K query,
+                       // completions of a prefix, words of a fuzzy lookup, quotes of a ranked query
+    int max_distance;  // Edit distance of a fuzzy lookup
+    TopKFilter filter;
+} BatchQuery;
+
+// Latency rows of the batch report; both kinds of range query share one
+static const int latency_rows[BATCH_QUERY_TYPE_COUNT] = { 0, 1, 1, 2, 3, 4, 5, 6, 7 };
+#define LATENCY_ROW_COUNT 8
+static const char *latency_labels[LATENCY_ROW_COUNT] = {
+    "palavras", "intervalos", "top-K", "prefixos", "booleanas", "frases", "aproximadas", "ranqueadas"
+};
+
+static void collect_range_word(const WordInfo *info, void *context) {
+    QueryBuffers *buffers = (QueryBuffers *)context;
+    if (buffers->range_count == buffers->range_capacity) {
+        int capacity = buffers->range_capacity ? buffers->range_capacity * 2 : 256;
+        const char **words = (const char **)realloc(buffers->range_words, capacity * sizeof(const char *));
+        if (!words) {
+            buffers->range_failed = 1;
+            return;
+        }
+        buffers->range_words = words;
+        buffers->range_capacity = capacity;
+    }
+    // Stays valid: it lives in the arena or the mapped snapshot
+    buffers->range_words[buffers->range_count++] = info->word;
+}
+
+// Grows one result array of the buffers to at least 'needed' entries
+static int reserve_results(void **array, int *capacity, int needed, size_t entry_size) {
+    if (needed < 1) needed = 1;
+    if (*capacity >= needed) return 1;
+    void *grown = realloc(*array, (size_t)needed * entry_size);
+    if (!grown) return 0;
+    *array = grown;
+    *capacity = needed;
+    return 1;
+}
+
+static int reserve_query_buffers(QueryBuffers *buffers, const BatchQuery *query) {
+    switch (query->type) {
+        case QUERY_FREQ_RANGE:
+            return reserve_results((void **)&buffers->page, &buffers->page_capacity, query->limit, sizeof(WordInfo));
+        case QUERY_TOP_K:
+        case QUERY_PREFIX:
+            return reserve_results((void **)&buffers->top, &buffers->top_capacity, query->limit, sizeof(TopKEntry));
+        case QUERY_FUZZY:
+            return reserve_results((void **)&buffers->fuzzy, &buffers->fuzzy_capacity, query->limit,
+                                   sizeof(FuzzyEntry));
+        case QUERY_RANKED:
+            return reserve_results((void **)&buffers->ranked, &buffers->ranked_capacity, query->limit,
+                                   sizeof(RankedQuote));
+        default:
+            return 1;
+    }
+}
+
+void free_query_buffers(QueryBuffers *buffers) {
+    free(buffers->page);
+    free(buffers->top);
+    free(buffers->fuzzy);
+    free(buffers->ranked);
+    free(buffers->range_words);
+    memset(buffers, 0, sizeof(*buffers));
+}
+
+static void free_batch_query(BatchQuery *query) {
+    free(query->word);
+    free_boolean_query(query->boolean);
+    free_phrase_query(query->phrase);
+    free_ranked_query(query->ranked);
+}
+
+static void free_batch_queries(BatchQuery *queries, int count) {
+    for (int i = 0; queries && i < count; i++) {
+        free_batch_query(&queries[i]);
+    }
+    free(queries);
+}
+
+// Copies the free text of a boolean, phrase or ranked query, which is parsed from the whole
+// line and not from the fixed-size copy of the other queries. Returns NULL if out of memory.
+static char* copy_query_text(const char *text, const char *line_end) {
+    const size_t length = (size_t)(line_end - text);
+    char *copy = (char *)malloc(length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// Parses one line of the query language; the raw text of the query points into the line.
+// Returns 1 for a query, -1 for a blank line or a comment, and 0 for a malformed line, with
+// what it is in *problem and, for boolean, phrase and ranked queries, the parser message in
+// 'error' (empty otherwise).
+static int parse_batch_line(const char *line, const char *line_end, BatchQuery *query, const char **problem,
+                            char *error, int error_size) {
+    memset(query, 0, sizeof(*query));
+    *problem = "consulta inválida";
+    error[0] = '\0';
+    if (line_end > line && line_end[-1] == '\r') line_end--;
+    while (line < line_end && (*line == ' ' || *line == '\t')) line++;
+    if (line == line_end || *line == '#') return -1;
+
+    char buffer[MAX_QUERY_WORD];
+    size_t length = (size_t)(line_end - line) < sizeof(buffer) - 1 ? (size_t)(line_end - line) : sizeof(buffer) - 1;
+    memcpy(buffer, line, length);
+    buffer[length] = '\0';
+
+    char word[MAX_QUERY_WORD];
+    int fields;
+    const int separated = buffer[1] == ' ' || buffer[1] == '\t';
+    // Boolean, phrase and ranked queries are parsed from the whole line; the others must fit
+    // in the copy, or they would be answered for a query the user did not write
+    if ((size_t)(line_end - line) >= sizeof(buffer) && !(separated && strchr("bsr", buffer[0]))) {
+        *problem = "consulta longa demais";
+        snprintf(error, error_size, "mais de %d bytes", MAX_QUERY_WORD - 1);
+        return 0;
+    }
+    if (buffer[0] == 'w' && separated && sscanf(buffer + 1, "%255s", word) == 1) {
+        query->type = QUERY_WORD;
+        query->word = normalize_word(word);
+        query->raw = line + (strstr(buffer + 1, word) - buffer); // Points into the query line
+        query->raw_length = (int)strlen(word);
+        return 1;
+    }
+    if (buffer[0] == 'f' && separated &&
+        (fields = sscanf(buffer + 1, "%d %d %d %d", &query->min_freq, &query->max_freq, &query->offset,
+                         &query->limit)) >= 2 && fields != 3 &&
+        (fields == 2 || (query->offset >= 0 && query->limit >= 0))) {
+        query->type = QUERY_FREQ_RANGE;
+        if (fields == 2) {
+            query->offset = 0;
+            query->limit = -1;
+        }
+        return 1;
+    }
+    if (buffer[0] == 't' && separated &&
+        ((fields = sscanf(buffer + 1, "%d %d %d %d", &query->limit, &query->filter.min_length,
+                          &query->filter.min_year, &query->filter.max_year)) == 1 || fields == 2 ||
+         fields == 4) && query->limit > 0) {
+        query->type = QUERY_TOP_K;
+        if (fields < 2) query->filter.min_length = 0;
+        if (fields < 4) query->filter.min_year = query->filter.max_year = 0;
+        return 1;
+    }
+    if (buffer[0] == 'p' && separated && (fields = sscanf(buffer + 1, "%255s %d", word, &query->limit)) >= 1 &&
+        (fields == 1 || query->limit > 0)) {
+        query->type = QUERY_PREFIX;
+        query->word = normalize_prefix(word);
+        query->raw = line + (strstr(buffer + 1, word) - buffer);
+        query->raw_length = (int)strlen(word);
+        if (fields == 1) query->limit = DEFAULT_COMPLETIONS;
+        return 1;
+    }
+    if (buffer[0] == 'a' && separated &&
+        (fields = sscanf(buffer + 1, "%255s %d %d", word, &query->max_distance, &query->limit)) >= 1 &&
+        (fields == 1 || (query->max_distance >= 1 && query->max_distance <= MAX_FUZZY_DISTANCE)) &&
+        (fields < 3 || query->limit > 0)) {
+        query->type = QUERY_FUZZY;
+        query->word = normalize_prefix(word); // A misspelling may be shorter than the words it is meant as
+        query->raw = line + (strstr(buffer + 1, word) - buffer);
+        query->raw_length = (int)strlen(word);
+        if (fields == 1) query->max_distance = DEFAULT_FUZZY_DISTANCE;
+        if (fields < 3) query->limit = DEFAULT_COMPLETIONS;
+        return 1;
+    }
+    if (buffer[0] == 'b' && separated) {
+        const char *text = line + 2;
+        while (text < line_end && (*text == ' ' || *text == '\t')) text++;
+        char *copy = copy_query_text(text, line_end);
+        if (!copy) snprintf(error, error_size, "falta de memória");
+        query->boolean = copy ? parse_boolean_query(copy, error, error_size) : NULL;
+        free(copy);
+        if (!query->boolean) {
+            *problem = "consulta booleana inválida";
+            return 0;
+        }
+        query->type = QUERY_BOOLEAN;
+        query->raw = text;
+        query->raw_length = (int)(line_end - text);
+        return 1;
+    }
+    if (buffer[0] == 's' && separated) {
+        const char *text = line + 2;
+        while (text < line_end && (*text == ' ' || *text == '\t')) text++;
+        char *copy = copy_query_text(text, line_end);
+        if (!copy) snprintf(error, error_size, "falta de memória");
+        query->phrase = copy ? parse_phrase_query(copy, error, error_size) : NULL;
+        free(copy);
+        if (!query->phrase) {
+            *problem = "frase inválida";
+            return 0;
+        }
+        query->type = QUERY_PHRASE;
+        query->raw = text;
+        query->raw_length = (int)(line_end - text);
+        return 1;
+    }
+    if (buffer[0] == 'r' && separated && sscanf(buffer + 1, "%d%n", &query->limit, &fields) == 1 &&
+        query->limit > 0) {
+        const char *text = line + 1 + fields;
+        while (text < line_end && (*text == ' ' || *text == '\t')) text++;
+        if (text < line_end) {
+            char *copy = copy_query_text(text, line_end);
+            if (!copy) snprintf(error, error_size, "falta de memória");
+            query->ranked = copy ? parse_ranked_query(copy, error, error_size) : NULL;
+            free(copy);
+            if (!query->ranked) {
+                *problem = "consulta ranqueada inválida";
+                return 0;
+            }
+            query->type = QUERY_RANKED;
+            query->raw = text;
+            query->raw_length = (int)(line_end - text);
+            return 1;
+        }
+    }
+    if (buffer[0] == 'c' && separated && sscanf(buffer + 1, "%d %d", &query->min_freq, &query->max_freq) == 2) {
+        query->type = QUERY_FREQ_COUNT;
+        return 1;
+    }
+    return 0;
+}
+
+// Parses the query text in place; malformed lines are reported and skipped
+static BatchQuery* parse_batch_queries(const char *data, size_t size, int *count) {
+    int capacity = 1024;
+    BatchQuery *queries = (BatchQuery *)malloc(capacity * sizeof(BatchQuery));
+    if (!queries) return NULL;
+    *count = 0;
+
+    const char *line = data, *end = data + size;
+    int line_num = 0;
+    while (line < end) {
+        const char *newline = (const char *)memchr(line, '\n', end - line);
+        const char *line_end = newline ? newline : end;
+        const char *next = newline ? newline + 1 : end;
+        line_num++;
+
+        if (*count == capacity) {
+            capacity *= 2;
+            BatchQuery *grown = (BatchQuery *)realloc(queries, capacity * sizeof(BatchQuery));
+            if (!grown) {
+                free_batch_queries(queries, *count);
+                return NULL;
+            }
+            queries = grown;
+        }
+
+        const char *problem;
+        char error[MAX_QUERY_WORD + 64];
+        const int parsed = parse_batch_line(line, line_end, &queries[*count], &problem, error, sizeof(error));
+        if (parsed > 0) {
+            (*count)++;
+        } else if (parsed == 0 && error[0]) {
+            fprintf(stderr, "Aviso: %s na linha %d (%s), pulando.\n", problem, line_num, error);
+        } else if (parsed == 0) {
+            fprintf(stderr, "Aviso: %s na linha %d, pulando.\n", problem, line_num);
+        }
+        line = next;
+    }
+    return queries;
+}
+
+// Starts timing a query and, with 'perf', counting it. The counters run inside the timed
+// interval, so the counts leave the clock out and the times include the two ioctl calls.
+static double begin_query(PerfCounters *perf) {
+    const double start = wall_clock_ms();
+    if (perf) perf_start(perf);
+    return start;
+}
+
+// Milliseconds since begin_query; the counts are added to 'sample'
+static double end_query(PerfCounters *perf, PerfSample *sample, double start) {
+    if (perf) perf_stop(perf, sample);
+    return wall_clock_ms() - start;
+}
+
+// Runs one parsed query and writes its result line to 'out' (if not NULL). Returns the time
+// the query took without its output, in milliseconds, or -1 if its results did not fit in
+// memory (an error line is written instead). With 'perf', the hardware counts of the query,
+// also without its output, are added to 'sample'.
+static double execute_batch_query(const QueryIndex *index, QueryStructure structure, const BatchQuery *query,
+                                  QueryBuffers *buffers, FILE *out, PerfCounters *perf, PerfSample *sample) {
+    if (!reserve_query_buffers(buffers, query)) {
+        fprintf(stderr, "Aviso: falta de memória para os resultados de uma consulta.\n");
+        if (out) fprintf(out, "e\tfalta de memória\n");
+        return -1.0;
+    }
+    double elapsed;
+    if (query->type == QUERY_WORD) {
+        WordInfo view;
+        const double query_start = begin_query(perf);
+        const WordInfo *info = query->word ? lookup_word(index, structure, query->word, &view) : NULL;
+        elapsed = end_query(perf, sample, query_start);
+        if (out) {
+            // word, frequency, number of distinct quotes
+            fprintf(out, "w\t%.*s\t%d\t%d\n", query->raw_length, query->raw, info ? info->frequency : 0,
+                    info ? info->postings.quote_count : 0);
+        }
+    } else if (query->type == QUERY_TOP_K) {
+        TopKEntry *top = buffers->top;
+        const double query_start = begin_query(perf);
+        const int found = top_k_words(index, query->limit, &query->filter, top);
+        elapsed = end_query(perf, sample, query_start);
+        if (out) {
+            // K, number of words, word:frequency separated by commas
+            fprintf(out, "t\t%d\t%d\t", query->limit, found);
+            for (int w = 0; w < found; w++) {
+                fprintf(out, w ? ",%s:%d" : "%s:%d", top[w].word, top[w].frequency);
+            }
+            fputc('\n', out);
+        }
+    } else if (query->type == QUERY_PREFIX) {
+        TopKEntry *top = buffers->top;
+        int total = 0;
+        const double query_start = begin_query(perf);
+        const int found = query->word ? complete_prefix(index, structure, query->word, query->limit, top, &total) : 0;
+        elapsed = end_query(perf, sample, query_start);
+        if (out) {
+            // prefix, number of words with it, word:frequency separated by commas
+            fprintf(out, "p\t%.*s\t%d\t", query->raw_length, query->raw, total);
+            for (int w = 0; w < found; w++) {
+                fprintf(out, w ? ",%s:%d" : "%s:%d", top[w].word, top[w].frequency);
+            }
+            fputc('\n', out);
+        }
+    } else if (query->type == QUERY_FUZZY) {
+        FuzzyEntry *fuzzy = buffers->fuzzy;
+        int total = 0;
+        const double query_start = begin_query(perf);
+        const int found = query->word ? fuzzy_lookup(index, structure, query->word, query->max_distance,
+                                                     query->limit, fuzzy, &total, NULL) : 0;
+        elapsed = end_query(perf, sample, query_start);
+        if (found < 0) {
+            fprintf(stderr, "Aviso: falta de memória na busca aproximada '%.*s'.\n", query->raw_length, query->raw);
+        }
+        if (out) {
+            // word, number of words in range, word:distance:frequency separated by commas
+            fprintf(out, "a\t%.*s\t%d\t", query->raw_length, query->raw, found >= 0 ? total : 0);
+            for (int w = 0; w < found; w++) {
+                fprintf(out, w ? ",%s:%d:%d" : "%s:%d:%d", fuzzy[w].word, fuzzy[w].distance, fuzzy[w].frequency);
+            }
+            fputc('\n', out);
+        }
+    } else if (query->type == QUERY_RANKED) {
+        RankedQuote *ranked = buffers->ranked;
+        const double query_start = begin_query(perf);
+        const int found = rank_quotes(index, query->ranked, query->limit, 1, ranked, NULL);
+        elapsed = end_query(perf, sample, query_start);
+        if (found < 0) {
+            fprintf(stderr, "Aviso: falta de memória na consulta ranqueada '%.*s'.\n", query->raw_length, query->raw);
+        }
+        if (out) {
+            // K, query, number of quotes, quote_id:score separated by commas, best first
+            fprintf(out, "r\t%d\t%.*s\t%d\t", query->limit, query->raw_length, query->raw, found > 0 ? found : 0);
+            for (int q = 0; q < found; q++) {
+                fprintf(out, q ? ",%d:%.4f" : "%d:%.4f", ranked[q].quote_id, ranked[q].score);
+            }
+            fputc('\n', out);
+        }
+    } else if (query->type == QUERY_BOOLEAN) {
+        int *ids = NULL;
+        const double query_start = begin_query(perf);
+        const int found = evaluate_boolean_query(index, query->boolean, &ids);
+        elapsed = end_query(perf, sample, query_start);
+        if (found < 0) {
+            fprintf(stderr, "Aviso: falta de memória na consulta booleana '%.*s'.\n", query->raw_length, query->raw);
+        }
+        if (out) {
+            // query, number of quotes, quote IDs separated by commas
+            fprintf(out, "b\t%.*s\t%d\t", query->raw_length, query->raw, found > 0 ? found : 0);
+            for (int q = 0; q < found; q++) {
+                fprintf(out, q ? ",%d" : "%d", ids[q]);
+            }
+            fputc('\n', out);
+        }
+        free(ids);
+    } else if (query->type == QUERY_PHRASE) {
+        int *ids = NULL;
+        const double query_start = begin_query(perf);
+        const int found = index->positions ? evaluate_phrase_query(index, query->phrase, &ids) : 0;
+        elapsed = end_query(perf, sample, query_start);
+        if (index->positions && found < 0) {
+            fprintf(stderr, "Aviso: falta de memória na frase '%.*s'.\n", query->raw_length, query->raw);
+        }
+        if (out) {
+            // phrase, number of quotes, quote IDs separated by commas
+            fprintf(out, "s\t%.*s\t%d\t", query->raw_length, query->raw, found > 0 ? found : 0);
+            for (int q = 0; q < found; q++) {
+                fprintf(out, q ? ",%d" : "%d", ids[q]);
+            }
+            fputc('\n', out);
+        }
+        free(ids);
+    } else if (query->type == QUERY_FREQ_COUNT) {
+        const double query_start = begin_query(perf);
+        const int total = count_freq_range(index, query->min_freq, query->max_freq);
+        elapsed = end_query(perf, sample, query_start);
+        if (out) fprintf(out, "c\t%d\t%d\t%d\n", query->min_freq, query->max_freq, total);
+    } else if (query->limit < 0) {
+        buffers->range_count = 0;
+        const double query_start = begin_query(perf);
+        visit_freq_range(index, query->min_freq, query->max_freq, collect_range_word, buffers);
+        elapsed = end_query(perf, sample, query_start);
+        if (out) {
+            // min, max, number of words, the words separated by commas
+            fprintf(out, "f\t%d\t%d\t%d\t", query->min_freq, query->max_freq, buffers->range_count);
+            for (int w = 0; w < buffers->range_count; w++) {
+                if (w) fputc(',', out);
+                fputs(buffers->range_words[w], out);
+            }
+            fputc('\n', out);
+        }
+    } else {
+        WordInfo *page = buffers->page;
+        const double query_start = begin_query(perf);
+        const int total = count_freq_range(index, query->min_freq, query->max_freq);
+        const int found = page_freq_range(index, query->min_freq, query->max_freq, query->offset, page,
+                                          query->limit);
+        elapsed = end_query(perf, sample, query_start);
+        if (out) {
+            // Same columns as a whole range; the count is the size of the whole range
+            fprintf(out, "f\t%d\t%d\t%d\t", query->min_freq, query->max_freq, total);
+            for (int w = 0; w < found; w++) {
+                if (w) fputc(',', out);
+                fputs(page[w].word, out);
+            }
+            fputc('\n', out);
+        }
+    }
+    return elapsed;
+}
+
+int answer_query_line(const QueryIndex *index, QueryStructure structure, const char *line, size_t length,
+                      QueryBuffers *buffers, FILE *out) {
+    BatchQuery query;
+    const char *problem;
+    char error[MAX_QUERY_WORD + 64];
+    const char *line_end = line + length;
+    if (line_end > line && line_end[-1] == '\n') line_end--;
+    const int parsed = parse_batch_line(line, line_end, &query, &problem, error, sizeof(error));
+    if (parsed > 0 && query.type == QUERY_PHRASE && !index->positions) {
+        // Batch mode warns once in its summary; a client only sees its answer, where 0 quotes
+        // would read as a phrase no quote has
+        fprintf(out, "e\tíndice sem as posições das palavras (use --positions)\n");
+    } else if (parsed > 0) {
+        execute_batch_query(index, structure, &query, buffers, out, NULL, NULL);
+    } else if (parsed == 0 && error[0]) {
+        fprintf(out, "e\t%s (%s)\n", problem, error);
+    } else if (parsed == 0) {
+        fprintf(out, "e\t%s\n", problem);
+    }
+    free_batch_query(&query);
+    return parsed;
+}
+
+static void report_latencies(const char *label, double *latencies, int count) {
+    if (count == 0) return;
+    qsort(latencies, count, sizeof(double), compare_doubles);
+    fprintf(stderr, "%-12s %10d %12.3f %12.3f %12.3f %12.3f\n", label, count,
+            percentile(latencies, count, 0.50) * 1000.0, percentile(latencies, count, 0.99) * 1000.0,
+            percentile(latencies, count, 0.999) * 1000.0, latencies[count - 1] * 1000.0);
+}
+
+
+// Hardware counts per query of each kind and of all of them, on standard error
+static void report_perf_rows(QueryStructure structure, const PerfSample *row_perf) {
+    PerfSample all;
+    memset(&all, 0, sizeof(all));
+    for (int r = 0; r < LATENCY_ROW_COUNT; r++) {
+        if (row_perf[r].runs == 0) continue;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) all.counts[e] += row_perf[r].counts[e];
+        all.valid = all.runs == 0 ? row_perf[r].valid : all.valid & row_perf[r].valid;
+        all.runs += row_perf[r].runs;
+    }
+    fprintf(stderr, "\n--- Contadores de hardware por consulta (estrutura: %s) ---\n", query_structure_name(structure));
+    print_perf_header(stderr, "Consultas");
+    print_perf_row(stderr, "todas", &all, (double)all.runs);
+    for (int r = 0; r < LATENCY_ROW_COUNT; r++) {
+        if (row_perf[r].runs > 0) print_perf_row(stderr, latency_labels[r], &row_perf[r], (double)row_perf[r].runs);
+    }
+}
+
+int run_batch_queries(const QueryIndex *index, const BatchOptions *options) {
+    const char *query_file = options->query_file && strcmp(options->query_file, "-") != 0 ? options->query_file
+                                                                                          : "/dev/stdin";
+    MappedFile input;
+    if (!map_file(query_file, &input)) return 0;
+
+    int query_count = 0;
+    BatchQuery *queries = parse_batch_queries(input.data, input.size, &query_count);
+    double *latencies = (double *)malloc((query_count ? query_count : 1) * (LATENCY_ROW_COUNT + 1) * sizeof(double));
+    if (!queries || !latencies) {
+        perror("Falha ao alocar as consultas");
+        free_batch_queries(queries, query_count);
+        free(latencies);
+        unmap_file(&input);
+        return 0;
+    }
+    // All the latencies first, then one row per kind of query
+    double *row_latencies[LATENCY_ROW_COUNT];
+    int row_counts[LATENCY_ROW_COUNT] = {0};
+    for (int r = 0; r < LATENCY_ROW_COUNT; r++) row_latencies[r] = latencies + (r + 1) * query_count;
+    int timed_count = 0, phrase_unavailable = 0;
+
+    FILE *out = NULL;
+    if (options->write_results) {
+        out = options->output_file ? fopen(options->output_file, "w") : stdout;
+        if (!out) {
+            perror("Falha ao abrir o arquivo de resultados");
+            free_batch_queries(queries, query_count);
+            free(latencies);
+            unmap_file(&input);
+            return 0;
+        }
+        setvbuf(out, NULL, _IOFBF, BATCH_OUTPUT_BUFFER);
+    }
+
+    QueryBuffers buffers;
+    memset(&buffers, 0, sizeof(buffers));
+    PerfCounters perf_counters;
+    PerfCounters *perf = options->perf_counters && open_perf_counters(&perf_counters, 0) > 0 ? &perf_counters : NULL;
+    PerfSample row_perf[LATENCY_ROW_COUNT];
+    memset(row_perf, 0, sizeof(row_perf));
+    const double start = wall_clock_ms();
+    for (int i = 0; i < query_count; i++) {
+        const BatchQuery *query = &queries[i];
+        const int row = latency_rows[query->type];
+        const double elapsed = execute_batch_query(index, options->structure, query, &buffers, out, perf,
+                                                   &row_perf[row]);
+        if (elapsed < 0) continue;
+        latencies[timed_count++] = row_latencies[row][row_counts[row]++] = elapsed;
+        if (query->type == QUERY_PHRASE && !index->positions) phrase_unavailable++;
+    }
+    if (out) fflush(out);
+    const double total = wall_clock_ms() - start;
+
+    if (buffers.range_failed) {
+        fprintf(stderr, "Aviso: falta de memória ao juntar resultados de intervalos; alguns estão incompletos.\n");
+    }
+    if (phrase_unavailable) {
+        fprintf(stderr, "Aviso: o índice não tem as posições das palavras (use --positions); %d frase%s sem resultado.\n",
+                phrase_unavailable, phrase_unavailable > 1 ? "s ficaram" : " ficou");
+    }
+    fprintf(stderr, "\n--- Consultas em lote (estrutura: %s) ---\n", query_structure_name(options->structure));
+    fprintf(stderr, "Consultas: %d (%d palavras, %d intervalos, %d top-K, %d prefixos, %d booleanas, %d frases, "
+                    "%d aproximadas, %d ranqueadas) em %.3f ms: %.0f consultas/s%s\n", query_count, row_counts[0],
+            row_counts[1], row_counts[2], row_counts[3], row_counts[4], row_counts[5], row_counts[6], row_counts[7],
+            total, total > 0 ? query_count / (total / 1000.0) : 0.0, out ? "" : " (sem saída)");
+    fprintf(stderr, "%-12s %10s %12s %12s %12s %12s\n", "Latência", "Consultas", "p50 (us)", "p99 (us)", "p999 (us)",
+            "máx (us)");
+    report_latencies("todas", latencies, timed_count);
+    for (int r = 0; r < LATENCY_ROW_COUNT; r++) {
+        report_latencies(latency_labels[r], row_latencies[r], row_counts[r]);
+    }
+    if (perf) {
+        close_perf_counters(perf);
+        report_perf_rows(options->structure, row_perf);
+    }
+
+    int ok = 1;
+    if (out && out != stdout && fclose(out) != 0) {
+        perror("Falha ao gravar os resultados");
+        ok = 0;
+    }
+    free_batch_queries(queries, query_count);
+    free(latencies);
+    free_query_buffers(&buffers);
+    unmap_file(&input);
+    return ok;
+}
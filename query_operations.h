@@ -0,0 +1,167 @@
+#ifndef QUERY_OPERATIONS_H
+#define QUERY_OPERATIONS_H
+
+#include <stdio.h>
+#include "structures.h"
+#include "perf_counters.h"
+#include "index_snapshot.h"
+
+// Structure that answers word lookups
+typedef enum QueryStructure {
+  QUERY_VECTOR,
+  QUERY_EYTZINGER,
+  QUERY_BST,
+  QUERY_AVL,
+  QUERY_HASH,
+  QUERY_RADIX,
+  QUERY_SNAPSHOT,
+  QUERY_STRUCTURE_COUNT
+} QueryStructure;
+
+// Read-only view of the loaded index. Either the in-memory structures are set or,
+// when the index was opened from a snapshot, only 'snapshot'.
+typedef struct QueryIndex {
+  const WordVector *vector;
+  const EytzingerIndex *eytzinger;
+  BSTNode *bst;
+  AVLNode *avl;
+  const HashIndex *hash;
+  const RadixNode *radix;
+  const FreqAVLNode *freq_avl;
+  const FreqOrder *freq_order;
+  const QuotePool *pool;          // Quotes of the index, for the year filter of top-K queries
+  const YearCounts *year_counts;  // Speeds up the year filter; NULL reads the postings instead
+  const QuoteIdLists *quote_ids;  // Speeds up boolean queries; NULL decodes the postings instead
+  int positions;                  // 1 if the words carry token positions, which phrase queries need
+  const IndexSnapshot *snapshot;  // NULL unless the index is a snapshot
+} QueryIndex;
+
+// Optional filters of a top-K query
+typedef struct TopKFilter {
+  int min_length;   // Only words with at least this many letters (0 = any length)
+  int min_year;     // Only occurrences in quotes from [min_year, max_year];
+  int max_year;     // the year filter is off when max_year is 0
+} TopKFilter;
+
+// A word of a top-K result, with its frequency under the filters
+typedef struct TopKEntry {
+  const char *word; // Points into the index (arena or mapped snapshot)
+  int frequency;
+} TopKEntry;
+
+// A word of a fuzzy lookup result
+typedef struct FuzzyEntry {
+  const char *word; // Points into the index (arena or mapped snapshot)
+  int frequency;
+  int distance;     // Edit distance from the query
+} FuzzyEntry;
+
+// Result arrays of one thread answering queries, grown as its queries ask for more.
+// Start from all zeros; free_query_buffers releases them.
+typedef struct QueryBuffers {
+  WordInfo *page;              // One page of a frequency range
+  int page_capacity;
+  TopKEntry *top;              // Top-K and prefix results
+  int top_capacity;
+  FuzzyEntry *fuzzy;
+  int fuzzy_capacity;
+  struct RankedQuote *ranked;
+  int ranked_capacity;
+  const char **range_words;    // Words of a whole frequency range
+  int range_count;
+  int range_capacity;
+  int range_failed;            // Set when a range lost words to an allocation failure
+} QueryBuffers;
+
+// Options of the batch query mode
+typedef struct BatchOptions {
+  const char *query_file;     // NULL or "-" reads the queries from stdin
+  const char *output_file;    // NULL writes the results to stdout
+  int write_results;          // 0 runs the queries without writing anything
+  QueryStructure structure;
+  int perf_counters;          // Also counts cycles, instructions, cache and branch misses per kind of query
+} BatchOptions;
+
+// Returns the structure named 'name' (e.g. "avl"), or -1 if there is none.
+int parse_query_structure(const char *name);
+
+// Returns the name parse_query_structure accepts for a structure.
+const char* query_structure_name(QueryStructure structure);
+
+// Looks the normalized word up in the chosen structure. Snapshot results are written to
+// *view, which must outlive the returned pointer. Returns NULL if the word is absent or the
+// structure is not loaded.
+const WordInfo* lookup_word(const QueryIndex *index, QueryStructure structure, const char *word, WordInfo *view);
+
+// Calls 'visit' for every word with frequency in [min_freq, max_freq], by increasing frequency.
+// Uses the frequency AVL, or the frequency order of the snapshot.
+void visit_freq_range(const QueryIndex *index, int min_freq, int max_freq, WordVisitor visit, void *context);
+
+// Counts the words with frequency in [min_freq, max_freq] in O(log n), without visiting them.
+int count_freq_range(const QueryIndex *index, int min_freq, int max_freq);
+
+// Copies results offset..offset+capacity-1 of the frequency range into 'out', in (frequency, word)
+// order. Returns the number of words copied.
+int page_freq_range(const QueryIndex *index, int min_freq, int max_freq, int offset, WordInfo *out, int capacity);
+
+// Counts the occurrences of every word per year, in the frequency order of the index.
+// Returns 1 on success, 0 on allocation failure or if the years span too many values.
+int build_year_counts(YearCounts *counts, const QueryIndex *index);
+
+// Frees the arrays of the year counts.
+void free_year_counts(YearCounts *counts);
+
+// Writes the k most frequent words that pass the filter (NULL = none) into 'out', most frequent
+// first, ties in word order. Candidates are read from the precomputed frequency order, most
+// frequent first, through a bounded heap of k entries; with a year filter a word's frequency
+// only counts quotes from those years (read from the year counts when the index has them), and
+// the scan stops once no remaining word can enter the heap. Returns the number of words written.
+int top_k_words(const QueryIndex *index, int k, const TopKFilter *filter, TopKEntry *out);
+
+// Writes the 'limit' most frequent words that start with the normalized prefix into 'out', most
+// frequent first, ties in word order. QUERY_RADIX opens the radix tree best-first by the cached
+// subtree maxima; any other structure scans the prefix range of the sorted vector (or of the
+// snapshot), the baseline it is measured against. *total (if not NULL) receives the number of words
+// with the prefix. Returns the number of words written, or -1 on allocation failure.
+int complete_prefix(const QueryIndex *index, QueryStructure structure, const char *prefix, int limit,
+                    TopKEntry *out, int *total);
+
+// Writes the 'limit' words closest to the normalized word, within Levenshtein distance max_distance,
+// into 'out': nearest first, then most frequent, then in word order. QUERY_RADIX walks the radix tree
+// with one edit distance row per edge character, leaving the subtrees that cannot match; any other
+// structure computes the distance to every word of the sorted vector (or of the snapshot), the
+// baseline it is measured against. *total (if not NULL) receives the number of words in range and
+// *examined (if not NULL) the radix nodes visited or the words compared. Returns the number of
+// words written, or -1 on allocation failure.
+int fuzzy_lookup(const QueryIndex *index, QueryStructure structure, const char *word, int max_distance, int limit,
+                 FuzzyEntry *out, int *total, long *examined);
+
+// Runs a file of queries against the index, one per line:
+//   w WORD        word lookup
+//   f MIN MAX     frequency range
+//   f MIN MAX OFFSET LIMIT   one page of a frequency range
+//   c MIN MAX     number of words in a frequency range
+//   t K [MIN_LENGTH [MIN_YEAR MAX_YEAR]]   the K most frequent words
+//   p PREFIX [N]  the N (default 10) most frequent words starting with PREFIX
+//   b QUERY       quotes matching words joined by AND, OR, NOT and parentheses
+//   s PHRASE      quotes containing the exact phrase (needs an index loaded with positions)
+//   a WORD [K [N]]  the N (default 10) nearest words within edit distance K (1 or 2, default 2)
+//   r K QUERY     the K quotes ranked highest by BM25 for the words of QUERY
+// Blank lines and lines starting with '#' are skipped. Results are written as TSV through a
+// large buffer, and the throughput and p50/p99/p999 latencies are reported on stderr.
+// Returns 1 on success.
+int run_batch_queries(const QueryIndex *index, const BatchOptions *options);
+
+// Answers one line of the query language of run_batch_queries ('length' may include the
+// newline) and writes its TSV result line to 'out'; a malformed line, or a phrase when the
+// index has no positions, gets "e\t<reason>" instead. Threads may answer lines against the
+// same index at once, each with its own buffers.
+// Returns 1 if the line was a query, 0 if it was malformed, -1 if it is blank or a comment
+// (nothing is written).
+int answer_query_line(const QueryIndex *index, QueryStructure structure, const char *line, size_t length,
+                      QueryBuffers *buffers, FILE *out);
+
+// Frees the arrays of the buffers.
+void free_query_buffers(QueryBuffers *buffers);
+
+#endif // QUERY_OPERATIONS_H
@@ -0,0 +1,504 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "query_server.h"
+#include "utils.h"
+
+#define MAX_SERVER_WORKERS 256
+#define CONNECTION_READ_SIZE (4 * 1024)  // Input buffer of a new connection, doubled up to MAX_REQUEST_LINE
+#define MAX_REQUEST_LINE (64 * 1024)    // Longer lines close the connection
+#define READS_PER_TURN 16               // Reads one worker makes for a connection before yielding it
+#define RESPONSE_BUFFER (256 * 1024)   // Answers a worker gathers before it leaves the epoch to send them
+
+// A client connection; only the worker holding it or the dispatcher touches it
+typedef struct Connection {
+    int fd;
+    FILE *out;                 // Answers not sent yet, gathered in 'output' (open_memstream)
+    char *output;
+    size_t output_size;
+    char *input;               // Bytes received but not answered yet: the start of an incomplete line
+    size_t used;
+    size_t capacity;
+    struct Connection *next;   // Link in the work queue or in the returned list
+} Connection;
+
+typedef struct Server {
+    EngineHandle *engines;
+    QueryStructure structure;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    Connection *queue_head;    // Readable connections waiting for a worker
+    Connection *queue_tail;
+    Connection *returned;      // Connections the workers are done with, for the dispatcher to watch again
+    int stopping;
+    int wake_write;            // Wakes the dispatcher out of poll()
+    const ServerOptions *options;
+    pthread_t reload_thread;
+    int reload_running;        // A reload thread was started and not joined yet
+    int reload_finished;       // ... and it is done, set under the lock
+    long reloads;
+} Server;
+
+typedef struct ServerWorker {
+    Server *server;
+    pthread_t thread;
+    QueryBuffers buffers;
+    int reader;                // Reader slot in the engine handle
+    long requests;
+    long turns;
+} ServerWorker;
+
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t reload_requested = 0;
+static int signal_wake_fd = -1;
+
+static void request_stop(int signal_number) {
+    if (signal_number == SIGHUP) reload_requested = 1;
+    else stop_requested = 1;
+    if (signal_wake_fd >= 0) {
+        const char byte = 0;
+        ssize_t ignored = write(signal_wake_fd, &byte, 1);
+        (void)ignored;
+    }
+}
+
+static Connection* open_connection(int fd) {
+    Connection *connection = (Connection *)calloc(1, sizeof(Connection));
+    char *input = (char *)malloc(CONNECTION_READ_SIZE);
+    FILE *out = connection && input ? open_memstream(&connection->output, &connection->output_size) : NULL;
+    if (!out) {
+        perror("Falha ao abrir a conexão");
+        free(connection);
+        free(input);
+        close(fd);
+        return NULL;
+    }
+    connection->fd = fd;
+    connection->out = out;
+    connection->input = input;
+    connection->capacity = CONNECTION_READ_SIZE;
+    return connection;
+}
+
+static void close_connection(Connection *connection) {
+    fclose(connection->out);
+    free(connection->output);
+    close(connection->fd);
+    free(connection->input);
+    free(connection);
+}
+
+// Sends the answers gathered so far. Blocks while the client does not read them, so it is
+// only called outside the epoch. Returns 0 if the client is gone.
+static int send_answers(Connection *connection) {
+    if (fflush(connection->out) != 0) return 0;
+    size_t sent = 0;
+    while (sent < connection->output_size) {
+        const ssize_t written = send(connection->fd, connection->output + sent, connection->output_size - sent, 0);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        sent += written;
+    }
+    rewind(connection->out);
+    return 1;
+}
+
+// Answers every complete line of the input and keeps the incomplete tail; at the end of the
+// stream the tail is a last line without newline. The answers are gathered in memory and
+// sent by the caller, outside the epoch: a client that stops reading blocks its worker but
+// never keeps an old engine from being freed. Past RESPONSE_BUFFER of answers the worker
+// leaves the epoch to send them and enters it again, so all the lines between two sends see
+// the same engine. Returns 0 if the client is gone.
+static int answer_lines(ServerWorker *worker, Connection *connection, int end_of_stream) {
+    Server *server = worker->server;
+    char *line = connection->input, *end = connection->input + connection->used;
+    int ok = 1, full = 1;
+    while (ok && full) {
+        const Engine *engine = enter_engine(server->engines, worker->reader);
+        const QueryIndex index = engine_query_index(engine);
+        // A reload may have turned a CSV into a snapshot or back
+        QueryStructure structure = server->structure;
+        if (engine->snapshot_open) structure = QUERY_SNAPSHOT;
+        else if (structure == QUERY_SNAPSHOT) structure = QUERY_VECTOR;
+        full = 0;
+        while (line < end) {
+            char *newline = (char *)memchr(line, '\n', end - line);
+            if (!newline && !end_of_stream) break;
+            if (ftell(connection->out) >= RESPONSE_BUFFER) {
+                full = 1;
+                break;
+            }
+            char *next = newline ? newline + 1 : end;
+            if (answer_query_line(&index, structure, line, next - line, &worker->buffers, connection->out) >= 0) {
+                worker->requests++;
+            }
+            line = next;
+        }
+        leave_engine(server->engines, worker->reader);
+        if (full) ok = send_answers(connection);
+    }
+    connection->used = end - line;
+    memmove(connection->input, line, connection->used);
+    return ok;
+}
+
+// One turn of a worker on a readable connection. Returns 0 if the connection is over.
+static int serve_connection(ServerWorker *worker, Connection *connection) {
+    for (int reads = 0; reads < READS_PER_TURN; reads++) {
+        if (connection->used == connection->capacity) {
+            if (connection->capacity >= MAX_REQUEST_LINE) {
+                fprintf(connection->out, "e\tlinha maior que %d bytes\n", MAX_REQUEST_LINE);
+                send_answers(connection);
+                return 0;
+            }
+            char *grown = (char *)realloc(connection->input, connection->capacity * 2);
+            if (!grown) return 0;
+            connection->input = grown;
+            connection->capacity *= 2;
+        }
+        // The first read was announced by poll(); the others only take what has already arrived
+        const ssize_t received = recv(connection->fd, connection->input + connection->used,
+                                      connection->capacity - connection->used, reads ? MSG_DONTWAIT : 0);
+        if (received == 0) {
+            if (answer_lines(worker, connection, 1)) send_answers(connection);
+            return 0;
+        }
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            break;
+        }
+        connection->used += received;
+        if (!answer_lines(worker, connection, 0)) return 0;
+    }
+    return send_answers(connection);
+}
+
+static void* worker_main(void *arg) {
+    ServerWorker *worker = (ServerWorker *)arg;
+    Server *server = worker->server;
+    worker->reader = register_engine_reader(server->engines);
+    for (;;) {
+        pthread_mutex_lock(&server->lock);
+        while (!server->queue_head && !server->stopping) pthread_cond_wait(&server->ready, &server->lock);
+        Connection *connection = server->queue_head;
+        if (!connection) {
+            pthread_mutex_unlock(&server->lock);
+            unregister_engine_reader(server->engines, worker->reader);
+            return NULL;
+        }
+        server->queue_head = connection->next;
+        if (!server->queue_head) server->queue_tail = NULL;
+        pthread_mutex_unlock(&server->lock);
+
+        worker->turns++;
+        if (!serve_connection(worker, connection)) {
+            close_connection(connection);
+            continue;
+        }
+        pthread_mutex_lock(&server->lock);
+        connection->next = server->returned;
+        server->returned = connection;
+        pthread_mutex_unlock(&server->lock);
+        const char byte = 0;
+        ssize_t ignored = write(server->wake_write, &byte, 1);
+        (void)ignored;
+    }
+}
+
+// Builds the new engine while the workers keep answering with the current one, then swaps
+static void* reload_main(void *arg) {
+    Server *server = (Server *)arg;
+    const ServerOptions *options = server->options;
+    fprintf(stderr, "Recarregando '%s'...\n", options->reload_path);
+
+    EngineLoadReport report;
+    const double start = wall_clock_ms();
+    Engine *fresh = open_engine(options->reload_path, options->load_options, &report);
+    const double built = wall_clock_ms();
+    if (!fresh) {
+        fprintf(stderr, "Falha ao recarregar '%s'; o índice atual continua em uso.\n", options->reload_path);
+    } else {
+        const int quotes = fresh->pool.quote_count;
+        const long generation = publish_engine(server->engines, fresh);
+        const double swapped = wall_clock_ms();
+        reclaim_engines(server->engines, 1);
+        fprintf(stderr, "Índice recarregado (geração %ld, %d frases): montagem %.3f ms, troca %.1f us, "
+                        "anterior liberado após %.3f ms.\n", generation, quotes, built - start,
+                (swapped - built) * 1000.0, wall_clock_ms() - swapped);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    if (fresh) server->reloads++;
+    server->reload_finished = 1;
+    pthread_mutex_unlock(&server->lock);
+    const char byte = 0;
+    ssize_t ignored = write(server->wake_write, &byte, 1);
+    (void)ignored;
+    return NULL;
+}
+
+// Joins a finished reload and starts the one SIGHUP asked for, one at a time
+static void manage_reload(Server *server) {
+    pthread_mutex_lock(&server->lock);
+    const int finished = server->reload_running && server->reload_finished;
+    pthread_mutex_unlock(&server->lock);
+    if (finished) {
+        pthread_join(server->reload_thread, NULL);
+        server->reload_running = 0;
+    }
+    if (!reload_requested || server->reload_running) return;
+    reload_requested = 0;
+    if (!server->options->reload_path) {
+        fprintf(stderr, "SIGHUP ignorado: o servidor não tem um arquivo para recarregar.\n");
+        return;
+    }
+    server->reload_finished = 0;
+    if (pthread_create(&server->reload_thread, NULL, reload_main, server) != 0) {
+        perror("Falha ao iniciar a recarga");
+        return;
+    }
+    server->reload_running = 1;
+}
+
+// Listening socket at 'path'; a stale socket file left by an earlier server is replaced
+static int listen_on(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Caminho do socket longo demais: '%s'.\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    struct stat info;
+    if (lstat(path, &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            fprintf(stderr, "'%s' existe e não é um socket.\n", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("Falha ao criar o socket");
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror("Falha ao abrir o socket");
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+static int resolve_worker_count(int requested) {
+    int workers = requested;
+    if (workers <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (int)cpus : 1;
+    }
+    return workers > MAX_SERVER_WORKERS ? MAX_SERVER_WORKERS : workers;
+}
+
+// Idle connections, watched by the dispatcher
+typedef struct IdleSet {
+    Connection **connections;
+    struct pollfd *fds;        // fds[0] is the listening socket, fds[1] the wake pipe, then one per connection
+    int count;
+    int capacity;
+} IdleSet;
+
+static int add_idle(IdleSet *idle, Connection *connection) {
+    if (idle->count == idle->capacity) {
+        const int capacity = idle->capacity ? idle->capacity * 2 : 64;
+        Connection **connections = (Connection **)realloc(idle->connections, capacity * sizeof(Connection *));
+        if (connections) idle->connections = connections;
+        struct pollfd *fds = (struct pollfd *)realloc(idle->fds, (capacity + 2) * sizeof(struct pollfd));
+        if (fds) idle->fds = fds;
+        if (!connections || !fds) {
+            perror("Falha ao acompanhar a conexão");
+            close_connection(connection);
+            return 0;
+        }
+        idle->capacity = capacity;
+    }
+    idle->connections[idle->count++] = connection;
+    return 1;
+}
+
+int run_query_server(EngineHandle *engines, const ServerOptions *options) {
+    const int worker_count = resolve_worker_count(options->workers);
+
+    int wake[2];
+    if (pipe(wake) != 0) {
+        perror("Falha ao criar o pipe do servidor");
+        return 0;
+    }
+    fcntl(wake[0], F_SETFL, fcntl(wake[0], F_GETFL) | O_NONBLOCK);
+    fcntl(wake[1], F_SETFL, fcntl(wake[1], F_GETFL) | O_NONBLOCK);
+    const int listen_fd = listen_on(options->socket_path);
+    if (listen_fd < 0) {
+        close(wake[0]);
+        close(wake[1]);
+        return 0;
+    }
+
+    // A client that leaves before reading its answers must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+    stop_requested = 0;
+    reload_requested = 0;
+    signal_wake_fd = wake[1];
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.engines = engines;
+    server.options = options;
+    server.structure = options->structure;
+    server.wake_write = wake[1];
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.ready, NULL);
+
+    ServerWorker *workers = (ServerWorker *)calloc(worker_count, sizeof(ServerWorker));
+    IdleSet idle;
+    memset(&idle, 0, sizeof(idle));
+    idle.fds = (struct pollfd *)malloc(2 * sizeof(struct pollfd));
+    int started = 0;
+    for (int i = 0; workers && idle.fds && i < worker_count; i++) {
+        workers[i].server = &server;
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) break;
+        started++;
+    }
+    int ok = started == worker_count;
+    if (!ok) perror("Falha ao iniciar os workers do servidor");
+    else fprintf(stderr, "Servidor ouvindo em %s (%d worker%s, estrutura: %s). Ctrl+C encerra%s.\n",
+                 options->socket_path, worker_count, worker_count > 1 ? "s" : "",
+                 query_structure_name(options->structure), options->reload_path ? ", SIGHUP recarrega" : "");
+
+    long connections_served = 0;
+    const double start = wall_clock_ms();
+    while (ok && !stop_requested) {
+        idle.fds[0].fd = listen_fd;
+        idle.fds[0].events = POLLIN;
+        idle.fds[1].fd = wake[0];
+        idle.fds[1].events = POLLIN;
+        for (int c = 0; c < idle.count; c++) {
+            idle.fds[c + 2].fd = idle.connections[c]->fd;
+            idle.fds[c + 2].events = POLLIN;
+        }
+        const int polled = idle.count;
+        if (poll(idle.fds, polled + 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("Falha em poll()");
+            ok = 0;
+            break;
+        }
+
+        // Readable connections go to the workers, in the order poll() reports them
+        int kept = 0;
+        for (int c = 0; c < polled; c++) {
+            Connection *connection = idle.connections[c];
+            if (!(idle.fds[c + 2].revents & (POLLIN | POLLHUP | POLLERR))) {
+                idle.connections[kept++] = connection;
+                continue;
+            }
+            connection->next = NULL;
+            pthread_mutex_lock(&server.lock);
+            if (server.queue_tail) server.queue_tail->next = connection;
+            else server.queue_head = connection;
+            server.queue_tail = connection;
+            pthread_cond_signal(&server.ready);
+            pthread_mutex_unlock(&server.lock);
+        }
+        idle.count = kept;
+
+        if (idle.fds[1].revents & POLLIN) {
+            char drain[256];
+            while (read(wake[0], drain, sizeof(drain)) > 0) {}
+            manage_reload(&server);
+            pthread_mutex_lock(&server.lock);
+            Connection *returned = server.returned;
+            server.returned = NULL;
+            pthread_mutex_unlock(&server.lock);
+            while (returned) {
+                Connection *next = returned->next;
+                add_idle(&idle, returned);
+                returned = next;
+            }
+        }
+
+        if (idle.fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+                Connection *connection = open_connection(fd);
+                if (connection && add_idle(&idle, connection)) connections_served++;
+            }
+        }
+    }
+
+    // The workers finish the connections they hold and the ones queued, then stop
+    pthread_mutex_lock(&server.lock);
+    server.stopping = 1;
+    pthread_cond_broadcast(&server.ready);
+    pthread_mutex_unlock(&server.lock);
+    if (server.reload_running) {
+        fprintf(stderr, "Aguardando a recarga em andamento...\n");
+        pthread_join(server.reload_thread, NULL);
+    }
+    long requests = 0, turns = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        requests += workers[i].requests;
+        turns += workers[i].turns;
+        free_query_buffers(&workers[i].buffers);
+    }
+    const double elapsed = wall_clock_ms() - start;
+    signal_wake_fd = -1;
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGHUP, SIG_DFL);
+
+    while (server.returned) {
+        Connection *next = server.returned->next;
+        close_connection(server.returned);
+        server.returned = next;
+    }
+    for (int c = 0; c < idle.count; c++) close_connection(idle.connections[c]);
+    free(idle.connections);
+    free(idle.fds);
+    free(workers);
+    close(listen_fd);
+    unlink(options->socket_path);
+    close(wake[0]);
+    close(wake[1]);
+    pthread_cond_destroy(&server.ready);
+    pthread_mutex_destroy(&server.lock);
+
+    if (ok) {
+        fprintf(stderr, "\nServidor encerrado após %.1f s: %ld conexões, %ld consultas (%.1f por turno de worker), "
+                        "%ld recarga%s.\n", elapsed / 1000.0, connections_served, requests,
+                turns ? (double)requests / turns : 0.0, server.reloads, server.reloads == 1 ? "" : "s");
+    }
+    return ok;
+}
@@ -0,0 +1,30 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include "query_engine.h"
+#include "query_operations.h"
+
+#define DEFAULT_SERVER_SOCKET "/tmp/quote_analyzer.sock"
+
+// Settings of the query server (--serve)
+typedef struct ServerOptions {
+  const char *socket_path;    // Unix socket the server listens on
+  int workers;                // Threads answering queries (0 = one per processor)
+  QueryStructure structure;   // Answers the word lookups, prefixes and fuzzy words
+  const char *reload_path;    // CSV or snapshot loaded again on SIGHUP (NULL = no reload)
+  const LoadOptions *load_options; // Used by the reloads of a CSV
+} ServerOptions;
+
+// Serves the current engine of the handle over a Unix domain socket until SIGINT or SIGTERM.
+// Requests are lines of the batch query language and each gets its result line back, in
+// order, so a client may send many before reading (pipelining). One thread waits on every
+// idle connection with poll() and hands the readable ones to a fixed pool of workers; a worker
+// answers every complete line the connection has sent so far, flushes the answers in one
+// write and gives the connection back. The engine is only read, so the workers share it
+// without locks; each has its own result buffers and enters the engine's epoch around the lines
+// it answers. SIGHUP builds a new engine from options->reload_path on a background thread and
+// publishes it: queries keep being answered by the old engine until the swap, and it is freed
+// once the last worker using it leaves. Returns 1 after a clean shutdown.
+int run_query_server(EngineHandle *engines, const ServerOptions *options);
+
+#endif // QUERY_SERVER_H
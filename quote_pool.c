@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quote_pool.h"
+#include "hash_operations.h" // For hash_string
+#include "mapped_file.h"
+#include "mem_accounting.h"
+
+#define INITIAL_QUOTE_CAPACITY 1024
+#define INITIAL_MOVIE_CAPACITY 256
+
+// Initializes an empty QuotePool
+void init_quote_pool(QuotePool *pool, Arena *strings) {
+    memset(pool, 0, sizeof(*pool));
+    pool->strings = strings;
+}
+
+// Rebuilds the movie lookup table with twice as many slots
+static int grow_movie_slots(QuotePool *pool) {
+    int new_count = pool->movie_slot_count ? pool->movie_slot_count * 2 : INITIAL_MOVIE_CAPACITY * 2;
+    int *new_slots = (int *)mem_alloc(MEM_QUOTE_POOL, new_count * sizeof(int));
+    if (!new_slots) {
+        perror("Failed to allocate movie table");
+        return 0;
+    }
+    for (int i = 0; i < new_count; i++) {
+        new_slots[i] = -1;
+    }
+    for (int id = 0; id < pool->movie_count; id++) {
+        unsigned int slot = hash_string(pool->movies[id]) & (new_count - 1);
+        while (new_slots[slot] != -1) {
+            slot = (slot + 1) & (new_count - 1);
+        }
+        new_slots[slot] = id;
+    }
+    mem_free(pool->movie_slots);
+    pool->movie_slots = new_slots;
+    pool->movie_slot_count = new_count;
+    return 1;
+}
+
+// Returns the ID of the movie title, storing the title the first time it is seen.
+int intern_movie(QuotePool *pool, const char *movie, int length) {
+    // Keep the table at most half full
+    if ((pool->movie_count + 1) * 2 > pool->movie_slot_count && !grow_movie_slots(pool)) {
+        return -1;
+    }
+
+    unsigned int mask = pool->movie_slot_count - 1;
+    unsigned int slot = hash_bytes(movie, length) & mask;
+    while (pool->movie_slots[slot] != -1) {
+        const char *stored = pool->movies[pool->movie_slots[slot]];
+        if (strncmp(stored, movie, length) == 0 && stored[length] == '\0') {
+            return pool->movie_slots[slot]; // Already interned
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (pool->movie_count >= pool->movie_capacity) {
+        int new_capacity = pool->movie_capacity ? pool->movie_capacity * 2 : INITIAL_MOVIE_CAPACITY;
+        char **new_movies = (char **)mem_realloc(MEM_QUOTE_POOL, pool->movies, new_capacity * sizeof(char *));
+        if (!new_movies) {
+            perror("Failed to resize movie list");
+            return -1;
+        }
+        pool->movies = new_movies;
+        pool->movie_capacity = new_capacity;
+    }
+
+    char *copy = arena_strndup(pool->strings, movie, length);
+    if (!copy) {
+        perror("Failed to duplicate movie string");
+        return -1;
+    }
+    int id = pool->movie_count++;
+    pool->movies[id] = copy;
+    pool->movie_slots[slot] = id;
+    return id;
+}
+
+// Records a view of the quote and returns its ID.
+int add_quote(QuotePool *pool, const char *quote, int length, int movie_id, int year) {
+    if (pool->quote_count >= pool->quote_capacity) {
+        int new_capacity = pool->quote_capacity ? pool->quote_capacity * 2 : INITIAL_QUOTE_CAPACITY;
+        QuoteEntry *new_quotes = (QuoteEntry *)mem_realloc(MEM_QUOTE_POOL, pool->quotes,
+                                                           new_capacity * sizeof(QuoteEntry));
+        if (!new_quotes) {
+            perror("Failed to resize quote list");
+            return -1;
+        }
+        pool->quotes = new_quotes;
+        pool->quote_capacity = new_capacity;
+    }
+
+    int id = pool->quote_count++;
+    pool->quotes[id].text = quote;
+    pool->quotes[id].length = length;
+    pool->quotes[id].movie_id = movie_id;
+    pool->quotes[id].year = year;
+    pool->quotes[id].word_count = 0;
+    return id;
+}
+
+// Appends src's quotes to dst. Movies were interned in src in order of first
+// appearance, so interning them in ID order keeps dst's IDs in first-appearance order too.
+int merge_quote_pool(QuotePool *dst, const QuotePool *src, int *movie_map, int *quote_base) {
+    for (int id = 0; id < src->movie_count; id++) {
+        movie_map[id] = intern_movie(dst, src->movies[id], (int)strlen(src->movies[id]));
+        if (movie_map[id] < 0) return 0;
+    }
+
+    *quote_base = dst->quote_count;
+    if (dst->quote_count + src->quote_count > dst->quote_capacity) {
+        int new_capacity = dst->quote_capacity ? dst->quote_capacity : INITIAL_QUOTE_CAPACITY;
+        while (new_capacity < dst->quote_count + src->quote_count) {
+            new_capacity *= 2;
+        }
+        QuoteEntry *new_quotes = (QuoteEntry *)mem_realloc(MEM_QUOTE_POOL, dst->quotes,
+                                                           new_capacity * sizeof(QuoteEntry));
+        if (!new_quotes) {
+            perror("Failed to resize quote list");
+            return 0;
+        }
+        dst->quotes = new_quotes;
+        dst->quote_capacity = new_capacity;
+    }
+    for (int i = 0; i < src->quote_count; i++) {
+        QuoteEntry entry = src->quotes[i];
+        entry.movie_id = movie_map[entry.movie_id];
+        dst->quotes[dst->quote_count++] = entry;
+    }
+    dst->word_total += src->word_total;
+    return 1;
+}
+
+// The files are kept in a small array: one entry per append
+int attach_source_file(QuotePool *pool, MappedFile *file) {
+    MappedFile *files = (MappedFile *)mem_realloc(MEM_QUOTE_POOL, pool->appended,
+                                                   (pool->appended_count + 1) * sizeof(MappedFile));
+    if (!files) {
+        perror("Failed to resize appended file list");
+        return 0;
+    }
+    files[pool->appended_count++] = *file;
+    pool->appended = files;
+    memset(file, 0, sizeof(*file));
+    return 1;
+}
+
+// Frees the pool's lookup arrays, releases its files and resets it.
+void free_quote_pool(QuotePool *pool) {
+    if (!pool) return;
+    unmap_file(&pool->source);
+    for (int i = 0; i < pool->appended_count; i++) {
+        unmap_file(&pool->appended[i]);
+    }
+    mem_free(pool->appended);
+    mem_free(pool->quotes);
+    mem_free(pool->movies);
+    mem_free(pool->movie_slots);
+    init_quote_pool(pool, pool->strings);
+}
@@ -0,0 +1,32 @@
+#ifndef QUOTE_POOL_H
+#define QUOTE_POOL_H
+
+#include "structures.h"
+#include "arena.h"
+
+// Initializes an empty QuotePool whose movie titles are copied into the given arena
+void init_quote_pool(QuotePool *pool, Arena *strings);
+
+// Returns the ID of the 'length'-byte movie title, copying the title the first time it is seen.
+// Returns -1 on allocation failure.
+int intern_movie(QuotePool *pool, const char *movie, int length);
+
+// Records the quote without copying it and returns its ID, or -1 on allocation failure.
+// The text must point into one of the pool's files so it lives as long as the pool.
+// Its word count starts at 0; the loader sets it once the words are stored.
+int add_quote(QuotePool *pool, const char *quote, int length, int movie_id, int year);
+
+// Appends every quote of 'src' to 'dst', interning src's movies into dst in order of
+// their IDs. Fills movie_map[src movie ID] with dst movie IDs and *quote_base with the
+// dst ID of src's first quote. Returns 1 on success, 0 on allocation failure.
+int merge_quote_pool(QuotePool *dst, const QuotePool *src, int *movie_map, int *quote_base);
+
+// Moves an appended input file into the pool, which releases it with the source.
+// Returns 1 on success, 0 on allocation failure (the file is left to the caller).
+int attach_source_file(QuotePool *pool, MappedFile *file);
+
+// Frees the pool's lookup arrays, releases its source and appended files and resets it.
+// The movie titles are released with their arena.
+void free_quote_pool(QuotePool *pool);
+
+#endif // QUOTE_POOL_H
@@ -0,0 +1,445 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "radix_operations.h"
+
+#define INITIAL_CANDIDATE_CAPACITY 64
+
+static int max_radix(int a, int b) {
+    return (a > b) ? a : b;
+}
+
+// Child whose label starts with 'c', found through the packed first characters
+static RadixNode* find_radix_child(const RadixNode *node, char c) {
+    if (node->child_count == 0) return NULL;
+    const char *key = (const char *)memchr(node->keys, c, node->child_count);
+    return key ? &node->children[key - node->keys] : NULL;
+}
+
+// Children are kept in completion order: higher cached maximum frequency first, then lower first
+// character. The lookups scan 'keys' with memchr, so they do not depend on the order.
+static int child_ranks_before(int frequency_a, char key_a, int frequency_b, char key_b) {
+    if (frequency_a != frequency_b) return frequency_a > frequency_b;
+    return (unsigned char)key_a < (unsigned char)key_b;
+}
+
+// Puts the children built in character order into completion order
+static void sort_radix_children(RadixNode *node) {
+    for (int i = 1; i < node->child_count; i++) {
+        RadixNode child = node->children[i];
+        char key = node->keys[i];
+        int j = i;
+        while (j > 0 && child_ranks_before(child.max_frequency, key, node->children[j - 1].max_frequency,
+                                           node->keys[j - 1])) {
+            node->children[j] = node->children[j - 1];
+            node->keys[j] = node->keys[j - 1];
+            j--;
+        }
+        node->children[j] = child;
+        node->keys[j] = key;
+    }
+}
+
+// Raises the cached maximum of child 'i' to 'frequency' and moves it left past the siblings it
+// now ranks before. Returns the child's new place.
+static RadixNode* raise_radix_child(RadixNode *node, int i, int frequency) {
+    if (frequency <= node->children[i].max_frequency) return &node->children[i];
+    RadixNode child = node->children[i];
+    char key = node->keys[i];
+    child.max_frequency = frequency;
+    while (i > 0 && child_ranks_before(frequency, key, node->children[i - 1].max_frequency, node->keys[i - 1])) {
+        node->children[i] = node->children[i - 1];
+        node->keys[i] = node->keys[i - 1];
+        i--;
+    }
+    node->children[i] = child;
+    node->keys[i] = key;
+    return &node->children[i];
+}
+
+// --- Build Radix Tree ---
+
+// Fills 'node' with the words[low..high) subtree, whose first 'depth' characters the parent already matched.
+// The vector is sorted, so the prefix shared by the range is the one shared by its first and last words.
+static int build_radix_range(RadixNode *node, WordInfo **words, int low, int high, int depth, IndexArena *arena) {
+    const char *first = words[low]->word, *last = words[high - 1]->word;
+    int end = depth;
+    while (first[end] != '\0' && first[end] == last[end]) {
+        end++;
+    }
+
+    node->label = first + depth;
+    node->label_length = end - depth;
+    node->depth = end;
+    node->data = NULL;
+    node->children = NULL;
+    node->keys = NULL;
+    node->child_count = 0;
+    node->max_frequency = 0;
+    node->word_count = high - low;
+
+    int i = low;
+    if (first[end] == '\0') {
+        // Only the first word of the range can end here
+        node->data = words[low];
+        node->max_frequency = words[low]->frequency;
+        i++;
+    }
+
+    int groups = 0;
+    for (int j = i; j < high; groups++) {
+        char c = words[j]->word[end];
+        while (j < high && words[j]->word[end] == c) j++;
+    }
+    if (groups == 0) return 1;
+
+    node->children = (RadixNode *)arena_alloc(&arena->slabs[SLAB_RADIX], groups * sizeof(RadixNode));
+    node->keys = (char *)arena_alloc_bytes(&arena->slabs[SLAB_RADIX], groups);
+    if (!node->children || !node->keys) {
+        perror("Failed to allocate radix node");
+        return 0;
+    }
+    node->child_count = groups;
+
+    for (int g = 0, j = i; j < high; g++) {
+        char c = words[j]->word[end];
+        int k = j;
+        while (k < high && words[k]->word[end] == c) k++;
+        node->keys[g] = c;
+        if (!build_radix_range(&node->children[g], words, j, k, end, arena)) return 0;
+        node->max_frequency = max_radix(node->max_frequency, node->children[g].max_frequency);
+        j = k;
+    }
+    sort_radix_children(node);
+    return 1;
+}
+
+RadixNode* build_radix_from_sorted_vector(const WordVector *vec, IndexArena *arena) {
+    if (!vec || vec->size == 0) return NULL;
+
+    RadixNode *root = (RadixNode *)arena_alloc(&arena->slabs[SLAB_RADIX], sizeof(RadixNode));
+    if (!root) {
+        perror("Failed to allocate radix node");
+        return NULL;
+    }
+    return build_radix_range(root, vec->words, 0, vec->size, 0, arena) ? root : NULL;
+}
+
+// --- Radix Tree Insertion ---
+
+// Splits the edge into 'node' after 'at' label characters: the node keeps that part of the
+// label and its old contents move down into a single child
+static int split_radix_node(RadixNode *node, int at, IndexArena *arena) {
+    RadixNode *child = (RadixNode *)arena_alloc(&arena->slabs[SLAB_RADIX], sizeof(RadixNode));
+    char *key = (char *)arena_alloc_bytes(&arena->slabs[SLAB_RADIX], 1);
+    if (!child || !key) {
+        perror("Failed to allocate radix node");
+        return 0;
+    }
+    *child = *node;
+    child->label += at;
+    child->label_length -= at;
+    key[0] = child->label[0];
+
+    node->label_length = at;
+    node->depth = child->depth - child->label_length;
+    node->data = NULL;
+    node->children = child;
+    node->keys = key;
+    node->child_count = 1;
+    return 1; // The subtree is the same, so max_frequency and word_count stay
+}
+
+// Adds a leaf for the rest of the word to 'node', copying its children into a one larger array
+// with the leaf at its place in completion order. The old array is reclaimed with the arena.
+static int add_radix_leaf(RadixNode *node, WordInfo *wordInfo, IndexArena *arena) {
+    int count = node->child_count + 1;
+    RadixNode *children = (RadixNode *)arena_alloc(&arena->slabs[SLAB_RADIX], count * sizeof(RadixNode));
+    char *keys = (char *)arena_alloc_bytes(&arena->slabs[SLAB_RADIX], count);
+    if (!children || !keys) {
+        perror("Failed to allocate radix node");
+        return 0;
+    }
+
+    const char *rest = wordInfo->word + node->depth;
+    int position = 0;
+    while (position < node->child_count &&
+           child_ranks_before(node->children[position].max_frequency, node->keys[position], wordInfo->frequency,
+                              rest[0])) {
+        position++;
+    }
+    if (node->child_count > 0) {
+        memcpy(children, node->children, position * sizeof(RadixNode));
+        memcpy(children + position + 1, node->children + position,
+               (node->child_count - position) * sizeof(RadixNode));
+        memcpy(keys, node->keys, position);
+        memcpy(keys + position + 1, node->keys + position, node->child_count - position);
+    }
+
+    RadixNode *leaf = &children[position];
+    leaf->label = rest;
+    leaf->label_length = (int)strlen(rest);
+    leaf->depth = node->depth + leaf->label_length;
+    leaf->data = wordInfo;
+    leaf->children = NULL;
+    leaf->keys = NULL;
+    leaf->child_count = 0;
+    leaf->max_frequency = wordInfo->frequency;
+    leaf->word_count = 1;
+    keys[position] = rest[0];
+
+    node->children = children;
+    node->keys = keys;
+    node->child_count = count;
+    return 1;
+}
+
+int insert_radix(RadixNode **root, WordInfo *wordInfo, IndexArena *arena) {
+    const char *word = wordInfo->word;
+    if (*root == NULL) {
+        RadixNode *node = (RadixNode *)arena_alloc(&arena->slabs[SLAB_RADIX], sizeof(RadixNode));
+        if (!node) {
+            perror("Failed to allocate radix node");
+            return 0;
+        }
+        memset(node, 0, sizeof(*node));
+        node->label = word;
+        node->label_length = (int)strlen(word);
+        node->depth = node->label_length;
+        node->data = wordInfo;
+        node->max_frequency = wordInfo->frequency;
+        node->word_count = 1;
+        *root = node;
+        return 1;
+    }
+
+    RadixNode *parent = NULL, *node = *root;
+    int matched = 0; // Characters of the word matched above 'node'
+    for (;;) {
+        int j = 0;
+        while (j < node->label_length && word[matched + j] == node->label[j]) j++;
+        // Split before raising the maximum: the lower half does not get the new word
+        if (j < node->label_length && !split_radix_node(node, j, arena)) return 0;
+
+        node->word_count++;
+        if (parent) {
+            node = raise_radix_child(parent, (int)(node - parent->children), wordInfo->frequency);
+        } else {
+            node->max_frequency = max_radix(node->max_frequency, wordInfo->frequency);
+        }
+        matched = node->depth;
+        if (word[matched] == '\0') {
+            node->data = wordInfo;
+            return 1;
+        }
+
+        RadixNode *child = find_radix_child(node, word[matched]);
+        if (!child) return add_radix_leaf(node, wordInfo, arena);
+        parent = node;
+        node = child;
+    }
+}
+
+void update_radix_frequency(RadixNode *root, const WordInfo *wordInfo) {
+    const char *word = wordInfo->word;
+    RadixNode *node = root;
+    if (!node) return;
+    node->max_frequency = max_radix(node->max_frequency, wordInfo->frequency);
+    while (word[node->depth] != '\0') {
+        RadixNode *child = find_radix_child(node, word[node->depth]);
+        if (!child) return;
+        node = raise_radix_child(node, (int)(child - node->children), wordInfo->frequency);
+    }
+}
+
+// --- Radix Tree Search ---
+
+WordInfo* search_radix(const RadixNode *root, const char *word) {
+    const RadixNode *node = root;
+    int matched = 0;
+    while (node) {
+        // strncmp stops at the end of the word, so a word shorter than the label does not match
+        if (strncmp(node->label, word + matched, node->label_length) != 0) return NULL;
+        matched = node->depth;
+        if (word[matched] == '\0') return node->data;
+        node = find_radix_child(node, word[matched]);
+    }
+    return NULL;
+}
+
+// --- Completion ---
+
+// A subtree still to open, or a word ready to be listed
+typedef struct RadixCandidate {
+    const RadixNode *node;   // NULL for a word
+    const RadixNode *parent; // Parent of a subtree, whose next child enters when it leaves
+    int index;               // Place of the subtree among the parent's children
+    const WordInfo *word;
+    const char *text;        // Path of the subtree, or the word
+    int length;
+    int frequency;           // Highest frequency of the subtree, or the word's
+} RadixCandidate;
+
+// Higher frequency first, then lower text, and a subtree before a word with the same text.
+// A subtree's path is a prefix of all its words, so none of them can rank before its entry.
+static int radix_ranks_before(const RadixCandidate *a, const RadixCandidate *b) {
+    if (a->frequency != b->frequency) return a->frequency > b->frequency;
+    int length = a->length < b->length ? a->length : b->length;
+    int cmp = memcmp(a->text, b->text, length);
+    if (cmp != 0) return cmp < 0;
+    if (a->length != b->length) return a->length < b->length;
+    return a->node != NULL && b->node == NULL;
+}
+
+// Growable heap with the best candidate at the root
+typedef struct CandidateHeap {
+    RadixCandidate *items;
+    int count;
+    int capacity;
+} CandidateHeap;
+
+static int push_candidate(CandidateHeap *heap, RadixCandidate candidate) {
+    if (heap->count == heap->capacity) {
+        int new_capacity = heap->capacity ? heap->capacity * 2 : INITIAL_CANDIDATE_CAPACITY;
+        RadixCandidate *items = (RadixCandidate *)realloc(heap->items, new_capacity * sizeof(RadixCandidate));
+        if (!items) {
+            perror("Failed to grow completion heap");
+            return 0;
+        }
+        heap->items = items;
+        heap->capacity = new_capacity;
+    }
+    int i = heap->count++;
+    heap->items[i] = candidate;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!radix_ranks_before(&heap->items[i], &heap->items[parent])) break;
+        RadixCandidate tmp = heap->items[parent]; heap->items[parent] = heap->items[i]; heap->items[i] = tmp;
+        i = parent;
+    }
+    return 1;
+}
+
+static RadixCandidate pop_candidate(CandidateHeap *heap) {
+    RadixCandidate best = heap->items[0];
+    heap->items[0] = heap->items[--heap->count];
+    int i = 0;
+    for (;;) {
+        int first = i, left = 2 * i + 1, right = left + 1;
+        if (left < heap->count && radix_ranks_before(&heap->items[left], &heap->items[first])) first = left;
+        if (right < heap->count && radix_ranks_before(&heap->items[right], &heap->items[first])) first = right;
+        if (first == i) break;
+        RadixCandidate tmp = heap->items[first]; heap->items[first] = heap->items[i]; heap->items[i] = tmp;
+        i = first;
+    }
+    return best;
+}
+
+static RadixCandidate subtree_candidate(const RadixNode *parent, int index, const RadixNode *node) {
+    RadixCandidate candidate = { node, parent, index, NULL, node->label + node->label_length - node->depth,
+                                 node->depth, node->max_frequency };
+    return candidate;
+}
+
+int complete_radix(const RadixNode *root, const char *prefix, int limit, const WordInfo **out, int *total) {
+    // Walks down to the node whose subtree holds exactly the words with the prefix;
+    // the prefix may end in the middle of its label
+    const int prefix_length = (int)strlen(prefix);
+    const RadixNode *node = root;
+    int matched = 0;
+    while (node) {
+        int length = node->label_length < prefix_length - matched ? node->label_length : prefix_length - matched;
+        if (memcmp(node->label, prefix + matched, length) != 0) {
+            node = NULL;
+            break;
+        }
+        matched += length;
+        if (matched == prefix_length) break;
+        node = find_radix_child(node, prefix[matched]);
+    }
+    if (total) *total = node ? node->word_count : 0;
+    if (!node || limit <= 0) return 0;
+
+    CandidateHeap heap = { NULL, 0, 0 };
+    int count = 0, ok = push_candidate(&heap, subtree_candidate(NULL, 0, node));
+    while (ok && count < limit && heap.count > 0) {
+        RadixCandidate best = pop_candidate(&heap);
+        if (!best.node) {
+            out[count++] = best.word; // No candidate left can rank before it
+            continue;
+        }
+        // Siblings are in completion order, so each one only has to enter after the one before it
+        // and a subtree only needs its first child: at most three pushes per opened subtree
+        if (best.node->data) {
+            RadixCandidate word = { NULL, NULL, 0, best.node->data, best.node->data->word, best.node->depth,
+                                    best.node->data->frequency };
+            ok = push_candidate(&heap, word);
+        }
+        if (ok && best.node->child_count > 0) {
+            ok = push_candidate(&heap, subtree_candidate(best.node, 0, &best.node->children[0]));
+        }
+        if (ok && best.parent && best.index + 1 < best.parent->child_count) {
+            ok = push_candidate(&heap, subtree_candidate(best.parent, best.index + 1,
+                                                         &best.parent->children[best.index + 1]));
+        }
+    }
+    free(heap.items);
+    return ok ? count : -1;
+}
+
+// --- Fuzzy Search ---
+
+// State of a fuzzy search. Row d of the edit distance table, between the first d characters of
+// the path and each prefix of the query, is rows[d * (length + 1) ..].
+typedef struct FuzzyWalk {
+    const char *word;
+    int length;
+    int max_distance;
+    int *rows;
+    FuzzyVisitor visit;
+    void *context;
+    long visited;
+} FuzzyWalk;
+
+static void fuzzy_walk(FuzzyWalk *walk, const RadixNode *node) {
+    walk->visited++;
+    const int width = walk->length + 1;
+    const int start = node->depth - node->label_length;
+    for (int i = 0; i < node->label_length; i++) {
+        const int *previous = walk->rows + (start + i) * width;
+        int *row = walk->rows + (start + i + 1) * width;
+        const char c = node->label[i];
+        row[0] = previous[0] + 1;
+        int best = row[0];
+        for (int j = 1; j < width; j++) {
+            int cost = previous[j - 1] + (walk->word[j - 1] != c);
+            if (previous[j] + 1 < cost) cost = previous[j] + 1;
+            if (row[j - 1] + 1 < cost) cost = row[j - 1] + 1;
+            row[j] = cost;
+            if (cost < best) best = cost;
+        }
+        // The smallest entry of a row never decreases further down, so no word below can match
+        if (best > walk->max_distance) return;
+    }
+    const int distance = walk->rows[node->depth * width + walk->length];
+    if (node->data && distance <= walk->max_distance) walk->visit(node->data, distance, walk->context);
+    for (int c = 0; c < node->child_count; c++) {
+        fuzzy_walk(walk, &node->children[c]);
+    }
+}
+
+long fuzzy_radix(const RadixNode *root, const char *word, int max_distance, FuzzyVisitor visit, void *context) {
+    if (!root) return 0;
+    // Entry j of row d is at least |d - j|, so no row deeper than length + max_distance + 1 is computed
+    const int length = (int)strlen(word);
+    FuzzyWalk walk = { word, length, max_distance, NULL, visit, context, 0 };
+    walk.rows = (int *)malloc((size_t)(length + max_distance + 2) * (length + 1) * sizeof(int));
+    if (!walk.rows) {
+        perror("Failed to allocate fuzzy search");
+        return -1;
+    }
+    for (int j = 0; j <= length; j++) walk.rows[j] = j;
+    fuzzy_walk(&walk, root);
+    free(walk.rows);
+    return walk.visited;
+}
@@ -0,0 +1,35 @@
+#ifndef RADIX_OPERATIONS_H
+#define RADIX_OPERATIONS_H
+
+#include "structures.h"
+#include "arena.h"
+
+// Builds the radix tree over the sorted vector in O(total length of the words).
+// Does NOT duplicate WordInfo: labels are views into the words of the index.
+// Nodes are allocated from the Radix slab of the index arena. Returns NULL for an empty vector.
+RadixNode* build_radix_from_sorted_vector(const WordVector *vec, IndexArena *arena);
+
+// Inserts a word that is not in the tree yet, splitting the edge where it branches off.
+// Returns 1 on success, 0 on allocation failure.
+int insert_radix(RadixNode **root, WordInfo *wordInfo, IndexArena *arena);
+
+// Raises the cached maximum frequency along the path of a word whose frequency grew.
+void update_radix_frequency(RadixNode *root, const WordInfo *wordInfo);
+
+// Searches for a word in the radix tree.
+// Returns a pointer to the WordInfo if found, NULL otherwise.
+WordInfo* search_radix(const RadixNode *root, const char *word);
+
+// Writes the 'limit' most frequent words that start with 'prefix' into 'out', most frequent
+// first, ties in word order. Subtrees are opened best-first by their cached maximum frequency,
+// so only the ones that can still make the list are visited. *total (if not NULL) receives the
+// number of words with the prefix. Returns the number of words written, or -1 on allocation failure.
+int complete_radix(const RadixNode *root, const char *prefix, int limit, const WordInfo **out, int *total);
+
+// Calls 'visit' for every word within Levenshtein distance max_distance of 'word', in no
+// particular order. One row of the edit distance table is computed per label character on the
+// way down and shared by every word below it; a subtree is left as soon as its row has no entry
+// within max_distance. Returns the number of nodes visited, or -1 on allocation failure.
+long fuzzy_radix(const RadixNode *root, const char *word, int max_distance, FuzzyVisitor visit, void *context);
+
+#endif // RADIX_OPERATIONS_H
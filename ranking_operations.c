@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "ranking_operations.h"
+#include "boolean_operations.h"
+#include "array_operations.h"
+#include "posting_operations.h"
+#include "tokenizer.h"
+
+// --- Parsing ---
+
+RankedQuery* parse_ranked_query(const char *text, char *error, int error_size) {
+    const int length = (int)strlen(text);
+    char *scratch = (char *)malloc(length + TOKENIZER_SCRATCH_SLACK);
+    Token *tokens = (Token *)malloc((length / 4 + 1) * sizeof(Token));
+    RankedQuery *query = (RankedQuery *)calloc(1, sizeof(RankedQuery));
+    if (!scratch || !tokens || !query) {
+        snprintf(error, error_size, "falta de memória");
+        free(scratch);
+        free(tokens);
+        free(query);
+        return NULL;
+    }
+
+    const int count = tokenize_fold(text, length, scratch, tokens);
+    if (count == 0) {
+        snprintf(error, error_size, "a consulta não tem palavras com mais de 3 letras, as únicas indexadas");
+        free(scratch);
+        free(tokens);
+        free(query);
+        return NULL;
+    }
+
+    query->words = (char **)calloc(count, sizeof(char *));
+    int ok = query->words != NULL;
+    for (int t = 0; t < count && ok; t++) {
+        int same = 0;
+        while (same < query->word_count && (strlen(query->words[same]) != (size_t)tokens[t].length ||
+                                            memcmp(query->words[same], tokens[t].text, tokens[t].length) != 0)) {
+            same++;
+        }
+        if (same < query->word_count) continue;
+        char *word = (char *)malloc(tokens[t].length + 1);
+        if (!word) {
+            ok = 0;
+            break;
+        }
+        memcpy(word, tokens[t].text, tokens[t].length);
+        word[tokens[t].length] = '\0';
+        query->words[query->word_count++] = word;
+    }
+    free(scratch);
+    free(tokens);
+    if (!ok) {
+        snprintf(error, error_size, "falta de memória");
+        free_ranked_query(query);
+        return NULL;
+    }
+    return query;
+}
+
+void free_ranked_query(RankedQuery *query) {
+    if (!query) return;
+    for (int w = 0; w < query->word_count; w++) {
+        free(query->words[w]);
+    }
+    free(query->words);
+    free(query);
+}
+
+// --- Scoring ---
+
+// Walk over the quotes of one word, with what it can add to a quote
+typedef struct TermCursor {
+    const int *ids;
+    const int *counts;
+    int count;
+    int at;
+    int *owned;          // IDs and counts decoded from the postings (2 * count ints), or NULL
+    double idf;
+    double upper_bound;  // Highest score the word can add to a quote
+} TermCursor;
+
+// BM25 weight of a word occurring 'term_count' times in a quote with length factor 'norm'
+static double term_score(double idf, int term_count, double norm) {
+    return idf * term_count * (BM25_K1 + 1.0) / (term_count + norm);
+}
+
+// Decodes a posting list the index has no quote ID list for
+static int decode_term(const PostingList *postings, TermCursor *cursor, int *max_count) {
+    cursor->owned = (int *)malloc(2 * (postings->quote_count ? postings->quote_count : 1) * sizeof(int));
+    if (!cursor->owned) {
+        perror("Failed to decode postings");
+        return 0;
+    }
+    int *ids = cursor->owned, *counts = cursor->owned + postings->quote_count;
+    PostingIterator it;
+    posting_iterator_init(&it, postings);
+    while (posting_iterator_next(&it)) {
+        ids[cursor->count] = it.quote_id;
+        counts[cursor->count++] = it.term_count;
+        if (it.term_count > *max_count) *max_count = it.term_count;
+    }
+    cursor->ids = ids;
+    cursor->counts = counts;
+    return 1;
+}
+
+// Points the cursor at the quotes of the word (count 0 if it is not in the index)
+static int open_term(const QueryIndex *index, const char *word, TermCursor *cursor, int *max_count) {
+    memset(cursor, 0, sizeof(*cursor));
+    *max_count = 0;
+    if (index->snapshot) {
+        WordInfo view;
+        return search_snapshot(index->snapshot, word, &view) ? decode_term(&view.postings, cursor, max_count) : 1;
+    }
+    const int position = index->vector ? search_vector_position(index->vector, word) : -1;
+    if (position < 0) return 1;
+    const QuoteIdLists *lists = index->quote_ids;
+    if (!lists || lists->size != index->vector->size) {
+        return decode_term(&index->vector->words[position]->postings, cursor, max_count);
+    }
+    cursor->ids = lists->ids + lists->offsets[position];
+    cursor->counts = lists->counts + lists->offsets[position];
+    cursor->count = lists->offsets[position + 1] - lists->offsets[position];
+    *max_count = lists->max_counts[position];
+    return 1;
+}
+
+static int compare_upper_bounds(const void *a, const void *b) {
+    const TermCursor *x = (const TermCursor *)a, *y = (const TermCursor *)b;
+    return (x->upper_bound > y->upper_bound) - (x->upper_bound < y->upper_bound);
+}
+
+// Higher score first, then lower quote ID
+static int quote_ranks_before(const RankedQuote *a, const RankedQuote *b) {
+    if (a->score != b->score) return a->score > b->score;
+    return a->quote_id < b->quote_id;
+}
+
+static int compare_ranked_quotes(const void *a, const void *b) {
+    const RankedQuote *x = (const RankedQuote *)a, *y = (const RankedQuote *)b;
+    if (quote_ranks_before(x, y)) return -1;
+    return quote_ranks_before(y, x) ? 1 : 0;
+}
+
+// Bounded heap of the best k quotes, with the weakest at the root
+static void offer_quote(RankedQuote *heap, int *count, int k, RankedQuote quote) {
+    if (*count < k) {
+        int i = (*count)++;
+        while (i > 0 && quote_ranks_before(&heap[(i - 1) / 2], &quote)) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = quote;
+        return;
+    }
+    if (!quote_ranks_before(&quote, &heap[0])) return;
+    heap[0] = quote;
+    int i = 0;
+    for (;;) {
+        int weakest = i, left = 2 * i + 1, right = left + 1;
+        if (left < k && quote_ranks_before(&heap[weakest], &heap[left])) weakest = left;
+        if (right < k && quote_ranks_before(&heap[weakest], &heap[right])) weakest = right;
+        if (weakest == i) break;
+        RankedQuote tmp = heap[i]; heap[i] = heap[weakest]; heap[weakest] = tmp;
+        i = weakest;
+    }
+}
+
+int rank_quotes(const QueryIndex *index, const RankedQuery *query, int k, int prune, RankedQuote *out,
+                long *scored) {
+    if (scored) *scored = 0;
+    const QuotePool *pool = index->pool;
+    if (k <= 0 || !pool || pool->quote_count == 0 || pool->word_total == 0) return 0;
+
+    TermCursor *terms = (TermCursor *)calloc(query->word_count, sizeof(TermCursor));
+    double *bounds = (double *)malloc(query->word_count * sizeof(double));
+    if (!terms || !bounds) {
+        perror("Failed to evaluate ranked query");
+        free(terms);
+        free(bounds);
+        return -1;
+    }
+
+    // A quote holds at least as many words as the occurrences of one of them, and the score only
+    // falls as the quote grows, so a word's bound is its highest term count in the shortest quote
+    // that can hold it (raised a hair above the rounding of the sums it is compared with)
+    const double quotes = pool->quote_count;
+    const double average_length = (double)pool->word_total / pool->quote_count;
+    int ok = 1, term_count = 0;
+    for (int w = 0; w < query->word_count && ok; w++) {
+        int max_count;
+        TermCursor *term = &terms[term_count];
+        ok = open_term(index, query->words[w], term, &max_count);
+        if (!ok || term->count == 0) {
+            free(term->owned);
+            continue;
+        }
+        term->idf = log(1.0 + (quotes - term->count + 0.5) / (term->count + 0.5));
+        const double norm = BM25_K1 * (1.0 - BM25_B + BM25_B * max_count / average_length);
+        term->upper_bound = term_score(term->idf, max_count, norm) * (1.0 + 1e-9);
+        term_count++;
+    }
+
+    // Weakest words first; bounds[i] is what words 0..i can add together
+    qsort(terms, term_count, sizeof(TermCursor), compare_upper_bounds);
+    double sum = 0.0;
+    for (int t = 0; t < term_count; t++) {
+        sum += terms[t].upper_bound;
+        bounds[t] = sum;
+    }
+
+    // Quotes are visited in ID order, so a later quote with the k-th score ranks after it:
+    // one needs a score above the threshold to enter. Words whose bounds together stay within
+    // it cannot bring a quote in on their own, so only the others (the essential ones) choose
+    // the next quote.
+    int count = 0, essential = 0;
+    long postings = 0;
+    double threshold = 0.0;
+    while (ok && essential < term_count) {
+        int quote_id = INT_MAX;
+        for (int t = essential; t < term_count; t++) {
+            if (terms[t].at < terms[t].count && terms[t].ids[terms[t].at] < quote_id) {
+                quote_id = terms[t].ids[terms[t].at];
+            }
+        }
+        if (quote_id == INT_MAX) break;
+
+        const double norm = BM25_K1 * (1.0 - BM25_B + BM25_B * pool->quotes[quote_id].word_count / average_length);
+        double score = 0.0;
+        for (int t = essential; t < term_count; t++) {
+            TermCursor *term = &terms[t];
+            if (term->at < term->count && term->ids[term->at] == quote_id) {
+                score += term_score(term->idf, term->counts[term->at++], norm);
+                postings++;
+            }
+        }
+        // The strongest non-essential words first, while they can still lift the quote in
+        int t = essential - 1;
+        while (t >= 0 && score + bounds[t] > threshold) {
+            TermCursor *term = &terms[t];
+            term->at = gallop_quote_ids(term->ids, term->count, term->at, quote_id);
+            if (term->at < term->count && term->ids[term->at] == quote_id) {
+                score += term_score(term->idf, term->counts[term->at++], norm);
+                postings++;
+            }
+            t--;
+        }
+        if (t >= 0) continue;
+
+        RankedQuote quote = { quote_id, score };
+        offer_quote(out, &count, k, quote);
+        if (prune && count == k) {
+            threshold = out[0].score;
+            while (essential < term_count && bounds[essential] <= threshold) essential++;
+        }
+    }
+
+    for (int t = 0; t < term_count; t++) free(terms[t].owned);
+    free(terms);
+    free(bounds);
+    if (scored) *scored = postings;
+    if (!ok) return -1;
+    qsort(out, count, sizeof(RankedQuote), compare_ranked_quotes);
+    return count;
+}
@@ -0,0 +1,42 @@
+#ifndef RANKING_OPERATIONS_H
+#define RANKING_OPERATIONS_H
+
+#include "structures.h"
+#include "query_operations.h"
+
+// BM25 parameters: term count saturation and strength of the quote length normalization
+#define BM25_K1 1.2
+#define BM25_B 0.75
+
+// Distinct words of a ranked query
+typedef struct RankedQuery {
+  char **words;   // Normalized
+  int word_count;
+} RankedQuery;
+
+// A quote of a ranked result
+typedef struct RankedQuote {
+  int quote_id;
+  double score;
+} RankedQuote;
+
+// Tokenizes the query with the rules of the quotes and drops repeated words. Returns the
+// query, or NULL with a message in 'error' if it has no word that the index keeps.
+RankedQuery* parse_ranked_query(const char *text, char *error, int error_size);
+
+// Frees a parsed query.
+void free_ranked_query(RankedQuery *query);
+
+// Writes the k quotes with the highest BM25 score for the words into 'out', best first, ties
+// in quote ID order. A quote scores if it holds any of the words; its length is the number of
+// indexed words recorded at load time. The term counts come from the quote ID lists (decoded
+// from the postings when the index has none). With 'prune' the lists are walked MaxScore
+// style: each word has an upper bound on what it adds to a quote, and once the k-th score
+// passes the bounds of the weakest words, their lists are only probed, by galloping, for the
+// quotes the others find. Without it every posting is scored, the baseline. *scored (if not
+// NULL) receives the number of postings scored. Returns the number of quotes written, or -1
+// on allocation failure.
+int rank_quotes(const QueryIndex *index, const RankedQuery *query, int k, int prune, RankedQuote *out,
+                long *scored);
+
+#endif // RANKING_OPERATIONS_H
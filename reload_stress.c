@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "reload_stress.h"
+#include "query_engine.h"
+#include "utils.h"
+
+#define STRESS_TOP_K 10
+#define MAX_STRESS_READERS 64
+
+// One reader thread, querying whichever engine is current
+typedef struct StressReader {
+    EngineHandle *engines;
+    atomic_int *stop;
+    int expected_quotes;       // Every engine of the corpus has the same quotes
+    unsigned long long random_state;
+    long queries;
+    long errors;
+    long generations;          // Engines this reader has seen
+    double max_latency_ms;     // Longest enter..leave, queries included
+    int registered;
+    pthread_t thread;
+} StressReader;
+
+typedef struct ReloadTiming {
+    double build_ms;
+    double swap_us;
+    double reclaim_ms;
+} ReloadTiming;
+
+void init_reload_stress_options(ReloadStressOptions *options) {
+    memset(options, 0, sizeof(*options));
+    options->readers = 4;
+    options->reloads = 10;
+}
+
+int parse_reload_stress_option(int argc, char *argv[], int *i, ReloadStressOptions *options) {
+    const char *option = argv[*i];
+    if (strncmp(option, "--stress-", 9) != 0 || strcmp(option, "--stress-reload") == 0 || *i + 1 >= argc) {
+        return 0;
+    }
+
+    const char *value = argv[++*i];
+    int ok = 1;
+    if (strcmp(option, "--stress-readers") == 0) {
+        options->readers = atoi(value);
+        ok = options->readers > 0 && options->readers <= MAX_STRESS_READERS;
+    } else if (strcmp(option, "--stress-reloads") == 0) {
+        options->reloads = atoi(value);
+        ok = options->reloads > 0;
+    } else {
+        --*i;
+        return 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "Valor inválido para %s: '%s'.\n", option, value);
+        return -1;
+    }
+    return 1;
+}
+
+// Checks that the parts of the engine agree with each other. Returns the number of errors.
+static long check_engine(StressReader *reader, const Engine *engine, TopKEntry *top) {
+    const QueryIndex index = engine_query_index(engine);
+    const QueryStructure structure = engine->snapshot_open ? QUERY_SNAPSHOT : QUERY_HASH;
+    long errors = engine->pool.quote_count != reader->expected_quotes;
+
+    const int found = top_k_words(&index, STRESS_TOP_K, NULL, top);
+    if (found == 0 && engine->pool.quote_count > 0) errors++;
+    for (int i = 0; i < found; i++) {
+        WordInfo view;
+        const WordInfo *info = lookup_word(&index, structure, top[i].word, &view);
+        if (!info || info->frequency != top[i].frequency) errors++;
+    }
+
+    if (!engine->snapshot_open && engine->vector.size > 0) {
+        const WordInfo *word = engine->vector.words[next_random(&reader->random_state) % engine->vector.size];
+        if (lookup_word(&index, QUERY_HASH, word->word, NULL) != word) errors++;
+    }
+    return errors;
+}
+
+static void* reader_main(void *arg) {
+    StressReader *reader = (StressReader *)arg;
+    const int slot = register_engine_reader(reader->engines);
+    if (slot < 0) return NULL;
+    reader->registered = 1;
+
+    TopKEntry top[STRESS_TOP_K];
+    long last_generation = 0;
+    while (!atomic_load_explicit(reader->stop, memory_order_relaxed)) {
+        const uint64_t start = timer_start();
+        const Engine *engine = enter_engine(reader->engines, slot);
+        long generation = 0;
+        if (engine) {
+            reader->errors += check_engine(reader, engine, top);
+            generation = engine->generation;
+        } else {
+            reader->errors++;
+        }
+        leave_engine(reader->engines, slot);
+
+        const double latency = timer_stop(start);
+        if (latency > reader->max_latency_ms) reader->max_latency_ms = latency;
+        if (generation != last_generation) {
+            reader->generations++;
+            last_generation = generation;
+        }
+        reader->queries++;
+    }
+    unregister_engine_reader(reader->engines, slot);
+    return NULL;
+}
+
+int run_reload_stress(const ReloadStressOptions *options, const LoadOptions *load_options) {
+    EngineHandle *engines = (EngineHandle *)aligned_alloc(_Alignof(EngineHandle), sizeof(EngineHandle));
+    StressReader *readers = (StressReader *)calloc(options->readers, sizeof(StressReader));
+    ReloadTiming *timings = (ReloadTiming *)calloc(options->reloads, sizeof(ReloadTiming));
+    if (!engines || !readers || !timings) {
+        perror("Falha ao alocar o teste de recarga");
+        free(engines);
+        free(readers);
+        free(timings);
+        return 0;
+    }
+    init_engine_handle(engines);
+
+    EngineLoadReport report;
+    Engine *first = open_engine(options->corpus, load_options, &report);
+    if (!first) {
+        fprintf(stderr, "Falha ao carregar '%s'.\n", options->corpus);
+        destroy_engine_handle(engines);
+        free(engines);
+        free(readers);
+        free(timings);
+        return 0;
+    }
+    const int quotes = first->pool.quote_count;
+    const int words = first->snapshot_open ? (int)first->snapshot.header->word_count : first->vector.size;
+    publish_engine(engines, first);
+
+    printf("\n--- Teste de recarga de '%s' (%s, %d palavras, %d frases): %d leitor%s, %d recarga%s ---\n",
+           options->corpus, first->snapshot_open ? "snapshot" : "CSV", words, quotes, options->readers,
+           options->readers > 1 ? "es" : "", options->reloads, options->reloads > 1 ? "s" : "");
+
+    atomic_int stop;
+    atomic_init(&stop, 0);
+    int started = 0;
+    for (int r = 0; r < options->readers; r++) {
+        readers[r].engines = engines;
+        readers[r].stop = &stop;
+        readers[r].expected_quotes = quotes;
+        readers[r].random_state = 0x5EEDull + r;
+        if (pthread_create(&readers[r].thread, NULL, reader_main, &readers[r]) != 0) break;
+        started++;
+    }
+    int ok = started == options->readers;
+    if (!ok) perror("Falha ao iniciar os leitores");
+
+    // The readers never stop while the engines are replaced under them
+    int reloaded = 0;
+    const double start = wall_clock_ms();
+    for (int m = 0; ok && m < options->reloads; m++) {
+        const double build_start = wall_clock_ms();
+        Engine *fresh = open_engine(options->corpus, load_options, &report);
+        const double built = wall_clock_ms();
+        if (!fresh) {
+            fprintf(stderr, "Recarga %d falhou.\n", m + 1);
+            ok = 0;
+            break;
+        }
+        publish_engine(engines, fresh);
+        const double swapped = wall_clock_ms();
+        reclaim_engines(engines, 1);
+        timings[m].build_ms = built - build_start;
+        timings[m].swap_us = (swapped - built) * 1000.0;
+        timings[m].reclaim_ms = wall_clock_ms() - swapped;
+        reloaded++;
+    }
+    const double elapsed = wall_clock_ms() - start;
+    atomic_store(&stop, 1);
+
+    long queries = 0, errors = 0, generations_min = -1;
+    double max_latency = 0.0;
+    for (int r = 0; r < started; r++) {
+        pthread_join(readers[r].thread, NULL);
+        if (!readers[r].registered) ok = 0;
+        queries += readers[r].queries;
+        errors += readers[r].errors;
+        if (readers[r].max_latency_ms > max_latency) max_latency = readers[r].max_latency_ms;
+        if (generations_min < 0 || readers[r].generations < generations_min) generations_min = readers[r].generations;
+    }
+    const long generations = engines->generation;
+    destroy_engine_handle(engines);
+    const long freed = engines->reclaimed;
+
+    printf("%-8s %14s %12s %16s\n", "Recarga", "Montagem (ms)", "Troca (us)", "Liberação (ms)");
+    for (int m = 0; m < reloaded; m++) {
+        printf("%-8d %14.3f %12.1f %16.3f\n", m + 1, timings[m].build_ms, timings[m].swap_us, timings[m].reclaim_ms);
+    }
+    printf("\nConsultas dos leitores       : %ld em %.1f s (%.0f por segundo)\n", queries, elapsed / 1000.0,
+           elapsed > 0 ? queries / (elapsed / 1000.0) : 0.0);
+    printf("Maior latência de um leitor  : %.3f ms\n", max_latency);
+    printf("Índices vistos por leitor    : pelo menos %ld de %ld publicados\n",
+           generations_min < 0 ? 0 : generations_min, generations);
+    printf("Índices liberados            : %ld\n", freed);
+    printf("Erros de consistência        : %ld\n", errors);
+    if (errors > 0) ok = 0;
+
+    free(engines);
+    free(readers);
+    free(timings);
+    return ok;
+}
@@ -0,0 +1,28 @@
+#ifndef RELOAD_STRESS_H
+#define RELOAD_STRESS_H
+
+#include "file_parser.h"
+
+// Settings of the reload stress test (--stress-reload)
+typedef struct ReloadStressOptions {
+  const char *corpus;         // CSV or snapshot loaded again on every reload
+  int readers;                // Threads querying the engine the whole time
+  int reloads;                // Engines built and published while they run
+} ReloadStressOptions;
+
+// Fills in the defaults: 4 readers, 10 reloads.
+void init_reload_stress_options(ReloadStressOptions *options);
+
+// Consumes the stress test option at argv[*i] (and its value), advancing *i.
+// Returns 1 if it was one, 0 if not, -1 if its value is invalid.
+int parse_reload_stress_option(int argc, char *argv[], int *i, ReloadStressOptions *options);
+
+// Publishes an engine of the corpus, then reloads it over and over while the readers query
+// it without pause: top-K, then a lookup of every word found, whose frequency must agree, and
+// of a random word of the vector, which must lead to the same WordInfo. Prints the time of
+// each build, swap and reclamation, the queries per second, the worst reader latency and
+// the errors. Run under AddressSanitizer, a reader touching a freed engine aborts the test.
+// Returns 1 if every reload succeeded and no reader saw an error.
+int run_reload_stress(const ReloadStressOptions *options, const LoadOptions *load_options);
+
+#endif // RELOAD_STRESS_H
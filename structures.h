@@ -3,21 +3,52 @@
 
 // --- Basic Nodes ---
 
-// Structure to store information about where a word appears
-typedef struct CitationInfo {
-  char *quote;
-  char *movie;
-  int year;
-  struct CitationInfo *next; // Linked list for multiple occurrences in different quotes
-} CitationInfo;
+// Compressed list of the quotes a word appears in, by increasing quote ID.
+// Each quote is two LEB128 varints: the gap from the previous quote ID (the ID itself
+// for the first one) and the number of times the word occurs in that quote.
+// Movie and year are looked up in the QuotePool through the quote ID.
+typedef struct PostingList {
+  unsigned char *bytes;   // Arena memory
+  int length;             // Bytes in use
+  int capacity;
+  int quote_count;        // Distinct quotes
+  int last_quote;         // ID of the last quote, base of the next gap (-1 if empty)
+  int last_count;         // Term count of the last quote
+  int last_count_offset;  // Where that count is encoded, so a repeat only rewrites the tail
+} PostingList;
+
+// Position of a walk over a PostingList
+typedef struct PostingIterator {
+  const unsigned char *cursor;
+  const unsigned char *end;
+  int quote_id;           // Current quote
+  int term_count;         // Occurrences of the word in it
+} PostingIterator;
+
+// Token positions of a word, recorded only when the index is loaded with positions.
+// Follows the postings: for each quote, its term count of varints, the first position
+// and then the gaps between consecutive positions. A position is the index of the token
+// among all tokens of the quote, so words too short to be indexed still take their place.
+typedef struct PositionList {
+  unsigned char *bytes;   // Arena memory (NULL when there are no positions)
+  int length;             // Bytes in use
+  int capacity;
+} PositionList;
 
 // Structure to store a unique word, its frequency, and list of citations
 typedef struct WordInfo {
   char *word;
-  int frequency;
-  CitationInfo *citations; // Head of the linked list of citations
+  int frequency;          // Sum of the term counts of the postings
+  PostingList postings;   // Quotes the word appears in
+  PositionList positions; // Where in those quotes; empty unless positions were recorded
 } WordInfo;
 
+// Called for each word a range query finds
+typedef void (*WordVisitor)(const WordInfo *info, void *context);
+
+// Called for each word a fuzzy search finds, with its edit distance from the query
+typedef void (*FuzzyVisitor)(const WordInfo *info, int distance, void *context);
+
 // --- Structure Nodes ---
 
 // Node for Binary Search Tree (BST)
@@ -35,14 +66,117 @@ typedef struct AVLNode {
   int height;
 } AVLNode;
 
-// Node for AVL Tree sorted by Frequency
+// Node for AVL Tree sorted by (frequency, word)
 typedef struct FreqAVLNode {
   WordInfo *data;          // Pointer to the shared WordInfo
   struct FreqAVLNode *left;
   struct FreqAVLNode *right;
   int height;
+  int size;                // Nodes in this subtree, for rank and select in O(log n)
 } FreqAVLNode;
 
+// Node of the radix tree (compressed trie) over the vocabulary. The edge into a node carries
+// a run of characters, so chains of single-child nodes collapse into one node.
+typedef struct RadixNode {
+  const char *label;           // Edge label: a view into one of the subtree's words at offset depth - label_length
+  WordInfo *data;              // Word that ends at this node (NULL if none)
+  struct RadixNode *children;  // child_count nodes, by decreasing max_frequency, then first label character
+  char *keys;                  // First label character of each child, scanned before touching the children
+  int label_length;
+  int depth;                   // Length of the path from the root, label included
+  int child_count;
+  int max_frequency;           // Highest frequency in the subtree, to rank completions without walking it
+  int word_count;              // Words in the subtree
+} RadixNode;
+
+// Every word sorted by (frequency, word), built once after the load.
+// Read from the end it lists the most frequent words first.
+typedef struct FreqOrder {
+  WordInfo **words;        // Pointers to the shared WordInfo
+  int size;
+} FreqOrder;
+
+// Occurrences of each word per year, indexed by frequency rank, with running totals so that
+// the occurrences in a range of years take two binary searches
+typedef struct YearCounts {
+  int *offsets;            // Entries of rank r are [offsets[r], offsets[r + 1])
+  int *years;              // Ascending within a word
+  int *cumulative;         // Occurrences in the word's quotes from years up to years[i]
+  int size;                // Words
+} YearCounts;
+
+// Quote IDs of every word decoded from its posting list, in the order of the sorted vector,
+// so that boolean queries can jump through them instead of decoding varints
+typedef struct QuoteIdLists {
+  int *ids;                // Ascending within a word
+  int *counts;             // Term count of the word in each of those quotes, for ranked search
+  int *offsets;            // IDs of the word at position r are [offsets[r], offsets[r + 1])
+  int *max_counts;         // Highest term count of each word
+  int size;                // Words
+} QuoteIdLists;
+
+// --- Hash Index ---
+
+// Slot of the open-addressing word table
+typedef struct HashSlot {
+  WordInfo *data;     // Pointer to the shared WordInfo
+  unsigned int hash;  // Full hash of the word, used as fingerprint (0 = empty slot)
+} HashSlot;
+
+// Robin Hood hash table over the shared WordInfo pointers
+typedef struct HashIndex {
+  HashSlot *slots;
+  int capacity;       // Power of two
+  int size;
+} HashIndex;
+
+// --- Read-Optimized Vector Layout ---
+
+// The sorted vocabulary in Eytzinger (BFS) order: the children of slot k are at 2k and 2k+1.
+// Slot 0 is unused so the arithmetic stays that simple.
+typedef struct EytzingerIndex {
+  unsigned long long *prefixes; // First 8 bytes of each word, big-endian, so integer order = word order
+  WordInfo **words;             // WordInfo of each slot, only read when prefixes tie
+  int size;
+} EytzingerIndex;
+
+// --- Input File ---
+
+// Contents of an input file, memory-mapped when possible (read into memory otherwise)
+typedef struct MappedFile {
+  char *data;
+  size_t size;
+  int is_mapped;  // 1 if data must be munmap'ed, 0 if it must be freed
+} MappedFile;
+
+// --- Quote Pool ---
+
+// A quote stored once per input line, shared by every citation of its words
+typedef struct QuoteEntry {
+  const char *text; // View into the pool's source file (not NUL-terminated)
+  int length;
+  int movie_id;     // Index of the movie title in the QuotePool
+  int year;
+  int word_count;   // Indexed words in the quote, repeats included: its length for ranked search
+} QuoteEntry;
+
+// Holds every quote and movie string; citations refer to entries by ID
+typedef struct QuotePool {
+  MappedFile source;     // File the quote views point into, released with the pool
+  MappedFile *appended;  // Files appended after the source, released with the pool
+  int appended_count;
+  struct Arena *strings; // Arena the movie titles are copied into
+  QuoteEntry *quotes;    // Indexed by quote ID
+  int quote_count;
+  int quote_capacity;
+  long long word_total;  // Sum of the word counts of the quotes
+  char **movies;         // Indexed by movie ID, each title stored once
+  int movie_count;
+  int movie_capacity;
+  int *movie_slots;      // Open-addressing table of movie IDs (-1 = empty)
+  int movie_slot_count;  // Power of two
+} QuotePool;
+
 // Structure to hold the dynamic array for binary search
 typedef struct WordVector {
   WordInfo **words; // Array of pointers to WordInfo
@@ -50,5 +184,38 @@ typedef struct WordVector {
   int capacity;     // Current allocated capacity
 } WordVector;
 
+// --- Bulk Loading ---
+
+// One (word, quote) pair gathered while parsing, before the vocabulary exists
+typedef struct WordOccurrence {
+  const char *word; // Normalized word: a view into the input, or scratch memory if it had to be folded
+  int length;       // The word is not NUL-terminated
+  int quote_id;
+  int position;     // Index of the token among all tokens of its quote
+  size_t seq;       // Position of the token in input order
+} WordOccurrence;
+
+// Growable list of occurrences, sorted once when parsing is done
+typedef struct OccurrenceList {
+  WordOccurrence *items;
+  size_t count;
+  size_t capacity;
+} OccurrenceList;
+
+// A word of one input chunk, before the chunks are merged into the WordVector
+typedef struct LocalWord {
+  const char *word;        // View of the word, not NUL-terminated
+  int length;
+  int frequency;
+  PostingList postings;    // Quote IDs are already global, so chunk lists can be concatenated
+  PositionList positions;  // Relative within each quote, so they are concatenated as they are
+} LocalWord;
+
+// Sorted vocabulary of one input chunk
+typedef struct LocalVocabulary {
+  LocalWord *words;
+  int size;
+  WordInfo **merged;       // WordInfo each local word ended up in, filled by the merge
+} LocalVocabulary;
 
 #endif // STRUCTURES_H
\ No newline at end of file
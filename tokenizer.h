@@ -0,0 +1,48 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stddef.h>
+
+// Bytes that separate the words of a quote
+#define TOKEN_DELIMITERS " .,!?;:()[]{}-_\t\n\r"
+
+// Extra bytes the scratch buffer needs past the input length (letters are copied in fixed-size moves)
+#define TOKENIZER_SCRATCH_SLACK 32
+
+// A normalized word found by the tokenizer
+typedef struct Token {
+  const char *text; // Into the input if the word was already normalized, into the scratch buffer otherwise
+  int length;       // The word is not NUL-terminated
+  int folded;       // 1 if text points into the scratch buffer
+  int position;     // Index of the token among all tokens of the text, dropped ones included
+} Token;
+
+// Splits the text at TOKEN_DELIMITERS and normalizes every token with the rules of
+// normalize_word (letters only, lowercase, more than 3 characters); shorter tokens are dropped,
+// but still count for the positions of the ones after them.
+// 'scratch' must hold length + TOKENIZER_SCRATCH_SLACK bytes and 'tokens' room for
+// length / 4 + 1 entries; both can be reused between calls.
+// Returns the number of tokens written.
+typedef int (*TokenizeFunction)(const char *text, int length, char *scratch, Token *tokens);
+
+// Byte-at-a-time reference implementation.
+int tokenize_fold_scalar(const char *text, int length, char *scratch, Token *tokens);
+
+// Vector implementations; NULL when not compiled for this target. The SSE2 one is not
+// faster than the scalar one and only runs in the benchmark.
+extern const TokenizeFunction tokenize_fold_sse2;
+extern const TokenizeFunction tokenize_fold_avx2;
+
+// The AVX2 implementation if the running CPU supports it, the scalar one otherwise; chosen
+// on first use.
+int tokenize_fold(const char *text, int length, char *scratch, Token *tokens);
+
+// Name of the implementation tokenize_fold dispatches to.
+const char* tokenizer_kernel_name();
+
+// Runs every kernel over the quotes of the file, checks that they produce exactly the
+// tokens of strtok + normalize_word, and prints throughput in bytes per cycle.
+// Returns 0 if all kernels agree, 1 otherwise.
+int run_tokenizer_benchmark(const char *filename);
+
+#endif // TOKENIZER_H
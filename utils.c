@@ -1,16 +1,46 @@
 #include "utils.h"
 #include <stdio.h> // Para getchar
+#include <time.h>
 
-clock_t timer_start() {
-  return clock();
+uint64_t monotonic_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
 }
 
-double timer_stop(clock_t start_time) {
-  clock_t end_time = clock();
-  return ((double)(end_time - start_time) * 1000.0) / CLOCKS_PER_SEC;
+uint64_t timer_start() {
+  return monotonic_ns();
+}
+
+double timer_stop(uint64_t start_time) {
+  return (monotonic_ns() - start_time) / 1000000.0;
+}
+
+double wall_clock_ms() {
+  return monotonic_ns() / 1000000.0;
+}
+
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+double percentile(const double *sorted, long count, double p) {
+  if (count == 0) return 0.0;
+  long rank = (long)(p * count + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > count) rank = count;
+  return sorted[rank - 1];
+}
+
+unsigned long long next_random(unsigned long long *state) {
+  unsigned long long z = (*state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
 }
 
 void clear_input_buffer() {
   int c;
   while ((c = getchar()) != '\n' && c != EOF);
-}
+}
\ No newline at end of file
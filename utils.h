@@ -1,13 +1,30 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <time.h>
+#include <stdint.h>
+
+// Nanoseconds from a monotonic clock (CLOCK_MONOTONIC); only differences are meaningful
+uint64_t monotonic_ns();
 
 // Gets the current high-resolution time
-clock_t timer_start();
+uint64_t timer_start();
+
+// Calculates the elapsed time in milliseconds, with nanosecond resolution
+double timer_stop(uint64_t start_time);
+
+// Wall-clock time in milliseconds from a monotonic clock.
+// Use it to time work spread over several threads, where clock() adds up CPU time.
+double wall_clock_ms();
+
+// qsort comparator for doubles in ascending order
+int compare_doubles(const void *a, const void *b);
+
+// Nearest-rank percentile (p in [0, 1]) of 'count' sorted values; 0 when there are none
+double percentile(const double *sorted, long count, double p);
 
-// Calculates the elapsed time in milliseconds
-double timer_stop(clock_t start_time);
+// SplitMix64: small, fast and good enough for synthetic data and query mixes. Each caller
+// keeps its own state, so threads do not share one.
+unsigned long long next_random(unsigned long long *state);
 
 // Helper to clear input buffer
 void clear_input_buffer();
@@ -3,11 +3,10 @@
 #include <string.h>
 #include <ctype.h>
 #include "word_processing.h"
+#include "posting_operations.h"
 
-// Normalizes a word: converts to lowercase, removes punctuation at start/end.
-// Keeps internal hyphens/apostrophes if needed.
-// Returns a new dynamically allocated string, or NULL if word is invalid/too short.
-char* normalize_word(const char *raw_word) {
+// Keeps only the letters of the word, in lowercase, if more than 'min_length' are left
+static char* normalize_letters(const char *raw_word, int min_length) {
     if (raw_word == NULL) return NULL;
 
     int len = strlen(raw_word);
@@ -28,7 +27,7 @@ char* normalize_word(const char *raw_word) {
     cleaned_word[k] = '\0'; // Null-terminate
 
     // Check length constraint AFTER cleaning
-    if (strlen(cleaned_word) <= 3) {
+    if (k <= min_length) {
         free(cleaned_word);
         return NULL; // Word is too short or became empty after cleaning
     }
@@ -36,79 +35,64 @@ char* normalize_word(const char *raw_word) {
     return cleaned_word;
 }
 
+// Normalizes a word: converts to lowercase, removes punctuation at start/end.
+// Keeps internal hyphens/apostrophes if needed.
+// Returns a new dynamically allocated string, or NULL if word is invalid/too short.
+char* normalize_word(const char *raw_word) {
+    return normalize_letters(raw_word, 3);
+}
+
+char* normalize_prefix(const char *raw_prefix) {
+    return normalize_letters(raw_prefix, 0);
+}
+
 // Creates a new WordInfo structure
-WordInfo* create_word_info(const char *word) {
-    WordInfo *newInfo = (WordInfo *)malloc(sizeof(WordInfo));
+WordInfo* create_word_info(const char *word, int length, IndexArena *arena) {
+    WordInfo *newInfo = (WordInfo *)arena_alloc(&arena->slabs[SLAB_WORDS], sizeof(WordInfo));
     if (!newInfo) {
         perror("Failed to allocate memory for WordInfo");
         return NULL;
     }
-    newInfo->word = strdup(word); // Duplicate the word string
+    newInfo->word = arena_strndup(&arena->slabs[SLAB_STRINGS], word, length); // Duplicate the word string
     if (!newInfo->word) {
          perror("Failed to duplicate word string");
-         free(newInfo);
-         return NULL;
+         return NULL; // The WordInfo slot is reclaimed with the arena
     }
     newInfo->frequency = 0; // Initial frequency will be set during insertion
-    newInfo->citations = NULL;
+    init_posting_list(&newInfo->postings, 0, &arena->slabs[SLAB_POSTINGS]); // Reserves nothing yet
+    init_position_list(&newInfo->positions, 0, &arena->slabs[SLAB_POSITIONS]);
     return newInfo;
 }
 
-// Creates a new CitationInfo structure
-CitationInfo* create_citation_info(const char *quote, const char *movie, int year) {
-    CitationInfo *newCitation = (CitationInfo *)malloc(sizeof(CitationInfo));
-    if (!newCitation) {
-        perror("Failed to allocate memory for CitationInfo");
-        return NULL;
-    }
-    // Duplicate strings to avoid issues with buffer overwrites
-    newCitation->quote = strdup(quote);
-    newCitation->movie = strdup(movie);
-    if (!newCitation->quote || !newCitation->movie) {
-        perror("Failed to duplicate citation strings");
-        free(newCitation->quote); // Free potentially allocated quote
-        free(newCitation->movie); // Free potentially allocated movie
-        free(newCitation);
-        return NULL;
-    }
-    newCitation->year = year;
-    newCitation->next = NULL;
-    return newCitation;
-}
-
-// Adds a citation to the beginning of the citation list for a word.
-void add_citation_to_word(WordInfo *wordInfo, const char *quote, const char *movie, int year) {
+// Adds an occurrence of the word in a quote to its posting list.
+// Quotes are added in input order, so a repeat within a quote only bumps its count.
+void add_citation_to_word(WordInfo *wordInfo, int quote_id, IndexArena *arena) {
     if (!wordInfo) return;
 
-    CitationInfo *newCitation = create_citation_info(quote, movie, year);
-    if (!newCitation) {
-        fprintf(stderr, "Warning: Failed to create citation info.\n");
-        return; // Failed to create citation, skip adding it
+    if (!add_posting(&wordInfo->postings, quote_id, &arena->slabs[SLAB_POSTINGS])) {
+        fprintf(stderr, "Warning: Failed to add citation.\n");
     }
-
-    // Add to the front of the list
-    newCitation->next = wordInfo->citations;
-    wordInfo->citations = newCitation;
 }
 
-// Frees the memory allocated for a CitationInfo linked list.
-void free_citation_list(CitationInfo *head) {
-    CitationInfo *current = head;
-    CitationInfo *next;
-    while (current != NULL) {
-        next = current->next;
-        free(current->quote);
-        free(current->movie);
-        free(current);
-        current = next;
-    }
-}
+// Two rows of the edit distance table, abandoned once a whole row is past max_distance
+int bounded_edit_distance(const char *word, const char *query, int length, int max_distance, int *rows) {
+    const int word_length = (int)strlen(word);
+    if (word_length - length > max_distance || length - word_length > max_distance) return max_distance + 1;
 
-// Frees the memory allocated for a WordInfo structure, including its citation list.
-void free_word_info(WordInfo *wordInfo) {
-    if (wordInfo) {
-        free(wordInfo->word);
-        free_citation_list(wordInfo->citations);
-        free(wordInfo);
+    int *previous = rows, *row = rows + length + 1;
+    for (int j = 0; j <= length; j++) previous[j] = j;
+    for (int i = 0; i < word_length; i++) {
+        row[0] = i + 1;
+        int best = row[0];
+        for (int j = 1; j <= length; j++) {
+            int cost = previous[j - 1] + (query[j - 1] != word[i]);
+            if (previous[j] + 1 < cost) cost = previous[j] + 1;
+            if (row[j - 1] + 1 < cost) cost = row[j - 1] + 1;
+            row[j] = cost;
+            if (cost < best) best = cost;
+        }
+        if (best > max_distance) return max_distance + 1;
+        int *swap = previous; previous = row; row = swap;
     }
-}
\ No newline at end of file
+    return previous[length] <= max_distance ? previous[length] : max_distance + 1;
+}
@@ -2,26 +2,29 @@
 #define WORD_PROCESSING_H
 
 #include "structures.h"
+#include "arena.h"
 
 // Normalizes a word: converts to lowercase, removes punctuation.
 // Returns a new dynamically allocated string, or NULL if word is invalid/too short.
 // The caller is responsible for freeing the returned string.
 char* normalize_word(const char *raw_word);
 
-// Creates a new WordInfo structure. Remember to free it later.
-WordInfo* create_word_info(const char *word);
+// Normalizes a prefix typed for autocompletion with the same rules as normalize_word,
+// but of any length. Returns a new dynamically allocated string, or NULL if nothing is left.
+char* normalize_prefix(const char *raw_prefix);
 
-// Creates a new CitationInfo structure. Remember to free it later.
-CitationInfo* create_citation_info(const char *quote, const char *movie, int year);
+// Creates a new WordInfo structure in the index arena for the first 'length' bytes of word.
+// It is freed together with the arena, never individually.
+WordInfo* create_word_info(const char *word, int length, IndexArena *arena);
 
-// Adds a citation to the beginning of the citation list for a word.
-void add_citation_to_word(WordInfo *wordInfo, const char *quote, const char *movie, int year);
+// Adds an occurrence of the word in a quote of the QuotePool to its posting list.
+// Quote IDs must not decrease between calls for the same word.
+void add_citation_to_word(WordInfo *wordInfo, int quote_id, IndexArena *arena);
 
-// Frees the memory allocated for a CitationInfo linked list.
-void free_citation_list(CitationInfo *head);
 
-// Frees the memory allocated for a WordInfo structure, including its citation list.
-void free_word_info(WordInfo *wordInfo);
+// Levenshtein distance between 'word' and the first 'length' characters of 'query', or
+// max_distance + 1 as soon as it is known to be larger. 'rows' needs room for 2 * (length + 1) ints.
+int bounded_edit_distance(const char *word, const char *query, int length, int max_distance, int *rows);
 
 
 #endif // WORD_PROCESSING_H
\ No newline at end of file